@@ -105,3 +105,56 @@ C_INTERFACE GenerateGraphObstacles(
 	*out_graph = G;
 	return OK;
 }
+
+C_INTERFACE GenerateGraphFromSeeds(
+	HF::RayTracer::EmbreeRayTracer* ray_tracer,
+	const float* start_points,
+	int num_start_points,
+	const float* spacing,
+	int MaxNodes,
+	float UpStep,
+	float UpSlope,
+	float DownStep,
+	float DownSlope,
+	int max_step_connections,
+	int min_connections,
+	int core_count,
+	const float* region,
+	int num_region_points,
+	const int* obstacle_ids,
+	const int* walkable_ids,
+	int num_obstacles,
+	int num_walkables,
+	Graph** out_graph
+) {
+	const auto start_vector = ConvertRawFloatArrayToPoints(start_points, num_start_points);
+	const std::array<double, 3> spacing_array{ spacing[0], spacing[1], spacing[2] };
+
+	const std::vector<int> obstacle_vector = MapToVector(num_obstacles, obstacle_ids);
+	const std::vector<int> walkable_vector = MapToVector(num_walkables, walkable_ids);
+
+	GraphGenerator GraphGen(*ray_tracer, obstacle_vector, walkable_vector);
+	for (int i = 0; i < num_region_points; i++)
+		GraphGen.bounds.polygon.push_back({ region[i * 2], region[i * 2 + 1] });
+
+	Graph* G = new Graph();
+	*G = GraphGen.BuildNetwork(
+		start_vector,
+		spacing_array,
+		MaxNodes,
+		UpStep,
+		UpSlope,
+		DownStep,
+		DownSlope,
+		max_step_connections,
+		min_connections,
+		core_count
+	);
+
+	if (G->Nodes().size() < 1) {
+		delete G;
+		return HF_STATUS::NO_GRAPH;
+	}
+	*out_graph = G;
+	return OK;
+}
@@ -223,6 +223,91 @@ C_INTERFACE GenerateGraphObstacles(
 	HF::SpatialStructures::Graph** out_graph
 );
 
+/*!
+	\brief		Construct a single graph by performing a breadth-first search of accessible space from several start points
+
+	\param		ray_tracer				Raytracer containing the geometry to use for graph generation.
+
+	\param		start_points			Array of start points for the graph generator to search from, with every
+										three floats being the x, y, and z coordinates of a point. The first point
+										above solid ground defines the spacing of every node, and the rest are moved
+										to the closest node to them. Points that aren't above solid ground are skipped.
+
+	\param		num_start_points		Number of points in `start_points`.
+
+	\param		spacing					Space between nodes for each step of the search.
+										Lower values will yield more nodes for a higher resolution graph.
+
+	\param		MaxNodes				Stop generation after this many nodes.
+										A value of -1 will generate an infinite amount of nodes.
+										Note that the final node count may be greater than this value.
+
+	\param		UpStep					Maximum height of a step the graph can traverse.
+										Any steps higher this will be considered inaccessible.
+
+	\param		UpSlope					Maximum upward slope the graph can traverse in degrees.
+										Any slopes steeper than this will be considered inaccessible.
+
+	\param		DownStep				Maximum step down the graph can traverse.
+										Any steps steeper than this will be considered inaccessible.
+
+	\param		DownSlope				The maximum downward slope the graph can traverse.
+										Any slopes steeper than this will be considered inaccessible.
+
+	\param		max_step_connection		Multiplier for number of children to generate for each node.
+										Increasing this value will increase the number of edges in the graph,
+										and as a result the amount of memory the algorithm requires.
+	
+	\param		min_connections			The required out-degree for a node to be valid and stored.
+										 This must be greater than 0 and equal or less than the total connections created from max_step_connections.
+										 Default is 1. A value of 8 when max_step_connections=1 would be a grid.
+
+	\param		core_count				Number of cores to use. -1 will use all available cores,
+										and 0 or 1 will run a serialized version of the algorithm.
+
+	\param		region					Array of the x and y coordinates of the vertices of a polygon, in order.
+										Nodes outside of this polygon will not be expanded, and start points outside
+										of it are skipped. May be null if `num_region_points` is 0.
+
+	\param		num_region_points		Number of vertices in `region`. If 0, nodes won't be limited to a region.
+	
+	\param		obstacle_ids			Array of geometry IDs to consider obstacles
+	\param		walkable_ids			Array of geometry IDs to consider as walkable surfaces
+	\param		num_obstacles			number of elements in `obstacle_ids`
+	\param		num_walkables			number of elements in `walkable_ids`
+
+	\param		out_graph				Address of a (\link HF::SpatialStructures::Graph \endlink *);
+										*out_graph will address heap-allocated memory to an initialized
+										\link HF::SpatialStructures::Graph \endlink on success.
+
+	\returns	\link HF_STATUS::OK \endlink if graph creation was successful.
+				\link HF_STATUS::NO_GRAPH \endlink if no start point was valid.
+
+	\details	Every start point is crawled at once with a single set of the nodes that have been found, so areas
+				reachable from more than one start point are only checked once.
+*/
+C_INTERFACE GenerateGraphFromSeeds(
+	HF::RayTracer::EmbreeRayTracer* ray_tracer,
+	const float* start_points,
+	int num_start_points,
+	const float* spacing,
+	int MaxNodes,
+	float UpStep,
+	float UpSlope,
+	float DownStep,
+	float DownSlope,
+	int max_step_connection,
+	int min_connections,
+	int core_count,
+	const float* region,
+	int num_region_points,
+	const int* obstacle_ids,
+	const int* walkable_ids,
+	int num_obstacles,
+	int num_walkables,
+	HF::SpatialStructures::Graph** out_graph
+);
+
 /**@}*/
 
 #endif /* ANALYSIS_C_H */
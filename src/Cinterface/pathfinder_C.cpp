@@ -111,6 +111,27 @@ C_INTERFACE CreatePaths(
 	return HF::Exceptions::HF_STATUS::OK;
 }
 
+C_INTERFACE BuildPathHierarchy(
+	HF::SpatialStructures::Graph* g,
+	float cluster_size,
+	const char* cost_type
+) {
+	try {
+		EnablePathHierarchy(*g, cluster_size, std::string(cost_type));
+	}
+	catch (HF::Exceptions::NoCost) {
+		return HF::Exceptions::HF_STATUS::NO_COST;
+	}
+	catch (std::out_of_range) {
+		return HF::Exceptions::HF_STATUS::OUT_OF_RANGE;
+	}
+	catch (...) {
+		return HF::Exceptions::HF_STATUS::GENERIC_ERROR;
+	}
+
+	return HF::Exceptions::HF_STATUS::OK;
+}
+
 /// <summary>
 /// Get the size of a path
 /// </summary>
@@ -217,6 +217,8 @@ namespace HF {
 	are updated to contain the number of nodes in the path, a pointer to the path itself, and a pointer to the
 	PathMembers it holds respectively. 
 
+	\remarks If BuildPathHierarchy was called on `g` for `cost_name`, the path is planned on its hierarchy.
+
 	\warning
 	The caller is responsible for deleting the path returned by out_path by calling DestroyPath
 	if this function completes successfully. Freeing the memory for a path will also free the memory
@@ -300,6 +302,8 @@ C_INTERFACE CreatePath(
 	\post 3) `out_sizes` will point to an array of integers containing the size of every path in `out_paths`.
 			Paths that could not be generated will have a size of 0.
 
+	\remarks If BuildPathHierarchy was called on `g` for `cost_name`, every path is planned on its hierarchy.
+
 	\warning
 	The caller is responsible for freeing all of the memory allocated in `out_paths` and `out_sizes`. The contents of
 	`out_path_members` will automatically be deleted when the path they belong to is deleted. Do not try
@@ -337,6 +341,31 @@ C_INTERFACE CreatePaths(
 	int num_paths
 );
 
+/*!
+	\brief		Build a hierarchy of clusters for a graph, and plan every later path on the graph with it.
+
+	\param		g				The graph to build the hierarchy for. Must be compressed.
+	\param		cluster_size	Length of the sides of the cube each cluster covers. Set to 0 to remove the
+								hierarchy, so paths search the whole graph again.
+	\param		cost_type		The name of the cost in `g` to build the hierarchy for. Set to an empty string
+								to use the cost `g` was constructed with.
+
+	\returns	`HF_STATUS::OK` The hierarchy was built and stored in `g`, or removed from it.
+	\returns	`HF_STATUS::NO_COST` `cost_type` is not an empty string or the key of a cost that already exists in `g`.
+	\returns	`HF_STATUS::OUT_OF_RANGE` `cluster_size` is negative.
+
+	\details	The hierarchy is stored in `g`, so CreatePath and CreatePaths use it for every later call with
+				the same `cost_type`. Paths found through the hierarchy may cost slightly more than the shortest
+				path. The hierarchy is discarded as soon as any edge or cost of `g` changes.
+
+	\see HF::Pathfinding::EnablePathHierarchy for details on how paths are planned on the hierarchy.
+*/
+C_INTERFACE BuildPathHierarchy(
+	HF::SpatialStructures::Graph* g,
+	float cluster_size,
+	const char* cost_type
+);
+
 /*!
 	\brief		Get the size of a path and a pointer to its path members
 
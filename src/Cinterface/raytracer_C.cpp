@@ -2,6 +2,7 @@
 #include <iostream>
 
 #include <embree_raytracer.h>
+#include <ray_batch.h>
 #include <meshinfo.h>
 #include <HFExceptions.h>
 #include <cinterface_utils.h>
@@ -68,6 +69,38 @@ C_INTERFACE CreateRaytracerMultiMesh(MeshInfo** meshes, int num_meshes, EmbreeRa
 }
 
 
+C_INTERFACE CreateRaytracerInstanced(MeshInfo** meshes, int num_meshes, EmbreeRayTracer** out_raytracer, bool use_precise)
+{
+	*out_raytracer = new EmbreeRayTracer(use_precise);
+	try {
+		// Copies of meshes are found across every mesh at once, so add them all together
+		vector<MeshInfo> mesh_vec;
+		for (int i = 0; i < num_meshes; i++)
+			mesh_vec.push_back(*(meshes[i]));
+
+		(*out_raytracer)->AddInstancedMeshes(mesh_vec, true);
+
+		// Update the IDs of the input meshes, just like AddMesh would
+		for (int i = 0; i < num_meshes; i++)
+			meshes[i]->meshid = mesh_vec[i].meshid;
+
+		return OK;
+	}
+	// Thrown if Embree is missing
+	catch (const HF::Exceptions::MissingDependency& e) {
+		if (*out_raytracer != NULL)
+			delete* out_raytracer;
+		return MISSING_DEPEND;
+	}
+	catch (const HF::Exceptions::InvalidOBJ& e) {
+		if (*out_raytracer != NULL)
+			delete* out_raytracer;
+		return INVALID_OBJ;
+	}
+	return GENERIC_ERROR;
+}
+
+
 C_INTERFACE AddMeshes(HF::RayTracer::EmbreeRayTracer* ERT, MeshInfo ** MI, int number_of_meshes)
 {
 	// Iterate through each input mesh, only committing the scene
@@ -104,10 +137,37 @@ C_INTERFACE CastSingleRayDistance(
 	int* out_meshid
 )
 {
-	ert->IntersectOutputArguments(origin, direction, *out_distance, *out_meshid);
+	ert->IntersectOutputArguments(origin, direction, *out_distance, *out_meshid, max_distance);
 	return HF::Exceptions::HF_STATUS::OK;
 }
 
+C_INTERFACE CastMultiHitRay(
+	HF::RayTracer::EmbreeRayTracer* ert,
+	const float* origin,
+	const float* direction,
+	int max_hits,
+	float max_distance,
+	int mesh_id,
+	float* out_distances,
+	int* out_meshids,
+	int* out_primids,
+	int* out_num_hits
+)
+{
+	*out_num_hits = 0;
+	if (max_hits <= 0) return HF::Exceptions::GENERIC_ERROR;
+
+	const auto hits = ert->IntersectAll<float>(origin, direction, max_hits, max_distance, mesh_id);
+	for (int i = 0; i < hits.size(); i++) {
+		out_distances[i] = hits[i].distance;
+		out_meshids[i] = hits[i].meshid;
+		out_primids[i] = hits[i].primid;
+	}
+
+	*out_num_hits = static_cast<int>(hits.size());
+	return OK;
+}
+
 C_INTERFACE CastRaysDistance(
 	HF::RayTracer::EmbreeRayTracer* ert,
 	float* origins,
@@ -118,73 +178,22 @@ C_INTERFACE CastRaysDistance(
 	RayResult** results_data
 )
 {
-	enum CastType {
-		ONE_ORIGIN,
-		ONE_DIRECTION,
-		MULTIPLE_RAY
-	};
-	CastType type;
-	if (num_origins == num_directions)
-		type = MULTIPLE_RAY;
-	else if (num_origins == 1 && num_directions > 1)
-		type = ONE_ORIGIN;
-	else if (num_origins > 1 && num_directions == 1)
-		type = ONE_DIRECTION;
-	else {
+	if (num_origins <= 0 || num_directions <= 0 || (num_origins != num_directions && num_origins != 1 && num_directions != 1)) {
 		fprintf(stderr, "[C++] Invalid input. num_origins = %d, num_directions = %d\n", num_origins, num_directions);
 		return HF::Exceptions::GENERIC_ERROR;
 	}
-	std::vector<RayResult>* output_results;
-
-	switch (type) {
-	case MULTIPLE_RAY:
-	{
-		auto origin_pts = ConvertRawFloatArrayToPoints(origins, num_origins);
-		auto direction_pts = ConvertRawFloatArrayToPoints(directions, num_directions);
-
-		output_results = new std::vector<RayResult>(num_origins);
-
-#pragma omp parallel for schedule(dynamic)
-		for (int i = 0; i < num_origins; i++) {
-			float out_distance = -1;
-			int out_id = -1;
-			if (ert->IntersectOutputArguments(origin_pts[i], direction_pts[i], out_distance, out_id))
-				(*output_results)[i].SetHit(origin_pts[i], direction_pts[i], out_distance, out_id);
-		}
-		break;
-	}
 
-	case ONE_ORIGIN:
-	{
-		std::array<float, 3> origin = { origins[0], origins[1], origins[2] };
-		auto direction_pts = ConvertRawFloatArrayToPoints(directions, num_directions);
-
-		output_results = new std::vector<RayResult>(num_origins);
-	#pragma omp parallel for schedule(dynamic)
-		for (int i = 0; i < num_directions; i++) {
-			float out_distance = -1; int out_id = -1;
-			if (ert->IntersectOutputArguments(origin, direction_pts[i], out_distance, out_id))
-				(*output_results)[i].SetHit(origin, direction_pts[i], out_distance, out_id);
-		}
-		break;
-	}
-	case ONE_DIRECTION:
-	{
-		std::array<float, 3> direction = { directions[0], directions[1], directions[2] };
-		auto origin_pts = ConvertRawFloatArrayToPoints(origins, num_origins);
-
-		output_results = new std::vector<RayResult>(num_origins);
-	#pragma omp parallel for schedule(dynamic)
-		for (int i = 0; i < num_origins; i++) {
-			float out_distance = -1; int out_id = -1;
-			if (ert->IntersectOutputArguments(origin_pts[i], direction, out_distance, out_id))
-				(*output_results)[i].SetHit(origin_pts[i], direction, out_distance, out_id);
+	// Cast every ray straight from the input arrays in batches
+	HF::RayTracer::RayBatch batch(origins, num_origins, directions, num_directions);
+	ert->IntersectBatch(batch);
 
-		}
-		break;
-	}
+	// Rays that missed have a distance and mesh ID of -1 in the batch, just like a default RayResult
+	std::vector<RayResult>* output_results = new std::vector<RayResult>(batch.size());
+	for (int i = 0; i < batch.size(); i++) {
+		(*output_results)[i].distance = batch.distance[i];
+		(*output_results)[i].meshid = batch.meshid[i];
 	}
-	
+
 	*out_results = output_results;
 	*results_data = output_results->data();
 	return OK;
@@ -270,11 +279,15 @@ C_INTERFACE CastMultipleDirectionsOneOrigin(EmbreeRayTracer* ert, const float* o
 
 C_INTERFACE CastOcclusionRays(EmbreeRayTracer* ert, const float* origins, const float* directions, int origin_size, int direction_size, float max_distance, bool* result_array)
 {
-	auto origin_array = ConvertRawFloatArrayToPoints(origins, origin_size);
-	auto direction_array = ConvertRawFloatArrayToPoints(directions, direction_size);
-	const auto results = ert->Occlusions(origin_array, direction_array, max_distance, true);
+	if (origin_size <= 0 || direction_size <= 0 || (origin_size != direction_size && origin_size != 1 && direction_size != 1)) {
+		fprintf(stderr, "[C++] Invalid input. origin_size = %d, direction_size = %d\n", origin_size, direction_size);
+		return HF::Exceptions::GENERIC_ERROR;
+	}
+
+	HF::RayTracer::RayBatch batch(origins, origin_size, directions, direction_size, max_distance);
+	ert->OccludedBatch(batch);
 
-	std::copy(results.begin(), results.end(), result_array);
+	std::copy(batch.occluded.begin(), batch.occluded.end(), result_array);
 	return OK;
 }
 
@@ -142,6 +142,30 @@ C_INTERFACE CreateRaytracerMultiMesh(
 	bool use_precise
 );
 
+/*!
+	\brief		 Create a new raytracer using several meshes, sharing the geometry of repeated meshes.
+
+	\param	meshes			The meshes to add to raytracer's BVH. Their IDs are updated to the IDs they
+							were added with.
+	\param num_meshes		Number of meshes in meshes
+	\param	out_raytracer	Output parameter for the new raytracer.
+	\param use_precise		If true, use a more precise but slower method of triangle intersections
+
+	\returns	HF_STATUS::MISSING_DEPEND if Embree's dll couldn't be found.
+				HF_STATUS::INVALID_OBJ if any mesh has no triangles.
+
+	\details	Meshes that only differ by a translation, such as repeated groups of an OBJ loaded
+				with GROUP_METHOD::BY_GROUP, are added as instances of a single prototype by
+				EmbreeRayTracer::AddInstancedMeshes. Rays hit the same meshes with the same IDs as
+				they would in a raytracer created by CreateRaytracerMultiMesh.
+*/
+C_INTERFACE CreateRaytracerInstanced(
+	HF::Geometry::MeshInfo<float> ** meshes,
+	int num_meshes,
+	HF::RayTracer::EmbreeRayTracer** out_raytracer,
+	bool use_precise
+);
+
 
 /*!
 	\brief Add a new mesh to a raytracer.
@@ -212,6 +236,8 @@ C_INTERFACE DestroyRayTracer(HF::RayTracer::EmbreeRayTracer* rt_to_destroy);
 			  HF::GENERIC_ERROR if the input parameters didn't meet at least one of the required cases below.
 
 	\remarks
+	Rays are cast in batches with EmbreeRayTracer::IntersectBatch.
+
 	<para> Can be cast in 3 configurations: </para>
 	
 	<list type="bullet">
@@ -321,7 +347,41 @@ C_INTERFACE CastSingleRayDistance(
 );
 
 /*!
-	\brief		Cast a single ray from the raytracer and receive a point in return. 
+	\brief		Cast a single ray and get every surface it crosses, sorted by distance.
+
+	\param	ert				The ray tracer to cast from.
+	\param	origin			The origin point to cast from.
+	\param	direction		The direction to cast the ray in.
+	\param	max_hits		Maximum number of hits to return. Only the closest hits are returned.
+	\param	max_distance	Maximum distance to record hits within. Set to -1 for infinite distance.
+	\param	mesh_id			Only record hits on the mesh with this ID. Set to -1 to record hits on every mesh.
+	\param	out_distances	Output array for the distance to every hit. Must have room for max_hits elements.
+	\param	out_meshids		Output array for the ID of the mesh of every hit. Must have room for max_hits elements.
+	\param	out_primids		Output array for the ID of the triangle of every hit. Must have room for max_hits elements.
+	\param	out_num_hits	Out parameter for the number of hits written to the output arrays.
+
+	\returns	HF_STATUS::OK on success.
+				HF_STATUS::GENERIC_ERROR if max_hits is not greater than zero.
+
+	\remarks	All hits are found in a single traversal with EmbreeRayTracer::IntersectAll.
+
+	\see	\ref raytracer_setup (how to create a BVH), \ref raytracer_teardown (how to destroy a BVH)
+*/
+C_INTERFACE CastMultiHitRay(
+	HF::RayTracer::EmbreeRayTracer* ert,
+	const float* origin,
+	const float* direction,
+	int max_hits,
+	float max_distance,
+	int mesh_id,
+	float* out_distances,
+	int* out_meshids,
+	int* out_primids,
+	int* out_num_hits
+);
+
+/*!
+	\brief		Cast a single ray from the raytracer and receive a point in return.
 
 	\param	ert		Raytracer to cast each ray from.
 	\param	x		x coordinate of the ray's origin. Will be set to the hit point's x coordinate if the ray something.
@@ -519,10 +579,12 @@ C_INTERFACE CastMultipleDirectionsOneOrigin(HF::RayTracer::EmbreeRayTracer* ert,
 	\param	max_distance	Maximum distance a ray can travel and still hit a target.
 	\param	result_array	Output array booleans
 
-	\returns		HF_STATUS::OK on completion
+	\returns		HF_STATUS::OK on completion.
+					HF::GENERIC_ERROR if origin_size or direction_size is zero, or they don't match and neither is equal to one.
 
 	\remarks	Occlusion rays are noticably faster than standard rays but are only capable of returning whether
-				they hit something or not. This makes them good for line of sight checks.
+				they hit something or not. This makes them good for line of sight checks. Rays are cast in batches
+				with EmbreeRayTracer::OccludedBatch.
 
 	\see	\ref mesh_setup (how to create a mesh), \ref mesh_teardown (how to destroy a mesh)
 	\see	\ref raytracer_setup (how to create a BVH), \ref raytracer_teardown (how to destroy a BVH)
@@ -0,0 +1,246 @@
+///
+/// \file		adaptive_graph.cpp
+/// \brief		Contains implementation for generating a graph whose spacing adapts to the geometry
+///
+///	\author		TBA
+///	\date		26 Jun 2020
+
+#define NOMINMAX
+#include <adaptive_graph.h>
+#include <graph.h>
+#include <Edge.h>
+#include <node.h>
+#include <robin_hood.h>
+
+#include <algorithm>
+#include <cmath>
+
+using HF::SpatialStructures::Graph;
+using HF::SpatialStructures::Node;
+using HF::SpatialStructures::NodeLattice;
+using HF::SpatialStructures::LatticeKey;
+using HF::SpatialStructures::EdgeSet;
+using HF::SpatialStructures::STEP;
+
+using std::vector;
+
+namespace HF::GraphGenerator {
+
+	/*! \brief An open node, and the heights of the ground in its cell that it covers. */
+	struct OpenNode {
+		real_t z;			///< Height of the node.
+		real_t tolerance;	///< Greatest distance from `z` that the ground in the cell can be at.
+	};
+
+	/*! \brief The open nodes of a single level, indexed by the column of their cell. */
+	struct OpenCells {
+		real_t width_x = 0;	///< Width of each cell on the x axis. This is the spacing of the level.
+		real_t width_y = 0;	///< Width of each cell on the y axis.
+
+		/// Open nodes in each column of cells. A column holds more than one node when there
+		/// are several floors above each other.
+		robin_hood::unordered_map<LatticeKey, vector<OpenNode>> columns;
+
+		/*!
+			\brief Get the column of the cell containing the x and y coordinates of a point.
+
+			\details
+			Each cell is centered on a node of the level. Points exactly halfway between two nodes
+			are in the cell of the node after them. The small offset keeps points on that boundary
+			in the same cell when their coordinates are rounded differently.
+		*/
+		inline LatticeKey Column(const real3& origin, real_t x, real_t y) const {
+			return LatticeKey{
+				static_cast<int64_t>(std::floor((x - origin[0]) / width_x + 0.5 + 1e-3)),
+				static_cast<int64_t>(std::floor((y - origin[1]) / width_y + 0.5 + 1e-3)),
+				0
+			};
+		}
+	};
+
+	/*!
+		\brief Check if a node has enough edges to every direction on flat enough ground to be kept at a coarse level.
+
+		\param node Node to check.
+		\param nodes Every node of the level `node` was generated on.
+		\param edges Edges of `node`.
+		\param steps Step type of every edge in `edges`.
+		\param num_directions Number of directions that the generator checks from each node.
+		\param spacing Spacing of the level.
+		\param max_deviation Greatest difference between the height changes to a pair of opposite neighbors.
+		\param out_tolerance Set to the greatest height difference between `node` and its neighbors.
+
+		\returns True if `node` is open.
+	*/
+	inline bool IsOpen(
+		const Node& node,
+		const vector<Node>& nodes,
+		const EdgeSet& edges,
+		const EdgeSet& steps,
+		int num_directions,
+		const real3& spacing,
+		real_t max_deviation,
+		real_t& out_tolerance)
+	{
+		if (edges.children.size() != num_directions) return false;
+
+		// Find the direction and height change of every edge
+		struct Neighbor { int64_t dx, dy; real_t dz; };
+		vector<Neighbor> neighbors(edges.children.size());
+		for (int k = 0; k < edges.children.size(); k++) {
+			if (steps.children[k].weight != STEP::NONE) return false;
+
+			const Node& child = nodes[edges.children[k].child];
+			neighbors[k] = Neighbor{
+				std::llround((child.x - node.x) / spacing[0]),
+				std::llround((child.y - node.y) / spacing[1]),
+				static_cast<real_t>(child.z) - node.z
+			};
+		}
+
+		// The ground must continue in a straight line through the node in every direction
+		out_tolerance = 0;
+		for (const auto& a : neighbors) {
+			const auto opposite = std::find_if(neighbors.begin(), neighbors.end(),
+				[&a](const Neighbor& b) { return b.dx == -a.dx && b.dy == -a.dy; });
+			if (opposite == neighbors.end() || std::abs(a.dz + opposite->dz) > max_deviation)
+				return false;
+
+			out_tolerance = std::max(out_tolerance, std::abs(a.dz));
+		}
+		return true;
+	}
+
+	Graph GenerateAdaptiveGraph(
+		GraphGenerator& gg,
+		const GeneratorSettings& settings,
+		int levels,
+		real_t max_deviation)
+	{
+		const GenerationBounds bounds = gg.bounds;
+		const vector<EdgeCost> edge_costs = gg.edge_costs;
+		const std::string step_cost = EdgeCostName(EdgeCost::STEP_TYPE);
+		gg.sink = nullptr;
+
+		// Every level shares the lattice of the start point
+		const optional_real3 start = gg.SetupParameters(settings);
+		if (!start) return Graph();
+		const real3 origin = *start;
+		const NodeLattice lattice(origin, { settings.spacing[0], settings.spacing[1], gg.params.precision.node_z });
+		const int num_directions = CreateDirecs(settings.max_step_connections).size();
+
+		// Check if a point is covered by an open node on any level coarser than `level`
+		vector<OpenCells> open(levels + 1);
+		auto covered = [&open, &origin, levels](real_t x, real_t y, real_t z, int level) {
+			for (int l = level + 1; l <= levels; l++) {
+				const auto column = open[l].columns.find(open[l].Column(origin, x, y));
+				if (column == open[l].columns.end()) continue;
+
+				for (const auto& node : column->second)
+					if (std::abs(z - node.z) <= node.tolerance) return true;
+			}
+			return false;
+		};
+
+		// Graph of every level, and whether each of its nodes was kept
+		vector<Graph> level_graphs(levels + 1);
+		vector<vector<char>> kept(levels + 1);
+
+		// ID of every kept node in the result, identified by its position on the finest lattice
+		robin_hood::unordered_map<LatticeKey, int> ids;
+		vector<Node> nodes;
+
+		gg.edge_costs = { EdgeCost::STEP_TYPE };
+		vector<real3> seeds{ origin };
+		for (int level = levels; level >= 0 && !seeds.empty(); level--) {
+			GeneratorSettings level_settings = settings;
+			level_settings.spacing[0] = std::ldexp(settings.spacing[0], level);
+			level_settings.spacing[1] = std::ldexp(settings.spacing[1], level);
+			gg.SetupParameters(level_settings);
+
+			// Don't expand nodes that are already covered by a coarser level
+			gg.bounds = bounds;
+			gg.bounds.filter = [&bounds, &covered, level](real_t x, real_t y, real_t z) {
+				return (!bounds.filter || bounds.filter(x, y, z)) && !covered(x, y, z, level);
+			};
+
+			Graph& g = level_graphs[level];
+			g = gg.CrawlFromSeeds(origin, seeds);
+			seeds.clear();
+			if (g.size() == 0) continue;
+
+			const vector<Node> level_nodes = g.Nodes();
+			const auto edges = g.GetEdges();
+			const auto steps = g.GetEdges(step_cost);
+			auto& level_open = open[level];
+			level_open.width_x = level_settings.spacing[0];
+			level_open.width_y = level_settings.spacing[1];
+
+			// Keep open nodes and nodes on the finest level. Every other node is crawled again on the
+			// next level. Nodes outside of the bounds are never expanded, so they're kept wherever they're found.
+			kept[level].resize(level_nodes.size(), false);
+			for (int i = 0; i < level_nodes.size(); i++) {
+				const Node& node = level_nodes[i];
+				if (covered(node.x, node.y, node.z, level)) continue;
+
+				real_t tolerance = 0;
+				if (level > 0 && IsOpen(node, level_nodes, edges[i], steps[i], num_directions, level_settings.spacing, max_deviation, tolerance))
+					level_open.columns[level_open.Column(origin, node.x, node.y)].push_back(OpenNode{ node.z, tolerance + max_deviation });
+				else if (level > 0 && bounds.Contains(node)) {
+					seeds.push_back(CastToReal3(node));
+					continue;
+				}
+
+				kept[level][i] = true;
+				if (ids.emplace(lattice.Key(node), static_cast<int>(nodes.size())).second)
+					nodes.push_back(node);
+			}
+		}
+
+		gg.bounds = bounds;
+		gg.edge_costs = edge_costs;
+		gg.spacing = settings.spacing;
+
+		if (nodes.empty()) return Graph();
+
+		// Keep each edge from the level where either of its nodes was kept, and connect it to
+		// the nodes kept at the same positions
+		vector<vector<std::pair<int, float>>> rows(nodes.size());
+		for (int level = levels; level >= 0; level--) {
+			const Graph& g = level_graphs[level];
+			if (g.size() == 0) continue;
+
+			const vector<Node> level_nodes = g.Nodes();
+			for (const auto& edge_set : g.GetEdges()) {
+				const auto parent = ids.find(lattice.Key(level_nodes[edge_set.parent]));
+				if (parent == ids.end()) continue;
+
+				for (const auto& edge : edge_set.children) {
+					if (!kept[level][edge_set.parent] && !kept[level][edge.child]) continue;
+
+					const auto child = ids.find(lattice.Key(level_nodes[edge.child]));
+					if (child != ids.end() && child->second != parent->second)
+						rows[parent->second].emplace_back(child->second, edge.weight);
+				}
+			}
+		}
+
+		// The same pair of positions may be connected on more than one level, so only keep the
+		// first edge between them
+		vector<int> outer_indices(nodes.size() + 1, 0), inner_indices;
+		vector<float> data;
+		for (int i = 0; i < nodes.size(); i++) {
+			auto& row = rows[i];
+			std::stable_sort(row.begin(), row.end(), [](const auto& a, const auto& b) { return a.first < b.first; });
+			for (int k = 0; k < row.size(); k++) {
+				if (k > 0 && row[k].first == row[k - 1].first) continue;
+				inner_indices.push_back(row[k].first);
+				data.push_back(row[k].second);
+			}
+			outer_indices[i + 1] = inner_indices.size();
+			vector<std::pair<int, float>>().swap(row);
+		}
+
+		return Graph(nodes, std::move(outer_indices), std::move(inner_indices), std::move(data));
+	}
+}
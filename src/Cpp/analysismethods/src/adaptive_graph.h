@@ -0,0 +1,54 @@
+///
+/// \file		adaptive_graph.h
+/// \brief		Contains definitions for generating a graph whose spacing adapts to the geometry
+///
+///	\author		TBA
+///	\date		26 Jun 2020
+
+#pragma once
+
+#include <graph_generator.h>
+
+namespace HF::GraphGenerator {
+
+	/*!
+		\brief Generate a graph with coarse spacing in open areas, and the full spacing only where it's needed.
+
+		\param gg Graph generator to use. Its `sink` is overwritten. Its `bounds` and `edge_costs` are
+				  used while crawling, then restored.
+		\param settings Settings of the graph. `spacing` is the spacing of the finest level.
+		\param levels Number of times the spacing of the finest level is doubled to get the coarsest level.
+					  If 0, the result is the same as calling BuildNetwork with `settings`.
+		\param max_deviation How far each pair of a node's opposite neighbors may deviate from a straight
+							 line through it before the node is checked again at a finer level.
+
+		\returns A compressed graph containing the nodes of every level, or an empty graph if the start
+				 point isn't over the ground.
+
+		\details
+		Each level doubles the spacing of the level below it on the x and y axes, so the nodes of every
+		level lie on the lattice of `settings` and cover it like the cells of a quadtree. The graph is
+		first generated at the coarsest level. A node is open if it has an edge in every direction, none
+		of its edges need a step, and the height of the ground changes by the same amount in opposite
+		directions within `max_deviation`. Open nodes are kept, and cover the cell of their level around
+		them. Every other node is a seed for the next level, which never expands nodes covered by a
+		coarser level. Every node that's reached on the finest level is kept.
+
+		Edges found on each level are kept if either of their nodes was kept on that level. The other
+		node is replaced by the node kept at the same position on another level, so the levels are
+		connected through the nodes that were crawled again. Edges to nodes that weren't kept on any level
+		are dropped.
+
+		\remarks
+		Only the default cost is generated. Obstacles smaller than the spacing of a level that lie between
+		the edges of an open node won't cause it to be checked again. Areas that a coarse level couldn't
+		reach, such as rooms behind doors narrower than its spacing, are generated by the first level that
+		does reach them.
+	*/
+	SpatialStructures::Graph GenerateAdaptiveGraph(
+		GraphGenerator& gg,
+		const GeneratorSettings& settings,
+		int levels,
+		real_t max_deviation = 0.05
+	);
+}
@@ -0,0 +1,123 @@
+///
+/// \file		concurrent_node_map.cpp
+/// \brief		Contains implementation for the <see cref="HF::GraphGenerator::ConcurrentMap">ConcurrentMap</see> class
+///
+///	\author		TBA
+///	\date		26 Jun 2020
+
+#include <concurrent_node_map.h>
+
+#include <thread>
+
+using HF::SpatialStructures::LatticeKey;
+using HF::SpatialStructures::LatticeEdgeKey;
+
+namespace HF::GraphGenerator {
+
+	template <typename key_type>
+	ConcurrentMap<key_type>::ConcurrentMap(size_t expected_size) {
+		Allocate(expected_size * 2);
+	}
+
+	template <typename key_type>
+	void ConcurrentMap<key_type>::Allocate(size_t min_capacity)
+	{
+		// Round capacity up to the next power of 2 so the hash can be masked
+		size_t new_capacity = 16;
+		while (new_capacity < min_capacity) new_capacity *= 2;
+
+		slots.reset(new Slot[new_capacity]);
+		capacity = new_capacity;
+		num_keys = 0;
+	}
+
+	template <typename key_type>
+	void ConcurrentMap<key_type>::Reserve(size_t additional_keys)
+	{
+		// Keep the load factor at or below 0.5 so probe sequences stay short
+		const size_t required_capacity = 2 * (size() + additional_keys);
+		if (required_capacity <= capacity) return;
+
+		// Move the old slots out of the way then allocate new ones
+		auto old_slots = std::move(slots);
+		const size_t old_capacity = capacity;
+		Allocate(required_capacity);
+
+		// Reinsert every key that was in the old slots
+		for (size_t i = 0; i < old_capacity; i++) {
+			const Slot& old_slot = old_slots[i];
+			if (old_slot.state.load(std::memory_order_relaxed) == FULL)
+				Insert(old_slot.key, old_slot.value.load(std::memory_order_relaxed));
+		}
+	}
+
+	template <typename key_type>
+	std::atomic<int64_t>* ConcurrentMap<key_type>::Insert(const key_type& key, int64_t value)
+	{
+		const size_t mask = capacity - 1;
+		size_t index = std::hash<key_type>()(key) & mask;
+
+		while (true) {
+			Slot& slot = slots[index];
+			uint8_t state = slot.state.load(std::memory_order_acquire);
+
+			// Try to claim this slot if it's empty. If another thread claims it first
+			// then state will be updated to whatever it set the slot to.
+			if (state == EMPTY) {
+				if (slot.state.compare_exchange_strong(state, BUSY, std::memory_order_acq_rel)) {
+					slot.key = key;
+					slot.value.store(value, std::memory_order_relaxed);
+					slot.state.store(FULL, std::memory_order_release);
+
+					num_keys.fetch_add(1, std::memory_order_relaxed);
+					return &slot.value;
+				}
+			}
+
+			// Wait for the thread that claimed this slot to finish writing its key
+			while (state == BUSY) {
+				std::this_thread::yield();
+				state = slot.state.load(std::memory_order_acquire);
+			}
+
+			// If the key in this slot is the key we're looking for, then it's already been inserted
+			if (slot.key == key) return &slot.value;
+
+			// Otherwise move on to the next slot
+			index = (index + 1) & mask;
+		}
+	}
+
+	template <typename key_type>
+	std::atomic<int64_t>* ConcurrentMap<key_type>::Find(const key_type& key) const
+	{
+		const size_t mask = capacity - 1;
+		size_t index = std::hash<key_type>()(key) & mask;
+
+		while (true) {
+			Slot& slot = slots[index];
+			uint8_t state = slot.state.load(std::memory_order_acquire);
+
+			// An empty slot means the key would have been inserted here
+			if (state == EMPTY) return nullptr;
+
+			while (state == BUSY) {
+				std::this_thread::yield();
+				state = slot.state.load(std::memory_order_acquire);
+			}
+
+			if (slot.key == key) return &slot.value;
+
+			index = (index + 1) & mask;
+		}
+	}
+
+	template <typename key_type>
+	size_t ConcurrentMap<key_type>::size() const { return num_keys.load(std::memory_order_relaxed); }
+
+	template <typename key_type>
+	void ConcurrentMap<key_type>::Clear() { Allocate(capacity); }
+}
+
+template class HF::GraphGenerator::ConcurrentMap<LatticeKey>;
+template class HF::GraphGenerator::ConcurrentMap<LatticeEdgeKey>;
@@ -0,0 +1,120 @@
+///
+/// \file		concurrent_node_map.h
+/// \brief		Contains definitions for the <see cref="HF::GraphGenerator::ConcurrentMap">ConcurrentMap</see> class
+///
+///	\author		TBA
+///	\date		26 Jun 2020
+
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <node.h>
+
+namespace HF::GraphGenerator {
+
+	/*!
+		\brief A hashmap from keys to integers that can be inserted into from multiple threads at once.
+
+		\tparam key_type Type of key to store. Must be default constructible, comparable with ==, and
+				have a specialization of std::hash. Only instantiated for LatticeKey and LatticeEdgeKey.
+
+		\details
+		Uses open addressing with linear probing. Each slot is claimed by a single thread with an atomic
+		compare and swap, after which the slot's key is immutable. Values are stored as atomics so any
+		thread can update them after insertion.
+
+		\invariant The map is never more than half full after a call to Reserve(), so inserting at most
+		the reserved number of nodes will always find an empty slot.
+
+		\remarks
+		This is used by the parallel graph generator to deduplicate children from every parent in a frontier
+		at once, replacing the serial pass through a UniqueQueue, and by CrawlCache to share the
+		results of rays between parents.
+
+		\warning Reserve() and Clear() are NOT thread safe and must not be called while other threads are
+		inserting into or reading from the map.
+	*/
+	template <typename key_type>
+	class ConcurrentMap {
+	private:
+		/*! \brief States a slot can be in. */
+		enum SLOT_STATE : uint8_t {
+			EMPTY = 0, ///< No key has been inserted into this slot.
+			BUSY = 1,  ///< A thread has claimed this slot and is writing its key.
+			FULL = 2   ///< This slot's key has been written and will never change.
+		};
+
+		/*! \brief A single entry in the map. */
+		struct Slot {
+			std::atomic<uint8_t> state{ EMPTY };	///< Current state of this slot.
+			key_type key;							///< Key in this slot.
+			std::atomic<int64_t> value{ 0 };		///< Value associated with the key in this slot.
+		};
+
+		std::unique_ptr<Slot[]> slots;		///< Slots of the hashmap. Size is always a power of 2.
+		size_t capacity = 0;				///< Number of slots in `slots`.
+		std::atomic<size_t> num_keys{ 0 };	///< Number of keys that have been inserted into the map.
+
+		/*! \brief Allocate a new array of empty slots with a capacity of at least `min_capacity`. */
+		void Allocate(size_t min_capacity);
+
+	public:
+		/*!
+			\brief Create a new map with space for at least `expected_size` keys.
+
+			\param expected_size Number of keys to reserve space for.
+		*/
+		ConcurrentMap(size_t expected_size = 1024);
+
+		/*!
+			\brief Ensure that at least `additional_keys` more keys can be inserted without exceeding
+			the map's maximum load.
+
+			\param additional_keys Number of keys that may be inserted before the next call to reserve.
+
+			\post If the map was resized, all existing keys and values will have been moved into the new
+			slots. Any pointers previously returned by Insert or Find will be invalidated.
+
+			\warning Not thread safe.
+		*/
+		void Reserve(size_t additional_keys);
+
+		/*!
+			\brief Insert a key into the map if it doesn't already exist.
+
+			\param key Key to insert.
+			\param value Value to assign to `key` if it wasn't already in the map.
+
+			\returns A pointer to the value associated with `key`. This will be `value` if the key
+			was inserted by this call, or the existing value otherwise.
+
+			\pre Reserve must have been called with enough space for this key.
+
+			\remarks Thread safe. If multiple threads try to insert the same key, only one of them will
+			insert it and the rest will receive a pointer to the same value.
+		*/
+		std::atomic<int64_t>* Insert(const key_type& key, int64_t value);
+
+		/*!
+			\brief Get the value associated with a key.
+
+			\param key Key to look for.
+
+			\returns A pointer to the value associated with `key` or nullptr if `key` isn't in the map.
+
+			\remarks Thread safe.
+		*/
+		std::atomic<int64_t>* Find(const key_type& key) const;
+
+		/*! \brief Get the number of keys in the map. */
+		size_t size() const;
+
+		/*! \brief Remove every key from the map. \warning Not thread safe. */
+		void Clear();
+	};
+
+	/*! \brief A ConcurrentMap of nodes identified by their LatticeKeys. */
+	using ConcurrentNodeMap = ConcurrentMap<HF::SpatialStructures::LatticeKey>;
+}
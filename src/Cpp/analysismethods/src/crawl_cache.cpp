@@ -0,0 +1,98 @@
+///
+/// \file		crawl_cache.cpp
+/// \brief		Contains implementation for the <see cref="HF::GraphGenerator::CrawlCache">CrawlCache</see> class
+///
+///	\author		TBA
+///	\date		26 Jun 2020
+
+#include <crawl_cache.h>
+
+#include <cstring>
+
+using HF::SpatialStructures::LatticeKey;
+using HF::SpatialStructures::LatticeEdgeKey;
+using HF::SpatialStructures::NodeLattice;
+
+namespace HF::GraphGenerator {
+
+	/*! \brief Store the bits of a double in an int64 so it can be held by a ConcurrentNodeMap. */
+	inline int64_t ToBits(double d) {
+		int64_t bits;
+		std::memcpy(&bits, &d, sizeof(double));
+		return bits;
+	}
+
+	/*! \brief Get a double back from bits stored by ToBits. */
+	inline double FromBits(int64_t bits) {
+		double d;
+		std::memcpy(&d, &bits, sizeof(double));
+		return d;
+	}
+
+	CrawlCache::CrawlCache(const NodeLattice& lattice) : lattice(lattice) {}
+
+	const NodeLattice& CrawlCache::Lattice() const { return lattice; }
+
+	void CrawlCache::Reserve(size_t num_rays)
+	{
+		floors[current_floors].Reserve(num_rays);
+		connections[current].Reserve(num_rays);
+	}
+
+	bool CrawlCache::FindFloor(const LatticeKey& key, double& out_z) const
+	{
+		// Check the newest level first, since most floors are shared by parents of the same level
+		for (int i = 0; i < 3; i++) {
+			const auto value = floors[(current_floors + 3 - i) % 3].Find(key);
+			if (!value) continue;
+
+			out_z = FromBits(value->load(std::memory_order_relaxed));
+			return true;
+		}
+		return false;
+	}
+
+	void CrawlCache::InsertFloor(const LatticeKey& key, double z)
+	{
+		floors[current_floors].Insert(key, ToBits(z));
+	}
+
+	size_t CrawlCache::NumFloors() const { return floors[0].size() + floors[1].size() + floors[2].size(); }
+
+	LatticeEdgeKey CrawlCache::ConnectionKey(const std::array<double, 3>& parent, const std::array<double, 3>& child) const
+	{
+		return LatticeEdgeKey(
+			lattice.Key(parent[0], parent[1], parent[2]),
+			lattice.Key(child[0], child[1], child[2])
+		);
+	}
+
+	bool CrawlCache::FindConnection(const LatticeEdgeKey& key, ConnectionRays& out_rays) const
+	{
+		const auto value = connections[1 - current].Find(key);
+		if (!value) return false;
+
+		// The line of sight result is in the low byte, the step result in the next
+		const int64_t bits = value->load(std::memory_order_relaxed);
+		out_rays.line_of_sight = static_cast<RAY_RESULT>(bits & 0xFF);
+		out_rays.step = static_cast<RAY_RESULT>((bits >> 8) & 0xFF);
+		return true;
+	}
+
+	void CrawlCache::InsertConnection(const LatticeEdgeKey& key, const ConnectionRays& rays)
+	{
+		const int64_t bits = static_cast<int64_t>(rays.line_of_sight) | (static_cast<int64_t>(rays.step) << 8);
+		connections[current].Insert(key, bits);
+	}
+
+	size_t CrawlCache::NumConnections() const { return connections[current].size(); }
+
+	void CrawlCache::NextLevel()
+	{
+		current = 1 - current;
+		connections[current].Clear();
+
+		current_floors = (current_floors + 1) % 3;
+		floors[current_floors].Clear();
+	}
+}
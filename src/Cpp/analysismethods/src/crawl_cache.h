@@ -0,0 +1,165 @@
+///
+/// \file		crawl_cache.h
+/// \brief		Contains definitions for the <see cref="HF::GraphGenerator::CrawlCache">CrawlCache</see> class
+///
+///	\author		TBA
+///	\date		26 Jun 2020
+
+#pragma once
+
+#include <concurrent_node_map.h>
+#include <node.h>
+#include <array>
+
+namespace HF::GraphGenerator {
+
+	/*! \brief Result of a ray stored in a CrawlCache. */
+	enum class RAY_RESULT : uint8_t {
+		UNKNOWN = 0,	///< The ray hasn't been cast.
+		CLEAR = 1,		///< The ray wasn't occluded.
+		OCCLUDED = 2	///< The ray was occluded.
+	};
+
+	/*! 
+		\brief The rays cast to determine the connection between a pair of nodes.
+		
+		\details
+		Both rays are the same whichever node is the parent, so they can be reused to check the
+		connection in the opposite direction.
+	*/
+	struct ConnectionRays {
+		/// Line of sight between both nodes after they've been offset from the ground.
+		RAY_RESULT line_of_sight = RAY_RESULT::UNKNOWN;
+
+		/*!
+			Ray from the lower node raised by the step height to the higher node. Only stored when
+			the upstep and downstep limits are equal, since otherwise the step down from one node
+			and the step up from the other are different rays.
+		*/
+		RAY_RESULT step = RAY_RESULT::UNKNOWN;
+	};
+
+	/*!
+		\brief Results of rays cast during a single run of the graph generator, shared between parents.
+
+		\details
+		In a grid crawl every potential child is generated by up to 8 different parents, each of which
+		would cast the same ray straight down from it. The first parent to cast the ray stores the
+		height of the floor it hit here, keyed by the position of the ray's origin on the generator's
+		lattice, and every later parent reuses it.
+
+		Every connection is also checked twice, once from each of its nodes. The rays cast for each
+		pair of nodes are stored so the reverse connection can be derived without casting them again.
+		Only results from the previous level of the search are read, so the graph doesn't depend on
+		the order that parents within a level are checked in, and only two levels of connections are
+		kept at a time.
+
+		Floors are kept for three levels. A child can be up to one level behind its parent, and its
+		floor was found a level before that, when it was first checked as a child. Older floors are
+		discarded so the cache grows with the width of the search instead of the size of the graph.
+
+		\remarks
+		Floor results are stored after they've been filtered by the generator's geometry rules and
+		rounded to its z precision, so a cache must only be used for a single set of GraphParams.
+
+		\warning Reserve() is NOT thread safe. Everything else is.
+	*/
+	class CrawlCache {
+	private:
+		HF::SpatialStructures::NodeLattice lattice; ///< Lattice used to convert ray origins to keys.
+		ConcurrentNodeMap floors[3]; ///< Height of the floor under each origin stored as the bits of a double, for the last three levels.
+		ConcurrentMap<HF::SpatialStructures::LatticeEdgeKey> connections[2]; ///< Connection rays of the current and previous levels.
+		int current = 0; ///< Index of the current level in `connections`.
+		int current_floors = 0; ///< Index of the current level in `floors`.
+
+	public:
+		/*!
+			\brief Create an empty cache.
+
+			\param lattice Lattice that the origins of rays will be snapped to. Rays with origins that
+							snap to the same point on this lattice are considered the same ray.
+		*/
+		CrawlCache(const HF::SpatialStructures::NodeLattice& lattice);
+
+		/*! \brief Get the lattice used to identify rays in this cache. */
+		const HF::SpatialStructures::NodeLattice& Lattice() const;
+
+		/*!
+			\brief Ensure that at least `num_rays` more floor and connection results can be inserted into the cache.
+
+			\param num_rays Maximum number of results of each kind that will be inserted before the next call to Reserve.
+
+			\warning Not thread safe.
+		*/
+		void Reserve(size_t num_rays);
+
+		/*!
+			\brief Get the floor under a ray origin if it has already been found.
+
+			\param key Key of the ray's origin on this cache's lattice.
+			\param out_z Set to the height of the floor under the origin, or NAN if there is no
+						 valid floor under it.
+
+			\returns True if a result for `key` was in the cache, false otherwise.
+		*/
+		bool FindFloor(const HF::SpatialStructures::LatticeKey& key, double& out_z) const;
+
+		/*!
+			\brief Store the floor under a ray origin.
+
+			\param key Key of the ray's origin on this cache's lattice.
+			\param z Height of the floor under the origin, or NAN if there was no valid floor under it.
+
+			\pre Reserve was called with enough space for this result.
+
+			\remarks If a result for `key` was already stored it is kept.
+		*/
+		void InsertFloor(const HF::SpatialStructures::LatticeKey& key, double z);
+
+		/*! \brief Get the number of floor results in the cache, across every level that's kept. */
+		size_t NumFloors() const;
+
+		/*!
+			\brief Get the key of the connection between two nodes.
+
+			\returns A key that's the same regardless of which node is the parent.
+		*/
+		HF::SpatialStructures::LatticeEdgeKey ConnectionKey(
+			const std::array<double, 3>& parent,
+			const std::array<double, 3>& child
+		) const;
+
+		/*!
+			\brief Get the rays cast for a connection during the previous level of the search.
+
+			\param key Key of the connection from ConnectionKey.
+			\param out_rays Set to the rays that were cast for this connection.
+
+			\returns True if the connection was checked during the previous level, false otherwise.
+		*/
+		bool FindConnection(const HF::SpatialStructures::LatticeEdgeKey& key, ConnectionRays& out_rays) const;
+
+		/*!
+			\brief Store the rays cast for a connection during the current level of the search.
+
+			\param key Key of the connection from ConnectionKey.
+			\param rays Rays that were cast for this connection.
+
+			\pre Reserve was called with enough space for this result.
+		*/
+		void InsertConnection(const HF::SpatialStructures::LatticeEdgeKey& key, const ConnectionRays& rays);
+
+		/*! \brief Get the number of connections stored during the current level. */
+		size_t NumConnections() const;
+
+		/*!
+			\brief Start the next level of the search.
+
+			\post Connections stored during the current level can be found with FindConnection. Those
+			from the previous level are discarded, along with floors stored three levels ago.
+
+			\warning Not thread safe.
+		*/
+		void NextLevel();
+	};
+}
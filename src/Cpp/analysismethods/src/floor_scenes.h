@@ -0,0 +1,70 @@
+///
+/// \file		floor_scenes.h
+/// \brief		Contains definitions for the <see cref="HF::GraphGenerator::FloorScenes">FloorScenes</see> struct
+///
+///	\author		TBA
+///	\date		26 Jun 2020
+
+#pragma once
+
+#include <graph_generator.h>
+#include <embree_raytracer.h>
+#include <vector>
+
+namespace HF::GraphGenerator {
+
+	/*!
+		\brief The walkable geometry of an EmbreeRayTracer in one scene, and every other mesh in another.
+
+		\details
+		In GeometryFilterMode::OBSTACLES_AND_FLOORS a ray cast for the floor beneath a node only succeeds
+		if the first mesh it hits is walkable. Instead of finding the nearest hit in the entire scene, the
+		nearest floor is found in `floors`, then an occlusion ray cast in `others` checks for anything between
+		the origin and that floor. Floor rays that miss every walkable mesh never traverse the other meshes,
+		and the rest only need to find any hit before the floor.
+
+		\remarks
+		Both scenes share their geometry with the raytracer they were created from, but are only committed
+		when created. If meshes are added, edited or removed in the raytracer afterwards, IsStale returns
+		true and these need to be created again.
+
+		\see EmbreeRayTracer::Subset
+	*/
+	struct FloorScenes {
+		HF::RayTracer::EmbreeRayTracer source;	///< Raytracer the scenes were split from.
+		std::vector<int> walkable_ids;			///< IDs of the meshes that may be walkable.
+		unsigned int version;					///< SceneVersion of `source` when the scenes were split.
+		HF::RayTracer::EmbreeRayTracer floors;	///< Every walkable mesh.
+		HF::RayTracer::EmbreeRayTracer others;	///< Every mesh that isn't walkable, including meshes without a flag.
+
+		/*!
+			\brief Split the meshes of a raytracer by whether they're walkable.
+
+			\param rt Raytracer to split.
+			\param geom_ids Flags of the meshes in `rt`. Meshes flagged as HIT_FLAG::FLOORS are walkable.
+			\param walkable_ids IDs of the meshes that may be walkable.
+		*/
+		inline FloorScenes(
+			const HF::RayTracer::EmbreeRayTracer& rt,
+			const GeometryFlagMap& geom_ids,
+			const std::vector<int>& walkable_ids
+		) : source(rt), walkable_ids(walkable_ids), version(rt.SceneVersion()),
+			floors(rt.Subset(WalkableIds(geom_ids, walkable_ids))),
+			others(rt.Subset(WalkableIds(geom_ids, walkable_ids), true)) {}
+
+		/*! \brief Check whether meshes of the raytracer have changed since these scenes were split from it. */
+		inline bool IsStale() const {
+			return source.SceneVersion() != version;
+		}
+
+	private:
+		/*! \brief Get the IDs in `walkable_ids` that are still flagged as walkable in `geom_ids`. */
+		static inline std::vector<int> WalkableIds(const GeometryFlagMap& geom_ids, const std::vector<int>& walkable_ids) {
+			std::vector<int> out_ids;
+			for (int id : walkable_ids)
+				if (geom_ids[id] == HIT_FLAG::FLOORS)
+					out_ids.push_back(id);
+			return out_ids;
+		}
+	};
+}
@@ -10,17 +10,28 @@
 #include <node.h>
 #include <Edge.h>
 #include <graph.h>
+#include <cost_algorithms.h>
 #include <robin_hood.h>
 #include <omp.h>
 
 #include <unique_queue.h>
-
+#include <concurrent_node_map.h>
+#include <crawl_cache.h>
+#include <floor_scenes.h>
+#include <graph_sink.h>
+#include <HFExceptions.h>
+
+#include <algorithm>
+#include <atomic>
 #include <iostream>
+#include <numeric>
+#include <stdexcept>
 #include <thread>
 
 using HF::SpatialStructures::Graph;
 using HF::SpatialStructures::Node;
 using HF::SpatialStructures::Edge;
+using HF::SpatialStructures::Subgraph;
 using HF::SpatialStructures::roundhf_tmp;
 using HF::SpatialStructures::trunchf_tmp;
 
@@ -54,6 +65,10 @@ namespace HF::GraphGenerator{
 
 	GraphGenerator::GraphGenerator(HF::RayTracer::EmbreeRayTracer & rt, const vector<int> & obstacle_ids, const vector<int> & walkable_ids){
 		setupRT<HF::RayTracer::EmbreeRayTracer> (this, rt, obstacle_ids, walkable_ids);
+
+		// Cast floor rays in a scene containing only walkable geometry when it's known
+		if (params.geom_ids.Mode == GeometryFilterMode::OBSTACLES_AND_FLOORS)
+			params.floor_scenes = std::make_shared<FloorScenes>(rt, params.geom_ids, walkable_ids);
 	}
 
 	GraphGenerator::GraphGenerator(HF::RayTracer::NanoRTRayTracer & rt, const vector<int> & obstacle_ids, const vector<int> & walkable_ids) {
@@ -80,6 +95,82 @@ namespace HF::GraphGenerator{
 		real_t node_z_precision,
 		real_t node_spacing_precision,
 		real_t ground_offset)
+	{
+		optional_real3 checked_start = SetupParameters(
+			start_point, Spacing, MaxNodes, UpStep, UpSlope, DownStep, DownSlope,
+			max_step_connections, min_connections, cores,
+			node_z_precision, node_spacing_precision, ground_offset
+		);
+
+		// Check if the start raycast connected. If no connection was found, return an empty graph
+		if (checked_start)
+			return CrawlFromSeeds(*checked_start, { *checked_start });
+		else
+			return Graph();
+	}
+
+	SpatialStructures::Graph GraphGenerator::IMPL_BuildNetwork(
+		const vector<real3>& start_points,
+		const real3& Spacing,
+		int MaxNodes,
+		real_t UpStep,
+		real_t UpSlope,
+		real_t DownStep,
+		real_t DownSlope,
+		int max_step_connections,
+		int min_connections,
+		int cores,
+		real_t node_z_precision,
+		real_t node_spacing_precision,
+		real_t ground_offset)
+	{
+		optional_real3 origin;
+		vector<real3> seeds;
+		for (const auto& start_point : start_points) {
+			optional_real3 checked;
+
+			// The first start point on the ground defines the lattice
+			if (!origin) {
+				checked = origin = SetupParameters(
+					start_point, Spacing, MaxNodes, UpStep, UpSlope, DownStep, DownSlope,
+					max_step_connections, min_connections, cores,
+					node_z_precision, node_spacing_precision, ground_offset
+				);
+			}
+			// Move every other start point to the closest point on it
+			else {
+				const real3 snapped{
+					roundhf_tmp<real_t>((*origin)[0] + std::round((start_point[0] - (*origin)[0]) / spacing[0]) * spacing[0], params.precision.node_spacing),
+					roundhf_tmp<real_t>((*origin)[1] + std::round((start_point[1] - (*origin)[1]) / spacing[1]) * spacing[1], params.precision.node_spacing),
+					roundhf_tmp<real_t>(start_point[2], params.precision.node_z)
+				};
+				checked = ValidateStartPoint(ray_tracer, snapped, params);
+			}
+
+			if (checked && bounds.Contains(*checked))
+				seeds.push_back(*checked);
+		}
+
+		if (seeds.empty())
+			return Graph();
+		else
+			return CrawlFromSeeds(*origin, seeds);
+	}
+
+	optional_real3 GraphGenerator::SetupParameters(
+		const real3& start_point,
+		const real3& Spacing,
+		int MaxNodes,
+		real_t UpStep,
+		real_t UpSlope,
+		real_t DownStep,
+		real_t DownSlope,
+		int max_step_connections,
+		int min_connections,
+		int cores,
+		real_t node_z_precision,
+		real_t node_spacing_precision,
+		real_t ground_offset)
 	{
 		if (ground_offset < node_z_precision)
 		{
@@ -111,31 +202,306 @@ namespace HF::GraphGenerator{
 		  roundhf_tmp<real_t>(start_point[2], params.precision.node_z) 
 		};
 
-		// Define a queue to use for determining what nodes need to be checked
-		UniqueQueue to_do_list;
-		optional_real3 checked_start = ValidateStartPoint(ray_tracer, start, this->params);
+		// Split the scene again if its meshes were edited since the floor scenes were created
+		if (params.floor_scenes && params.floor_scenes->IsStale())
+			params.floor_scenes = std::make_shared<FloorScenes>(
+				params.floor_scenes->source, params.geom_ids, params.floor_scenes->walkable_ids
+			);
 
-		// Check if the start raycast connected.
-		if (checked_start)
+		return ValidateStartPoint(ray_tracer, start, this->params);
+	}
+
+	optional_real3 GraphGenerator::SetupParameters(const GeneratorSettings& settings)
+	{
+		return SetupParameters(
+			settings.start_point, settings.spacing, settings.max_nodes,
+			settings.up_step, settings.up_slope, settings.down_step, settings.down_slope,
+			settings.max_step_connections, settings.min_connections, settings.cores,
+			settings.node_z_precision, settings.node_spacing_precision, settings.ground_offset
+		);
+	}
+
+	SpatialStructures::Graph GraphGenerator::CrawlFromSeeds(
+		const real3& start,
+		const vector<real3>& seeds,
+		const vector<real3>& visited)
+	{
+		// Clearances are found with point queries, which only Embree supports
+		if (clearance_radius > 0 && ray_tracer.type != RayTracer::EMBREE)
+			throw HF::Exceptions::NotImplemented();
+
+		// Define a queue to use for determining what nodes need to be checked. Every node
+		// is offset from the start point by a multiple of spacing on the x and y axis, and
+		// rounded to node_z on the z axis, so identify nodes by their position on that lattice.
+		UniqueQueue to_do_list(SpatialStructures::NodeLattice(
+			start, { spacing[0], spacing[1], params.precision.node_z }
+		));
+
+		// Mark visited nodes as seen without leaving them in the queue, so they'll never be pushed again
+		for (const auto& node : visited)
+			to_do_list.PushAny(node);
+		to_do_list.clearQueue();
+
+		// add the seeds to the to-do list
+		for (const auto& seed : seeds)
+			to_do_list.PushAny(seed);
+
+		if (this->core_count != 0 && this->core_count != 1)
 		{
-			// Overwrite start with the checked start point
-			start = *checked_start;
+			SetupCoreCount(this->core_count);
+			return CrawlGeomParallel(to_do_list);
+		}
+		// Run the single core version of the graph generator
+		else
+			return CrawlGeom(to_do_list);
+	}
 
-			// add it to the to-do list
-			to_do_list.PushAny(start);
+	/*! 
+		\brief Bit set on values in the node map that are claims made during the current round
+		of CrawlGeomParallel instead of node IDs.
 
-			// If no connection was found, return an empty graph
-			if (this->core_count != 0 && this->core_count != 1)
-			{
-				SetupCoreCount(this->core_count);
-				return CrawlGeomParallel(to_do_list);
+		\details
+		Since IDs never have this bit set, any claim will always be greater than any ID. This lets
+		claims be lowered with an atomic minimum without ever overwriting an ID.
+	*/
+	constexpr int64_t CLAIM_BIT = int64_t(1) << 62;
+
+	std::string EdgeCostName(EdgeCost cost)
+	{
+		switch (cost) {
+		case EdgeCost::CROSS_SLOPE:
+			return "CrossSlope";
+		case EdgeCost::ENERGY_EXPENDITURE:
+			return "EnergyExpenditure";
+		case EdgeCost::STEP_TYPE:
+			return "StepType";
+		default:
+			throw std::out_of_range("Unknown edge cost");
+		}
+	}
+
+	/*!
+		\brief Calculate the extra costs of a parent's edges and store them in a chunk.
+
+		\param parent Node that every edge in `edges` extends from.
+		\param edges Edges of `parent`.
+		\param child_ids ID of the child of each edge in `edges`.
+		\param costs Costs to calculate.
+		\param out Chunk to store the costs in. The costs of `edges[i]` are stored at index `first_edge + i`
+				   of each array in `out.costs`.
+
+		\details
+		The cost algorithms are given the edges in order of their children's IDs. This is the order that
+		Graph::GetSubgraph returns them in, so the cross slope of each edge is calculated from the same
+		perpendicular edges as it would be if it were calculated after generation.
+
+		\pre `out.costs` holds an array for every cost in `costs`, with room for every edge in `edges`.
+	*/
+	inline void StoreEdgeCosts(
+		const Node& parent,
+		const vector<Edge>& edges,
+		const int* child_ids,
+		const vector<EdgeCost>& costs,
+		GraphChunk& out,
+		int first_edge
+	) {
+		vector<int> order(edges.size());
+		std::iota(order.begin(), order.end(), 0);
+		std::sort(order.begin(), order.end(), [child_ids](int a, int b) { return child_ids[a] < child_ids[b]; });
+
+		Subgraph sg{ parent, vector<Edge>(edges.size()) };
+		for (int k = 0; k < order.size(); k++)
+			sg.m_edges[k] = edges[order[k]];
+
+		for (int c = 0; c < costs.size(); c++) {
+			float* cost_out = out.costs[c].data() + first_edge;
+			switch (costs[c]) {
+			case EdgeCost::CROSS_SLOPE: {
+				const auto cross_slopes = SpatialStructures::CostAlgorithms::CalculateCrossSlope(sg);
+				for (int k = 0; k < order.size(); k++)
+					cost_out[order[k]] = cross_slopes[k].weight;
+				break;
+			}
+			case EdgeCost::ENERGY_EXPENDITURE: {
+				const auto energy = SpatialStructures::CostAlgorithms::CalculateEnergyExpenditure(sg);
+				for (int k = 0; k < order.size(); k++)
+					cost_out[order[k]] = energy.children[k].weight;
+				break;
+			}
+			case EdgeCost::STEP_TYPE:
+				for (int i = 0; i < edges.size(); i++)
+					cost_out[i] = static_cast<float>(edges[i].step_type);
+				break;
 			}
-			// Run the single core version of the graph generator
-			else
-				return CrawlGeom(to_do_list);
 		}
-		else
-			return Graph();
+	}
+
+	/*!
+		\brief Sort the edges of every row by the IDs of their children.
+
+		\param outer_indices Index of the first edge of each row, followed by the number of edges.
+		\param inner_indices ID of the child of each edge.
+		\param data Score of each edge.
+		\param costs Extra costs of each edge. These are reordered along with `data`.
+	*/
+	inline void SortRows(
+		const vector<int>& outer_indices,
+		vector<int>& inner_indices,
+		vector<float>& data,
+		vector<vector<float>>& costs
+	) {
+		vector<int> order, sorted_children;
+		vector<float> sorted_values;
+		for (int row = 0; row + 1 < outer_indices.size(); row++) {
+			const int begin = outer_indices[row];
+			const int end = outer_indices[row + 1];
+			if (std::is_sorted(inner_indices.begin() + begin, inner_indices.begin() + end)) continue;
+
+			order.resize(end - begin);
+			std::iota(order.begin(), order.end(), begin);
+			std::sort(order.begin(), order.end(), [&inner_indices](int a, int b) { return inner_indices[a] < inner_indices[b]; });
+
+			auto reorder = [&](vector<float>& values) {
+				sorted_values.resize(order.size());
+				for (int i = 0; i < order.size(); i++)
+					sorted_values[i] = values[order[i]];
+				std::copy(sorted_values.begin(), sorted_values.end(), values.begin() + begin);
+			};
+			reorder(data);
+			for (auto& cost : costs)
+				reorder(cost);
+
+			// Reorder the children last, since the order was found from them
+			sorted_children.resize(order.size());
+			for (int i = 0; i < order.size(); i++)
+				sorted_children[i] = inner_indices[order[i]];
+			std::copy(sorted_children.begin(), sorted_children.end(), inner_indices.begin() + begin);
+		}
+	}
+
+	/*!
+		\brief Create a compressed graph from the nodes and edges found by the generator.
+
+		\param chunk Every node and edge in the graph.
+		\param edge_costs Extra costs stored in `chunk.costs`.
+
+		\returns A compressed graph containing every node and edge in `chunk`, with a cost type for
+				 every cost in `edge_costs`.
+
+		\pre `chunk` contains every node starting from ID 0.
+		\post The edges in `chunk` will have been moved into the graph.
+	*/
+	inline Graph AssembleGraph(GraphChunk& chunk, const vector<EdgeCost>& edge_costs)
+	{
+		assert(chunk.first_id == 0);
+		assert(chunk.costs.size() == edge_costs.size());
+		const auto& nodes = chunk.nodes;
+		const auto& parent_ids = chunk.parent_ids;
+		const auto& row_starts = chunk.row_starts;
+
+		// Count the edges of each parent, then sum them to find where each row begins
+		vector<int> outer_indices(nodes.size() + 1, 0);
+		for (int r = 0; r < parent_ids.size(); r++)
+			outer_indices[parent_ids[r] + 1] = row_starts[r + 1] - row_starts[r];
+		for (int i = 0; i < nodes.size(); i++)
+			outer_indices[i + 1] += outer_indices[i];
+
+		vector<int> inner_indices;
+		vector<float> data;
+		vector<vector<float>> costs;
+
+		// If the parents were checked in order of their IDs, then the edges are already
+		// in the right order for the CSR
+		if (std::is_sorted(parent_ids.begin(), parent_ids.end())) {
+			inner_indices = std::move(chunk.children);
+			data = std::move(chunk.scores);
+			costs = std::move(chunk.costs);
+		}
+
+		// Otherwise move each parent's edges to its row
+		else {
+			inner_indices.resize(chunk.children.size());
+			data.resize(chunk.scores.size());
+			costs.resize(chunk.costs.size(), vector<float>(chunk.children.size()));
+			for (int r = 0; r < parent_ids.size(); r++) {
+				const int row_start = outer_indices[parent_ids[r]];
+				std::copy(chunk.children.begin() + row_starts[r], chunk.children.begin() + row_starts[r + 1], inner_indices.begin() + row_start);
+				std::copy(chunk.scores.begin() + row_starts[r], chunk.scores.begin() + row_starts[r + 1], data.begin() + row_start);
+				for (int c = 0; c < costs.size(); c++)
+					std::copy(chunk.costs[c].begin() + row_starts[r], chunk.costs[c].begin() + row_starts[r + 1], costs[c].begin() + row_start);
+			}
+			vector<int>().swap(chunk.children);
+			vector<float>().swap(chunk.scores);
+			vector<vector<float>>().swap(chunk.costs);
+		}
+
+		// Without extra costs, the graph can sort each row itself
+		if (costs.empty())
+			return Graph(nodes, std::move(outer_indices), std::move(inner_indices), std::move(data));
+
+		// Otherwise sort them here so the extra costs are in the same order as the graph's edges
+		SortRows(outer_indices, inner_indices, data, costs);
+		Graph g(nodes, std::move(outer_indices), std::move(inner_indices), std::move(data));
+		for (int c = 0; c < costs.size(); c++) {
+			g.AddCostArray(EdgeCostName(edge_costs[c]), costs[c]);
+			vector<float>().swap(costs[c]);
+		}
+		return g;
+	}
+
+	void GraphGenerator::StoreClearances(GraphChunk& out)
+	{
+		if (clearance_radius <= 0 || out.clearances.size() == out.nodes.size()) return;
+
+		// Query from a step's height above each node, so only surfaces above that height are found
+		const int first = out.clearances.size();
+		vector<real3> points(out.nodes.size() - first);
+		for (int i = 0; i < points.size(); i++) {
+			const Node& node = out.nodes[first + i];
+			points[i] = real3{ node.x, node.y, node.z + params.up_step };
+		}
+		const auto distances = ray_tracer.ClosestDistances(points, clearance_radius, 0);
+
+		out.clearances.resize(out.nodes.size());
+		for (int i = 0; i < distances.size(); i++)
+			out.clearances[first + i] = static_cast<float>(distances[i] < 0 ? clearance_radius : distances[i]);
+	}
+
+	Graph GraphGenerator::FinishOutput(GraphChunk& out)
+	{
+		StoreClearances(out);
+
+		// Without a sink, everything that was found becomes the graph
+		if (!sink) {
+			// If no node had enough edges, then the graph is empty
+			if (out.nodes.empty())
+				return Graph();
+
+			vector<float> clearances = std::move(out.clearances);
+			Graph g = AssembleGraph(out, edge_costs);
+			if (!clearances.empty()) {
+				vector<int> ids(clearances.size());
+				std::iota(ids.begin(), ids.end(), 0);
+				g.AddNodeAttributesFloat(ids, clearance_attribute, clearances);
+			}
+			return g;
+		}
+
+		// Otherwise write whatever is left to the sink
+		if (out.size() > 0) {
+			sink->Write(out);
+			out.Clear();
+		}
+		return Graph();
+	}
+
+	void GraphGenerator::FlushOutput(GraphChunk& out)
+	{
+		if (sink && out.size() >= chunk_size) {
+			StoreClearances(out);
+			sink->Write(out);
+			out.Clear();
+		}
 	}
 
 	Graph GraphGenerator::CrawlGeomParallel(UniqueQueue& todo)
@@ -149,34 +515,63 @@ namespace HF::GraphGenerator{
 
 		RayTracer & rt_ref = this->ray_tracer;
 
-		Graph G;
+		// Take every node out of the todo list. New nodes are appended to the end of this array,
+		// next_parent marks the first node that hasn't been checked yet, and checked nodes are
+		// erased after every frontier.
+		vector<Node> queue = todo.popMany(todo.size());
+		int next_parent = 0;
+
+		// Map the key of every node that has been added to the graph to its ID
+		const auto& lattice = todo.Lattice();
+		ConcurrentNodeMap node_ids(queue.size());
+
+		// Share floor rays between every parent in every frontier
+		CrawlCache cache(lattice);
+		stats = CrawlStats();
+
+		// Nodes and edges that haven't been written to the sink yet. Edges of every accepted
+		// parent are stored in the order they were checked, and only converted into rows of
+		// the graph once every node has an ID.
+		GraphChunk out;
+		out.costs.resize(edge_costs.size());
+
 		// Iterate through every node int the todo-list while it does not reach the maximum number of nodes limit
-		while (!todo.empty() && (num_nodes < max_nodes || max_nodes < 0))
+		while (next_parent < queue.size() && (num_nodes < max_nodes || max_nodes < 0))
 		{
-			// Pop nodes from the todo list (If max_nodes will be exceeded, then
-			// only pop as many as are left in max_nodes.)
-			int to_do_count = todo.size();
+			// Take every node that hasn't been checked yet (If max_nodes will be exceeded, then
+			// only take as many as are left in max_nodes.)
+			int to_do_count = queue.size() - next_parent;
 			if (max_nodes > 0)
-				to_do_count = std::min(todo.size(), max_nodes - num_nodes);
-
-			// Get as many nodes as possible out of the queue
-			auto to_be_done = todo.popMany(to_do_count);
-
-			// If this happens, that means something is wrong with the algorithm
-			// since to_be_done with a size of zero would just cause the outer
-			// while loop to not run anymore.
-			assert(to_be_done.size() > 0);
+				to_do_count = std::min(to_do_count, max_nodes - num_nodes);
 
 			// Create array arrays of edges that will be used to store results
 			vector<vector<Edge>> OutEdges(to_do_count);
 
-			// Compute valid children for every node in parallel.
-			#pragma omp parallel for schedule(dynamic) if (to_be_done.size() > 100)
-			for (int i = 0; i < to_do_count; i++)
+			// Make space for every ray this frontier could cast. Each frontier is a level of
+			// the search, so it can reuse connections checked by the previous frontier.
+			cache.NextLevel();
+			cache.Reserve(static_cast<size_t>(to_do_count) * directions.size());
+
+			// Check parents in Z-order so nearby iterations cast rays through the same parts of the BVH.
+			// Results are still stored by each parent's index in the queue, so IDs don't change.
+			vector<int> order(to_do_count);
+			std::iota(order.begin(), order.end(), 0);
+			if (to_do_count > 100) {
+				vector<uint64_t> codes(to_do_count);
+				for (int i = 0; i < to_do_count; i++)
+					codes[i] = lattice.Key(queue[next_parent + i]).MortonCode();
+				std::sort(order.begin(), order.end(), [&codes](int a, int b) { return codes[a] < codes[b]; });
+			}
+
+			// Compute valid children for every node in parallel. Threads take runs of parents
+			// that are next to each other along the curve.
+			#pragma omp parallel for schedule(dynamic, 16) if (to_do_count > 100)
+			for (int j = 0; j < to_do_count; j++)
 			{
-				// Get the parent node from the todo list at index i
+				// Get the parent node at index i of this frontier
 				// and cast it to a real3
-				const Node& n = to_be_done[i];
+				const int i = order[j];
+				const Node& n = queue[next_parent + i];
 				const auto real_parent = CastToReal3(n);
 
 				// Generate children around this parent
@@ -193,30 +588,142 @@ namespace HF::GraphGenerator{
 					real_parent,
 					children,
 					rt_ref,
-					params
+					params,
+					&cache
 				);
 			}
 
-			// Go through each edge array we just calculated, then 
-			// add the edges to the graph and todo list in sequence
+			// Only parents with the minimum number of edges are added to the graph. Lay out every
+			// accepted parent followed by its children in a single sequence, in the same order they
+			// would be added to the graph one edge at a time, and find where each parent begins.
+			// Also find where each accepted parent's edges will be stored.
+			vector<int64_t> offsets(to_do_count + 1, 0);
+			vector<int> rows(to_do_count + 1, 0), edge_offsets(to_do_count + 1, 0);
+			for (int i = 0; i < to_do_count; i++) {
+				const bool accepted = !OutEdges[i].empty() && OutEdges[i].size() >= this->min_connections;
+				offsets[i + 1] = offsets[i] + (accepted ? OutEdges[i].size() + 1 : 0);
+				rows[i + 1] = rows[i] + accepted;
+				edge_offsets[i + 1] = edge_offsets[i] + (accepted ? OutEdges[i].size() : 0);
+
+				// Increment max nodes
+				if (accepted) num_nodes++;
+			}
+			const int64_t num_slots = offsets[to_do_count];
+
+			// Ensure every node can be inserted without resizing the map while it's in use
+			node_ids.Reserve(num_slots);
+			vector<std::atomic<int64_t>*> ids(num_slots);
+
+			// Insert every parent and child into the map. Nodes that aren't in the graph yet are
+			// claimed by their first position in the sequence, so they'll be given the same IDs they
+			// would have been given if every edge was added to the graph in order.
+			#pragma omp parallel for schedule(dynamic, 64) if (num_slots > 1000)
 			for (int i = 0; i < to_do_count; i++) {
+				for (int64_t k = offsets[i]; k < offsets[i + 1]; k++) {
+					const Node& node = (k == offsets[i]) ? queue[next_parent + i] : OutEdges[i][k - offsets[i] - 1].child;
+					const int64_t claim = CLAIM_BIT | k;
+					auto id = node_ids.Insert(lattice.Key(node), claim);
 
-				// Only continue if there are edges for this node and the number of edges is the minimum desired
-				if (!OutEdges[i].empty() && OutEdges[i].size() >= this->min_connections) {
+					// Replace the existing claim if ours is earlier.
+					int64_t current = id->load(std::memory_order_relaxed);
+					while (claim < current && !id->compare_exchange_weak(current, claim));
 
-					// Iterate through each edge and add it to the graph / todolist
-					for (const auto& e : OutEdges[i]) {
-						todo.push(e.child);
-						G.addEdge(to_be_done[i], e.child, e.score);
-					}
+					ids[k] = id;
+				}
+			}
+
+			// Find the positions that won their claims. New children that have never been in the
+			// todo list are also added to the end of the queue. Count both for every parent.
+			vector<char> is_new(num_slots), is_queued(num_slots);
+			vector<int> new_offsets(to_do_count + 1, 0), queue_offsets(to_do_count + 1, 0);
+
+			#pragma omp parallel for schedule(dynamic, 64) if (num_slots > 1000)
+			for (int i = 0; i < to_do_count; i++) {
+				for (int64_t k = offsets[i]; k < offsets[i + 1]; k++) {
+					is_new[k] = ids[k]->load(std::memory_order_relaxed) == (CLAIM_BIT | k);
+					is_queued[k] = is_new[k] && k != offsets[i] 
+						&& bounds.Contains(OutEdges[i][k - offsets[i] - 1].child)
+						&& !todo.hasNode(OutEdges[i][k - offsets[i] - 1].child);
 					
-					// Increment max nodes
-					num_nodes++;
+					new_offsets[i + 1] += is_new[k];
+					queue_offsets[i + 1] += is_queued[k];
+				}
+			}
+			for (int i = 0; i < to_do_count; i++) {
+				new_offsets[i + 1] += new_offsets[i];
+				queue_offsets[i + 1] += queue_offsets[i];
+			}
+
+			// Give every new node an ID, then add it to the graph and queue
+			const int first_new_id = out.first_id + out.nodes.size();
+			const int first_queued = queue.size();
+			out.nodes.resize(out.nodes.size() + new_offsets[to_do_count]);
+			queue.resize(first_queued + queue_offsets[to_do_count]);
+
+			#pragma omp parallel for schedule(dynamic, 64) if (num_slots > 1000)
+			for (int i = 0; i < to_do_count; i++) {
+				int id = first_new_id + new_offsets[i];
+				int queue_index = first_queued + queue_offsets[i];
+
+				for (int64_t k = offsets[i]; k < offsets[i + 1]; k++) {
+					if (!is_new[k]) continue;
+
+					const Node& node = (k == offsets[i]) ? queue[next_parent + i] : OutEdges[i][k - offsets[i] - 1].child;
+					out.nodes[id - out.first_id] = node;
+					ids[k]->store(id, std::memory_order_relaxed);
+					id++;
+
+					if (is_queued[k]) queue[queue_index++] = node;
+				}
+			}
+
+			// Every node has an ID now, so store the edges of every accepted parent
+			const int first_row = out.parent_ids.size();
+			const int first_edge = out.children.size();
+			out.parent_ids.resize(first_row + rows[to_do_count]);
+			out.row_starts.resize(first_row + rows[to_do_count] + 1);
+			out.children.resize(first_edge + edge_offsets[to_do_count]);
+			out.scores.resize(first_edge + edge_offsets[to_do_count]);
+			for (auto& cost : out.costs)
+				cost.resize(first_edge + edge_offsets[to_do_count]);
+
+			#pragma omp parallel for schedule(dynamic, 64) if (num_slots > 1000)
+			for (int i = 0; i < to_do_count; i++) {
+				if (offsets[i + 1] == offsets[i]) continue;
+
+				const int row = first_row + rows[i];
+				out.parent_ids[row] = ids[offsets[i]]->load(std::memory_order_relaxed);
+				out.row_starts[row + 1] = first_edge + edge_offsets[i + 1];
+
+				const auto& edges = OutEdges[i];
+				for (int j = 0; j < edges.size(); j++) {
+					out.children[first_edge + edge_offsets[i] + j] = static_cast<int>(ids[offsets[i] + j + 1]->load(std::memory_order_relaxed));
+					out.scores[first_edge + edge_offsets[i] + j] = edges[j].score;
+				}
+
+				if (!edge_costs.empty()) {
+					const int parent_first_edge = first_edge + edge_offsets[i];
+					StoreEdgeCosts(queue[next_parent + i], edges, out.children.data() + parent_first_edge, edge_costs, out, parent_first_edge);
 				}
 			}
+
+			FlushOutput(out);
+
+			stats.peak_queue = std::max(stats.peak_queue, queue.size());
+			stats.peak_floors = std::max(stats.peak_floors, cache.NumFloors());
+			stats.peak_connections = std::max(stats.peak_connections, cache.NumConnections());
+
+			// Parents that have been checked are never read again, so only keep the next frontier
+			next_parent += to_do_count;
+			queue.erase(queue.begin(), queue.begin() + next_parent);
+			next_parent = 0;
 		}
 
-		return G;
+		// Put any nodes that weren't checked back in the todo list
+		for (int i = next_parent; i < queue.size(); i++)
+			todo.forcePush(queue[i]);
+
+		return FinishOutput(out);
 	}
 
 	Graph GraphGenerator::CrawlGeom(UniqueQueue& todo)
@@ -227,12 +734,45 @@ namespace HF::GraphGenerator{
 		// Cast this to a reference to avoid dereferencing every time
 		RayTracer& rt_ref = this->ray_tracer;
 
+		// Share floor rays between parents
+		CrawlCache cache(todo.Lattice());
+		stats = CrawlStats();
+
 		int num_nodes = 0;
-		Graph G;
+
+		// Assign IDs to nodes in the order they're first added to the graph
+		const auto& lattice = todo.Lattice();
+		robin_hood::unordered_map<SpatialStructures::LatticeKey, int> node_ids;
+
+		// Nodes and edges that haven't been written to the sink yet. Edges of every
+		// accepted parent are stored in the order they were checked.
+		GraphChunk out;
+		out.costs.resize(edge_costs.size());
+
+		auto get_or_assign_id = [&](const Node& node) {
+			const auto result = node_ids.emplace(lattice.Key(node), static_cast<int>(out.first_id + out.nodes.size()));
+			if (result.second) out.nodes.push_back(node);
+			return result.first->second;
+		};
+
+		// Number of nodes left to check in the current level of the search
+		int remaining_in_level = todo.size();
+
 		while (!todo.empty() && (num_nodes < this->max_nodes || this->max_nodes < 0)) {
 
+			// Once every node in this level has been checked, the todo list only contains
+			// the next level
+			if (remaining_in_level == 0) {
+				stats.peak_floors = std::max(stats.peak_floors, cache.NumFloors());
+				stats.peak_connections = std::max(stats.peak_connections, cache.NumConnections());
+				cache.NextLevel();
+				remaining_in_level = todo.size();
+			}
+			stats.peak_queue = std::max(stats.peak_queue, static_cast<size_t>(todo.size()));
+
 			// Get the parent node from the todo list
 			const auto parent = todo.pop();
+			remaining_in_level--;
 
 			// To maintain our precision standards, we'll convert this node to a real3.
 			const auto real_parent = CastToReal3(parent);
@@ -246,31 +786,46 @@ namespace HF::GraphGenerator{
 			);
 
 			// Create edges
+			cache.Reserve(children.size());
 			std::vector<graph_edge> OutEdges = GetChildren(
 				real_parent,
 				children,
 				rt_ref,
-				params
+				params,
+				&cache
 			);
 
 			// Make
 			if (!OutEdges.empty() && OutEdges.size() >= this->min_connections)
 			{
 
-				// Add new nodes to the queue. It'll drop them if they
+				// Add new nodes within the bounds to the queue. It'll drop them if they
 				// already were evaluated, or already existed on the queue
 				for (auto edge : OutEdges)
-					todo.PushAny(edge.child);
+					if (bounds.Contains(edge.child))
+						todo.PushAny(edge.child);
 
 				// Add new edges to the graph
-				if (!OutEdges.empty())
-					for (const auto& edge : OutEdges)
-						G.addEdge(parent, edge.child, edge.score);
+				const int first_edge = out.children.size();
+				out.parent_ids.push_back(get_or_assign_id(parent));
+				for (const auto& edge : OutEdges) {
+					out.children.push_back(get_or_assign_id(edge.child));
+					out.scores.push_back(edge.score);
+				}
+				out.row_starts.push_back(out.children.size());
+
+				if (!edge_costs.empty()) {
+					for (auto& cost : out.costs)
+						cost.resize(out.children.size());
+					StoreEdgeCosts(parent, OutEdges, out.children.data() + first_edge, edge_costs, out, first_edge);
+				}
+				FlushOutput(out);
 
 				// Increment node count
 				num_nodes++;
 			}
 		}
-		return G;
+
+		return FinishOutput(out);
 	}
 }
\ No newline at end of file
@@ -13,9 +13,12 @@
 #include <array>
 #include <Node.h>
 #include <cassert>
+#include <functional>
 #include <variant>
 #include <MultiRT.h>
+#include <memory>
 #include <unordered_map>
+#include <string>
 
 // Forward declares for embree raytracer.
 namespace HF::RayTracer {
@@ -68,6 +71,10 @@ namespace HF::GraphGenerator {
 	*/
 
 	class UniqueQueue;
+	class CrawlCache;
+	struct FloorScenes;
+	class GraphSink;
+	struct GraphChunk;
 	struct optional_real3;
 
 	using real_t = double;							  ///< Internal decimal type of the graph generator
@@ -77,6 +84,7 @@ namespace HF::GraphGenerator {
 	constexpr real_t default_z_precision = 0.0001;
 	constexpr real_t default_ground_offset = 0.01;
 	constexpr real_t default_spacing_precision = 0.00001;
+	constexpr size_t default_chunk_size = 1000000;
 
 	using RayTracer = HF::RayTracer::MultiRT; ///< Type of raytracer to be used internally.
 	using pair = std::pair<int, int>; ///< Type for Directions to be stored as
@@ -131,7 +139,6 @@ namespace HF::GraphGenerator {
 		BOTH = 3
 	};
 
-	using hashmap = std::unordered_map<int, HIT_FLAG>; ///< Hashmap used for assigning and storing hitflags for IDs
 	
 	/*! \brief Different rules for how geometry is filtered by the graph generator. 
 	
@@ -147,6 +154,25 @@ namespace HF::GraphGenerator {
 		OBSTACLES_AND_FLOORS ///< Explicitly tag geometry ids as either obstacle or floor. Any ids outside of these ranges will always fail. 
 	};
 
+	/*!
+		\brief Costs that the graph generator can calculate for every edge while it's generating the graph.
+
+		\remarks
+		Each cost is stored in a cost type of the generated graph, alongside the default cost. The cross slope
+		and energy expenditure match the costs created by calling CostAlgorithms::CalculateCrossSlope and
+		CostAlgorithms::CalculateEnergyExpenditure on the generated graph.
+
+		\see GraphGenerator::edge_costs to enable them.
+	*/
+	enum class EdgeCost {
+		CROSS_SLOPE = 0,		///< Stored as "CrossSlope".
+		ENERGY_EXPENDITURE = 1,	///< Stored as "EnergyExpenditure".
+		STEP_TYPE = 2			///< Stored as "StepType". The SpatialStructures::STEP of each edge as a number.
+	};
+
+	/*! \brief Get the name of the cost type that `cost` is stored in. */
+	std::string EdgeCostName(EdgeCost cost);
+
 	/*! 
 		\brief Manages rules and ids for different types of geometry in the graph generator.
 	
@@ -157,7 +183,9 @@ namespace HF::GraphGenerator {
 	struct GeometryFlagMap {
 
 	private:
-		hashmap internal_dictionary;
+		/// Flag of every geometry ID, indexed by ID. IDs past the end of this array have no flag.
+		/// Mesh IDs are small and dense, so this is faster than a hashmap when checking every hit.
+		std::vector<HIT_FLAG> flags;
 
 		/*! \brief Set the filter mode of this GeometryFlagMap based on the input types. 
 			
@@ -217,7 +245,7 @@ namespace HF::GraphGenerator {
 			\returns True if the ID exists, false otherwise. 
 		*/
 		inline bool HasKey(int id) const {
-			return internal_dictionary.count(id) >= 1;
+			return id >= 0 && id < flags.size() && flags[id] != HIT_FLAG::NO_FLAG;
 		}
 
 		/*!
@@ -230,12 +258,11 @@ namespace HF::GraphGenerator {
 			assigned to `id`
 
 			\remarks
-			Unlike the standard square brackets operator of std::unordered_map, this gaurantees
-			no memory is allocated. Note that this can't be used to assign keys. 
+			This gaurantees no memory is allocated. Note that this can't be used to assign keys. 
 		*/
 		inline HIT_FLAG operator[](int id) const {
-			if (!HasKey(id)) return HIT_FLAG::NO_FLAG;
-			return internal_dictionary.at(id);
+			if (id < 0 || id >= flags.size()) return HIT_FLAG::NO_FLAG;
+			return flags[id];
 		}
 
 		/*! \brief Set the value of a key in the internal dictionary.
@@ -245,9 +272,13 @@ namespace HF::GraphGenerator {
 			\post
 			Next call to [] for this object with `id` will return `flag`. If `id` already has been
 			assigned a flag, the value will be updated to `flag`.		
+
+			\pre `id` is not negative.
 		*/
 		inline void Set(int id, HIT_FLAG flag) {
-			internal_dictionary[id] = flag;
+			assert(id >= 0);
+			if (id >= flags.size()) flags.resize(id + 1, HIT_FLAG::NO_FLAG);
+			flags[id] = flag;
 		}
 	};
 
@@ -259,6 +290,14 @@ namespace HF::GraphGenerator {
 		real_t down_slope; ///<	The maximum downward slope the graph can traverse. Any slopes steeper than this will be considered inaccessible.
 		Precision precision; ///< Tolerances for the graph
 		GeometryFlagMap geom_ids; ///< Stores a map of geometry IDs to their HIT_FLAGS and the current filter mode of the graph
+
+		/*!
+			\brief Walkable geometry in a scene of its own, used to cast rays for floors in
+			GeometryFilterMode::OBSTACLES_AND_FLOORS. If null, rays are cast against the entire scene.
+
+			\see FloorScenes for details.
+		*/
+		std::shared_ptr<FloorScenes> floor_scenes;
 	};
 
 	/*! 
@@ -325,6 +364,82 @@ namespace HF::GraphGenerator {
 	*/
 	std::set<std::pair<int, int>> permutations(int limit);
 
+	/*!
+		\brief A region that limits which nodes the graph generator will expand.
+
+		\details
+		A region is a rectangle, optionally clipped further by a polygon. Rectangles are half open, so
+		a point on the minimum edge is inside them while a point on the maximum edge isn't. This allows
+		a domain to be split into rectangles that share edges without any point being inside more than
+		one of them. By default bounds contain every point.
+	*/
+	struct GenerationBounds {
+		real_t min_x = -INFINITY;	///< Lowest x coordinate inside the bounds.
+		real_t min_y = -INFINITY;	///< Lowest y coordinate inside the bounds.
+		real_t max_x = INFINITY;	///< X coordinate just past the highest inside the bounds.
+		real_t max_y = INFINITY;	///< Y coordinate just past the highest inside the bounds.
+
+		/// X and y coordinates of the vertices of a polygon that points must also be inside of, in
+		/// order. If empty, only the rectangle is used.
+		std::vector<std::array<real_t, 2>> polygon;
+
+		/// If set, points must also pass this test, which receives their x, y, and z coordinates. Lets
+		/// callers exclude regions that aren't rectangles on the xy plane, such as areas covered by a
+		/// coarser graph.
+		std::function<bool(real_t, real_t, real_t)> filter;
+
+		/*! \brief Check if `point` is within these bounds. */
+		template <typename point_type>
+		inline bool Contains(const point_type& point) const {
+			const real_t x = point[0], y = point[1];
+			if (!(x >= min_x && x < max_x && y >= min_y && y < max_y)) return false;
+			if (filter && !filter(x, y, point[2])) return false;
+
+			// Count the edges of the polygon crossed by a ray cast from the point in the +x direction.
+			// The point is inside if this is odd.
+			bool inside = polygon.empty();
+			for (size_t i = 0, j = polygon.size() - 1; i < polygon.size(); j = i++) {
+				const auto& a = polygon[i];
+				const auto& b = polygon[j];
+				if ((a[1] > y) != (b[1] > y) && x < (b[0] - a[0]) * (y - a[1]) / (b[1] - a[1]) + a[0])
+					inside = !inside;
+			}
+			return inside;
+		}
+	};
+
+	/*!
+		\brief The arguments of GraphGenerator::BuildNetwork, stored so they can be shared by every tile of a graph.
+
+		\see GraphGenerator::BuildNetwork for a description of each argument.
+	*/
+	struct GeneratorSettings {
+		real3 start_point;							///< Start point of the graph. Defines the lattice shared by every tile.
+		real3 spacing;								///< Space between nodes.
+		int max_nodes = -1;							///< Maximum number of nodes to generate in each tile.
+		real_t up_step;								///< Maximum height of a step up.
+		real_t up_slope;							///< Maximum upward slope in degrees.
+		real_t down_step;							///< Maximum height of a step down.
+		real_t down_slope;							///< Maximum downward slope in degrees.
+		int max_step_connections = 1;				///< Multiplier for the number of children of each node.
+		int min_connections = 1;					///< Minimum out-degree for a node to be valid.
+		int cores = -1;								///< Number of cores to use for each tile.
+		real_t node_z_precision = default_z_precision;				///< Precision to round the z-component of nodes to.
+		real_t node_spacing_precision = default_spacing_precision;	///< Precision to round nodes to after spacing is calculated.
+		real_t ground_offset = default_ground_offset;				///< Distance to offset nodes from the ground.
+	};
+
+	/*!
+		\brief How much the working sets of a crawl grew, for checking how much memory it needed.
+
+		\see GraphGenerator::stats
+	*/
+	struct CrawlStats {
+		size_t peak_queue = 0;			///< Most nodes held in the queue of nodes to check at once.
+		size_t peak_floors = 0;			///< Most floor results held by the CrawlCache at once.
+		size_t peak_connections = 0;	///< Most connection results held by the CrawlCache at once.
+	};
+
 	/*! \brief Generate a graph of accessible space from a given start point.
 
 		\details
@@ -354,6 +469,91 @@ namespace HF::GraphGenerator {
 		GraphParams params; ///< Parameters to run the graph generator. 
 
 		RayTracer ray_tracer; ///< A pointer to the raytracer to use for ray intersections.
+
+		/*!
+			\brief If set, nodes and edges are written to this sink in chunks instead of being returned as a graph.
+			
+			\details
+			This allows graphs that are too large to fit in memory to be generated. Only the keys of nodes that
+			have already been found are kept in memory after their chunk is written.
+
+			\see GraphSink for details on how chunks are written.
+		*/
+		GraphSink* sink = nullptr;
+		size_t chunk_size = default_chunk_size; ///< Number of nodes and edges to collect before writing a chunk to `sink`.
+
+		/*!
+			\brief Peak sizes of the working sets of the last crawl.
+
+			\details
+			Nodes are dropped from the queue once they've been checked, and the cache only holds the
+			results of the last few levels of the search, so both grow with the width of the search
+			rather than the size of the graph.
+		*/
+		CrawlStats stats;
+
+		/*!
+			\brief Only nodes within these bounds will be checked for children.
+
+			\details
+			Nodes outside of the bounds are still added to the graph when they're the child of a node
+			inside them, but their own children are never found.
+		*/
+		GenerationBounds bounds;
+
+		/*!
+			\brief Extra costs to calculate for every edge as it's found, in addition to the default cost.
+
+			\details
+			Costs are calculated from each parent's edges as soon as they're found, so the graph doesn't
+			need to be traversed again afterwards. They're added to the returned graph as cost types
+			named by EdgeCostName, and stored in `GraphChunk::costs` of every chunk written to `sink`.
+
+			\remarks
+			Graphs combined from several crawls, such as those created by MergeTiles and RegenerateRegion,
+			only contain the default cost.
+		*/
+		std::vector<EdgeCost> edge_costs;
+
+		/*!
+			\brief If greater than zero, record the clearance of every node up to this distance.
+
+			\details
+			Clearance is the distance from a point `GraphParams::up_step` above a node to the closest surface
+			at or above that height, so the floor the node is on and anything low enough to step onto are
+			left out. It's found with a single closest point query per node instead of a ring of rays, and
+			nodes with nothing within this distance are given this distance. Clearances are stored as the
+			float node attribute named by `clearance_attribute` in the returned graph, and in
+			`GraphChunk::clearances` of every chunk written to `sink`.
+
+			\remarks
+			This requires an EmbreeRayTracer. As with `edge_costs`, graphs combined from several crawls
+			don't contain clearances.
+
+			BuildNetwork throws HF::Exceptions::NotImplemented if this is set with any other ray tracer.
+		*/
+		real_t clearance_radius = 0;
+
+		/// Name of the node attribute that clearances are stored in.
+		static constexpr const char* clearance_attribute = "Clearance";
+
+	private:
+		/*! \brief Record the clearance of every node in `out` that doesn't have one yet, if `clearance_radius` is set. */
+		void StoreClearances(GraphChunk& out);
+
+		/*! \brief Write `out` to `sink` if one is set and `out` contains at least `chunk_size` nodes and edges. */
+		void FlushOutput(GraphChunk& out);
+
+		/*!
+			\brief Finish the output of a crawl.
+
+			\param out Every node and edge that hasn't been written to `sink` yet.
+
+			\returns A graph containing every node and edge in `out` if no sink is set. Otherwise, the
+					 remainder of `out` is written to `sink` and an empty graph is returned.
+		*/
+		SpatialStructures::Graph FinishOutput(GraphChunk& out);
+
 	public:
 		
 		/*! 
@@ -430,7 +630,8 @@ namespace HF::GraphGenerator {
 			\param node_spacing_precision Precision to round nodes after spacing is calculated
 			\param ground_offset		  Distance to offset nodes from the ground before checking line of sight
 
-			\returns The resulting graph or an empty graph if the start check failed
+			\returns The resulting graph or an empty graph if the start check failed. If `sink` is set,
+			 the graph is written to it instead and an empty graph is returned.
 			 
 			\note All parameters relating to distances are in meters, and all angles are in degrees.
 			\note Geometry MUST be Z-UP in order for this to work. 
@@ -526,7 +727,8 @@ namespace HF::GraphGenerator {
 			\param node_spacing_precision Precision to round nodes after spacing is calculated
 			\param ground_offset		  Distance to offset nodes from the ground before checking line of sight
 
-			\returns The resulting graph or an empty graph if the start check failed.
+			\returns The resulting graph or an empty graph if the start check failed. If `sink` is set,
+			 the graph is written to it instead and an empty graph is returned.
 			 
 			\note All parameters relating to distances are in meters, and all angles are in degrees.
 			\note Geometry MUST be Z-UP in order for this to work. 
@@ -550,6 +752,153 @@ namespace HF::GraphGenerator {
 		);
 
 
+		/*!
+			\brief Generate a single graph of accessible space from several start points.
+
+			\param start_points Points to start the search from. The first one above the ground defines
+								the lattice of the graph, and the rest are moved to the closest point on
+								it. Points that aren't above the ground or aren't in `bounds` are skipped.
+
+			\returns The resulting graph, or an empty graph if no start point was valid. If `sink` is
+					 set, the graph is written to it instead and an empty graph is returned.
+
+			\details
+			Every start point is crawled at once, with a single set of the nodes that have been found,
+			so areas reachable from several start points are only checked once. Use `bounds` to stop
+			the crawl from leaving a region of interest.
+
+			\see BuildNetwork for a description of the other parameters.
+		*/
+		template <
+			typename node_type,
+			typename node2_type,
+			typename up_step_type,
+			typename up_slope_type,
+			typename down_step_type,
+			typename down_slope_type,
+			typename z_precision_type = real_t,
+			typename connect_offset_type = real_t,
+			typename spacing_precision_type = real_t
+		>
+		inline SpatialStructures::Graph BuildNetwork(
+			const std::vector<node_type>& start_points,
+			const node2_type& Spacing,
+			int MaxNodes,
+			up_step_type UpStep,
+			up_slope_type UpSlope,
+			down_step_type DownStep,
+			down_slope_type DownSlope,
+			int max_step_connections,
+			int min_connections = 1,
+			int cores = -1,
+			z_precision_type node_z_precision = default_z_precision,
+			connect_offset_type node_spacing_precision = default_spacing_precision,
+			spacing_precision_type ground_offset = default_ground_offset
+		) {
+			assert(node_z_precision != 0);
+			std::vector<real3> real_start_points(start_points.size());
+			for (int i = 0; i < start_points.size(); i++)
+				real_start_points[i] = CastToReal3(start_points[i]);
+
+			return IMPL_BuildNetwork(
+				real_start_points,
+				CastToReal3(Spacing),
+				MaxNodes,
+				CastToReal(UpStep),
+				CastToReal(UpSlope),
+				CastToReal(DownStep),
+				CastToReal(DownSlope),
+				max_step_connections,
+				min_connections,
+				cores,
+				CastToReal(node_z_precision),
+				CastToReal(node_spacing_precision),
+				CastToReal(ground_offset)
+			);
+		}
+
+		/*!
+			\brief Generate a single graph of accessible space from several start points.
+
+			\see The overload of BuildNetwork that takes several start points for details.
+		*/
+		SpatialStructures::Graph IMPL_BuildNetwork(
+			const std::vector<real3>& start_points,
+			const real3& Spacing,
+			int MaxNodes,
+			real_t UpStep,
+			real_t UpSlope,
+			real_t DownStep,
+			real_t DownSlope,
+			int max_step_connections,
+			int min_connections,
+			int cores = -1,
+			real_t node_z_precision = default_z_precision,
+			real_t node_spacing_precision = default_spacing_precision,
+			real_t ground_offset = default_ground_offset
+		);
+
+		/*!
+			\brief Store the parameters of the graph generator and find the start point of a crawl.
+
+			\param start_point Start point of the graph. Its x and y coordinates define the lattice
+								that every node will be placed on.
+
+			\returns The start point on the ground below `start_point` if one was found. Otherwise an
+					 invalid optional_real3.
+
+			\details
+			Takes the same parameters as IMPL_BuildNetwork, and stores them the same way. This lets
+			callers that need to crawl from several seeds, such as GenerateTile, share the lattice of a
+			single start point. If meshes of the raytracer were added, edited or removed since the floor
+			scenes of `params` were created, they're created again here.
+
+			\see CrawlFromSeeds for crawling once the parameters are set.
+		*/
+		optional_real3 SetupParameters(
+			const real3& start_point,
+			const real3& Spacing,
+			int MaxNodes,
+			real_t UpStep,
+			real_t UpSlope,
+			real_t DownStep,
+			real_t DownSlope,
+			int max_step_connections,
+			int min_connections,
+			int cores = -1,
+			real_t node_z_precision = default_z_precision,
+			real_t node_spacing_precision = default_spacing_precision,
+			real_t ground_offset = default_ground_offset
+		);
+
+		/*!
+			\brief Store the parameters of the graph generator from a set of settings.
+
+			\returns The start point of `settings` on the ground if one was found. Otherwise an invalid optional_real3.
+
+			\see SetupParameters for details.
+		*/
+		optional_real3 SetupParameters(const GeneratorSettings& settings);
+
+		/*!
+			\brief Crawl from several seeds at once using the parameters stored by SetupParameters.
+
+			\param start Checked start point returned by SetupParameters. Defines the lattice of the graph.
+			\param seeds Nodes to begin the search from, checked by ValidateStartPoint. Each is
+						 expanded even if it isn't within `bounds`.
+			\param visited Nodes that were already expanded elsewhere. Edges will still be created to
+						   these nodes, but they won't be expanded again.
+
+			\returns The resulting graph, or an empty graph if `sink` is set.
+
+			\pre Every seed is on the lattice defined by `start` and the spacing of the generator.
+		*/
+		SpatialStructures::Graph CrawlFromSeeds(
+			const real3& start,
+			const std::vector<real3>& seeds,
+			const std::vector<real3>& visited = std::vector<real3>()
+		);
+
 		/*!
 			\brief Perform breadth first search to populate the graph with with nodes and edges. 
 
@@ -557,9 +906,14 @@ namespace HF::GraphGenerator {
 
 			\pre todo contains the starting point for the graph.
 
+			\remarks Rays cast straight down from each child are cached for the duration of this call, so a
+			child shared by multiple parents will only need to be found once. Rays cast to connect nodes
+			are cached for one level of the search so the connection back from each child can reuse them.
+
 			\see CrawlGeomParallel for a parallel version.
 
-			\returns The Graph generated by performing the breadth first search. 
+			\returns The Graph generated by performing the breadth first search. The graph is built
+			directly from each parent's edges and is already compressed.
 
 			\par Example
 			\snippet tests\src\GraphGenerator.cpp EX_GraphGeneratorRayTracer
@@ -578,7 +932,19 @@ namespace HF::GraphGenerator {
 
 			\pre todo contains the starting point for the graph.
 
-			\returns The Graph generated by performing the breadth first search.
+			\returns The Graph generated by performing the breadth first search. The graph is built
+			directly from each parent's edges and is already compressed.
+
+			\details
+			Nodes are checked one frontier at a time. After the children of every node in the frontier
+			are found, they're deduplicated in parallel using a ConcurrentNodeMap, and each parent's
+			edges are written directly to its row of the graph. IDs are assigned in the same order
+			as if every edge was added to the graph one at a time, so the resulting graph is
+			identical regardless of the number of threads used. Like CrawlGeom, rays cast straight down
+			from each child are cached and shared between every parent in every frontier, and the
+			connections checked in each frontier are reused to check the connections back from the next.
+
+			\post todo will contain any nodes that weren't checked due to reaching max_nodes.
 
 			\par Example
 			\snippet tests\src\GraphGenerator.cpp EX_GraphGeneratorRayTracer
@@ -641,6 +1007,34 @@ namespace HF::GraphGenerator {
 		const GeometryFlagMap& geometry_dict = GeometryFlagMap()
 	);
 
+	/*!
+		\brief Get the point of intersection from the result of a ray that has already been cast.
+
+		\param res Result of casting a ray from `origin` in `direction`.
+		\param origin Origin point of the ray.
+		\param direction direction the ray was cast in.
+		\param node_z_tolerance Precision to round the point of intersection's z-component to
+		\param flag Which category of geometry will be intersected with. 
+		\param geometry_dict Dictionary containing rules for filtering ray intersections.
+
+		\returns An invalid optional_real3 if the ray did not intersect any geometry of the type in
+				 `flag`, or a valid optional_real3 containing the point of intersection otherwise.
+
+		\remarks
+		This is used by CheckRay, and by functions that cast several rays at once
+		such as CheckChildren.
+
+		\see CheckRay for casting the ray and resolving the result in a single call. 
+	*/
+	optional_real3 ResolveHit(
+		const HF::RayTracer::HitStruct<real_t>& res,
+		const real3& origin,
+		const real3& direction,
+		real_t node_z_tolerance,
+		HIT_FLAG flag = BOTH,
+		const GeometryFlagMap& geometry_dict = GeometryFlagMap()
+	);
+
 
 	/*! 
 		\brief Create a set of directions based on max_step_connections
@@ -665,6 +1059,8 @@ namespace HF::GraphGenerator {
 		\param possible_children Children that may have an edge with Parent
 		\param rt Raytracer to use for ray intersections
 		\param GP parameters to use for rounding and discarding nodes
+		\param cache Optional cache of rays already cast by other parents. See CheckChildren and
+					 CheckConnections for how it's used.
 
 		\par Rules
 		An edge is considered valid if:
@@ -687,7 +1083,8 @@ namespace HF::GraphGenerator {
 		const real3 & parent,
 		const std::vector<real3>& possible_children,
 		RayTracer  & rt,
-		const GraphParams & GP
+		const GraphParams & GP,
+		CrawlCache * cache = nullptr
 	);
 
 	/*! 
@@ -740,12 +1137,20 @@ namespace HF::GraphGenerator {
 		\param possible_children Children of parent that may or may not be over valid ground
 		\param rt Raytracer to use for all ray intersections
 		\param params Parameters to use for upstep/downstep limits and rounding
+		\param cache Optional cache of floor rays. Rays already in the cache won't be cast again, and
+					 the results of any rays that are cast will be added to it.
 
 		\returns An array of children from `possible_children` that are over valid ground and meet the
 				 upstep/downstep requirements in `params`. Any child that didn't meet these requirements
 				 will not have been included. Each child in the return will have been moved to be directly
 				 over the valid ground they're above. 
 
+		\remarks
+		The rays for every child are cast together using MultiRT::Intersections so they
+		can be traced as packets.
+
+		\pre If `cache` is specified, it must have space reserved for a result from every child in
+		`possible_children`.
 		
 		\par Example
 		\snippet tests\src\GraphGenerator.cpp EX_GraphGeneratorRayTracer
@@ -756,7 +1161,8 @@ namespace HF::GraphGenerator {
 		const real3& parent,
 		const std::vector<real3>& possible_children,
 		RayTracer& rt,
-		const GraphParams & params
+		const GraphParams & params,
+		CrawlCache * cache = nullptr
 	);
 
 	/*! 
@@ -782,6 +1188,42 @@ namespace HF::GraphGenerator {
 		const GraphParams & params
 	);
 
+	/*!
+		\brief Determine what kind of step (if any) is between parent and each child.
+
+		\param parent Node being traversed from
+		\param children Nodes being traversed to
+		\param rt Raytracer to use for all ray intersections
+		\param params Parameters to use for upstep/downstep and upslope/downslope
+		\param cache Optional cache of connections checked during the previous level of the search.
+					 Rays already cast from a child to the parent won't be cast again, and the rays
+					 cast for every other child will be added to the cache.
+
+		\returns The type of step between parent and every child in `children`, in the same
+				 order as `children`. Children that couldn't be connected will be NOT_CONNECTED.
+
+		\details
+		Produces the same results as calling CheckConnection for every child, but casts
+		the line of sight rays for all children together, followed by the step rays for all
+		children whose line of sight was obstructed. This allows both sets of rays to
+		be traced as packets.
+
+		The line of sight ray and the ray for stepping up or down between two nodes are the same
+		from either node, so when `cache` is specified the connection from a child that was
+		already checked as a parent is derived from its rays instead of being tested again.
+
+		\pre If `cache` is specified, it must have space reserved for a result from every child in `children`.
+
+		\see CheckConnection for the rules used to determine the connection between nodes.
+	*/
+	std::vector<HF::SpatialStructures::STEP> CheckConnections(
+		const real3& parent,
+		const std::vector<real3>& children,
+		RayTracer& rt,
+		const GraphParams& params,
+		CrawlCache* cache = nullptr
+	);
+
 	/*! 
 		\brief Determine if there is a valid line of sight between parent and child
 		
@@ -0,0 +1,122 @@
+///
+/// \file		graph_sink.cpp
+/// \brief		Contains implementation for the <see cref="HF::GraphGenerator::GraphSink">GraphSink</see> implementations
+///
+///	\author		TBA
+///	\date		26 Jun 2020
+
+#include <graph_sink.h>
+#include <HFExceptions.h>
+
+#include <cstdint>
+
+using HF::SpatialStructures::Node;
+
+namespace HF::GraphGenerator {
+
+	size_t GraphChunk::size() const { return nodes.size() + children.size(); }
+
+	void GraphChunk::Clear()
+	{
+		first_id += nodes.size();
+		nodes.clear();
+		parent_ids.clear();
+		row_starts.assign(1, 0);
+		children.clear();
+		scores.clear();
+		for (auto& cost : costs)
+			cost.clear();
+		clearances.clear();
+	}
+
+	CallbackGraphSink::CallbackGraphSink(std::function<void(const GraphChunk&)> callback)
+		: callback(std::move(callback)) {}
+
+	void CallbackGraphSink::Write(const GraphChunk& chunk) { callback(chunk); }
+
+	/*! \brief Write the contents of an array to a binary stream. */
+	template <typename T>
+	inline void WriteArray(std::ostream& out, const std::vector<T>& arr) {
+		out.write(reinterpret_cast<const char*>(arr.data()), arr.size() * sizeof(T));
+	}
+
+	/*! \brief Read `count` elements from a binary stream into an array. */
+	template <typename T>
+	inline void ReadArray(std::istream& in, std::vector<T>& arr, int32_t count) {
+		arr.resize(count);
+		in.read(reinterpret_cast<char*>(arr.data()), count * sizeof(T));
+	}
+
+	FileGraphSink::FileGraphSink(const std::string& path)
+		: file(path, std::ios::binary | std::ios::app)
+	{
+		if (!file.is_open())
+			throw HF::Exceptions::FileNotFound();
+	}
+
+	void FileGraphSink::Write(const GraphChunk& chunk)
+	{
+		const int32_t header[6] = {
+			chunk.first_id,
+			static_cast<int32_t>(chunk.nodes.size()),
+			static_cast<int32_t>(chunk.parent_ids.size()),
+			static_cast<int32_t>(chunk.children.size()),
+			static_cast<int32_t>(chunk.costs.size()),
+			static_cast<int32_t>(chunk.clearances.size())
+		};
+		file.write(reinterpret_cast<const char*>(header), sizeof(header));
+
+		// Only write the position of each node. Their IDs are implied by first_id.
+		std::vector<float> positions(chunk.nodes.size() * 3);
+		for (int i = 0; i < chunk.nodes.size(); i++) {
+			positions[i * 3] = chunk.nodes[i].x;
+			positions[i * 3 + 1] = chunk.nodes[i].y;
+			positions[i * 3 + 2] = chunk.nodes[i].z;
+		}
+		WriteArray(file, positions);
+
+		WriteArray(file, chunk.parent_ids);
+		WriteArray(file, chunk.row_starts);
+		WriteArray(file, chunk.children);
+		WriteArray(file, chunk.scores);
+		for (const auto& cost : chunk.costs)
+			WriteArray(file, cost);
+		WriteArray(file, chunk.clearances);
+
+		// Flush so readers can process this chunk while the generator is still running
+		file.flush();
+	}
+
+	void ReadGraphChunks(const std::string& path, const std::function<void(const GraphChunk&)>& callback)
+	{
+		std::ifstream file(path, std::ios::binary);
+		if (!file.is_open())
+			throw HF::Exceptions::FileNotFound();
+
+		GraphChunk chunk;
+		int32_t header[6];
+		while (file.read(reinterpret_cast<char*>(header), sizeof(header))) {
+			chunk.first_id = header[0];
+
+			std::vector<float> positions;
+			ReadArray(file, positions, header[1] * 3);
+			chunk.nodes.resize(header[1]);
+			for (int i = 0; i < header[1]; i++)
+				chunk.nodes[i] = Node(positions[i * 3], positions[i * 3 + 1], positions[i * 3 + 2], chunk.first_id + i);
+
+			ReadArray(file, chunk.parent_ids, header[2]);
+			ReadArray(file, chunk.row_starts, header[2] + 1);
+			ReadArray(file, chunk.children, header[3]);
+			ReadArray(file, chunk.scores, header[3]);
+			chunk.costs.resize(header[4]);
+			for (auto& cost : chunk.costs)
+				ReadArray(file, cost, header[3]);
+			ReadArray(file, chunk.clearances, header[5]);
+
+			// Stop if the file ended partway through this chunk
+			if (!file) break;
+
+			callback(chunk);
+		}
+	}
+}
@@ -0,0 +1,127 @@
+///
+/// \file		graph_sink.h
+/// \brief		Contains definitions for the <see cref="HF::GraphGenerator::GraphSink">GraphSink</see> interface and its implementations
+///
+///	\author		TBA
+///	\date		26 Jun 2020
+
+#pragma once
+
+#include <node.h>
+
+#include <fstream>
+#include <functional>
+#include <string>
+#include <vector>
+
+namespace HF::GraphGenerator {
+
+	/*!
+		\brief A batch of nodes and edges produced by the graph generator.
+
+		\details
+		Nodes are given consecutive IDs in the order they're first found, and each chunk contains
+		the nodes that were first found while it was being filled. The edges of each parent are
+		stored in the same layout as a CSR, however parents may be in any order and don't need to
+		have been added in this chunk. Edges will only ever refer to nodes from this chunk or
+		earlier chunks.
+
+		\invariant `row_starts.size() == parent_ids.size() + 1` and `row_starts.back() == children.size()`.
+		Every array in `costs` is the same size as `children`. `clearances` is either empty or the same size as `nodes`.
+	*/
+	struct GraphChunk {
+		int first_id = 0;								///< ID of the first node in `nodes`.
+		std::vector<HF::SpatialStructures::Node> nodes;	///< Nodes first found in this chunk, ordered by ID.
+		std::vector<int> parent_ids;					///< ID of each parent with edges in this chunk.
+		std::vector<int> row_starts{ 0 };				///< Index of each parent's first edge, followed by the number of edges.
+		std::vector<int> children;						///< ID of the child of each edge.
+		std::vector<float> scores;						///< Score of each edge.
+		std::vector<std::vector<float>> costs;			///< Extra costs of each edge, in the order of GraphGenerator::edge_costs.
+		std::vector<float> clearances;					///< Clearance of each node in `nodes`. Empty unless GraphGenerator::clearance_radius is set.
+
+		/*! \brief Get the number of nodes and edges in this chunk. */
+		size_t size() const;
+
+		/*!
+			\brief Remove every node and edge from this chunk.
+
+			\post `first_id` is advanced past every node that was in this chunk, so the
+			next node found will continue where this chunk left off.
+		*/
+		void Clear();
+	};
+
+	/*!
+		\brief Receives the output of the graph generator one chunk at a time.
+
+		\details
+		When a sink is set on the GraphGenerator, it writes every chunk to the sink once the
+		chunk holds at least GraphGenerator::chunk_size nodes and edges, and writes any remainder
+		when it finishes. Once a chunk is written, only the keys of its nodes are kept in memory.
+		This allows graphs larger than memory to be generated, and lets callers process
+		the graph before generation is complete.
+	*/
+	class GraphSink {
+	public:
+		/*!
+			\brief Receive the next chunk of the graph.
+
+			\param chunk Chunk of nodes and edges. Only valid for the duration of the call.
+		*/
+		virtual void Write(const GraphChunk& chunk) = 0;
+
+		virtual ~GraphSink() = default;
+	};
+
+	/*! \brief A sink that passes every chunk to a callback. */
+	class CallbackGraphSink : public GraphSink {
+	private:
+		std::function<void(const GraphChunk&)> callback; ///< Function to call with every chunk.
+
+	public:
+		/*! \brief Create a sink that calls `callback` with every chunk. */
+		CallbackGraphSink(std::function<void(const GraphChunk&)> callback);
+
+		/*! \brief Pass `chunk` to the callback. */
+		void Write(const GraphChunk& chunk) override;
+	};
+
+	/*!
+		\brief A sink that appends every chunk to a binary file.
+
+		\details
+		Each chunk is written as a header of six 32-bit integers: `first_id`, the number of
+		nodes, parents, edges, and extra costs, and the number of clearances. This is followed by
+		the x,y,z coordinates of every node as floats, then `parent_ids`, `row_starts`, `children`,
+		`scores`, each array of `costs`, and `clearances` in order.
+
+		\see ReadGraphChunks for reading the chunks back from the file.
+	*/
+	class FileGraphSink : public GraphSink {
+	private:
+		std::ofstream file; ///< File that chunks are appended to.
+
+	public:
+		/*!
+			\brief Open a file to write chunks to.
+
+			\param path Path to the file. If it already exists, chunks will be appended to the end of it.
+
+			\throws HF::Exceptions::FileNotFound if the file couldn't be opened.
+		*/
+		FileGraphSink(const std::string& path);
+
+		/*! \brief Append `chunk` to the end of the file. */
+		void Write(const GraphChunk& chunk) override;
+	};
+
+	/*!
+		\brief Read every chunk written by a FileGraphSink.
+
+		\param path Path of the file to read from.
+		\param callback Function to call with every chunk, in the order they were written.
+
+		\throws HF::Exceptions::FileNotFound if the file couldn't be opened.
+	*/
+	void ReadGraphChunks(const std::string& path, const std::function<void(const GraphChunk&)>& callback);
+}
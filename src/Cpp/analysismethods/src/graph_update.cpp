@@ -0,0 +1,115 @@
+///
+/// \file		graph_update.cpp
+/// \brief		Contains implementation for updating a generated graph after its geometry has changed
+///
+///	\author		TBA
+///	\date		26 Jun 2020
+
+#define NOMINMAX
+#include <graph_update.h>
+#include <graph_sink.h>
+#include <merged_graph.h>
+#include <graph.h>
+#include <Edge.h>
+#include <node.h>
+
+#include <algorithm>
+
+using HF::SpatialStructures::Graph;
+using HF::SpatialStructures::Node;
+using HF::SpatialStructures::NodeLattice;
+
+using std::vector;
+
+namespace HF::GraphGenerator {
+
+	Graph RegenerateRegion(
+		GraphGenerator& gg,
+		const GeneratorSettings& settings,
+		const Graph& graph,
+		const DirtyRegion& region)
+	{
+		gg.sink = nullptr;
+		const optional_real3 start = gg.SetupParameters(settings);
+		const vector<Node> nodes = graph.Nodes();
+
+		// The start point may have been covered by the change. Since the first node of the
+		// graph is the original start point, it can be used to define the lattice instead.
+		if (!start && nodes.empty()) return Graph();
+		const real3 origin = start ? *start : CastToReal3(nodes[0]);
+
+		// Every ray cast while expanding a node is within this distance of it on the x and y axes,
+		// and starts below this height above it. Floor rays extend downwards without limit.
+		const real_t reach_x = gg.max_step_connection * gg.spacing[0];
+		const real_t reach_y = gg.max_step_connection * gg.spacing[1];
+		const real_t ray_height = gg.spacing[2] + std::max(gg.params.up_step, gg.params.down_step) + gg.params.precision.ground_offset;
+
+		auto rays_cross_region = [&](const Node& node, real_t dx, real_t dy) {
+			return node.x + dx >= region.min[0] && node.x - dx <= region.max[0]
+				&& node.y + dy >= region.min[1] && node.y - dy <= region.max[1]
+				&& node.z + ray_height >= region.min[2];
+		};
+
+		// Remove nodes whose own floor ray crosses the region, and invalidate the edges of every
+		// node that cast any ray across it, or has an edge to a node that was removed
+		const auto edge_sets = graph.GetEdges();
+		vector<char> removed(nodes.size()), invalid(nodes.size()), expanded(nodes.size());
+		for (int i = 0; i < nodes.size(); i++) {
+			removed[i] = rays_cross_region(nodes[i], 0, 0);
+			invalid[i] = removed[i] || rays_cross_region(nodes[i], reach_x, reach_y);
+		}
+		for (const auto& edge_set : edge_sets) {
+			expanded[edge_set.parent] = !edge_set.children.empty();
+			for (const auto& edge : edge_set.children)
+				if (removed[edge.child]) invalid[edge_set.parent] = true;
+		}
+
+		// Keep every node that wasn't removed in its existing order, along with the edges of
+		// every node that's still valid
+		GraphChunk kept;
+		vector<int> kept_ids(nodes.size(), -1);
+		for (int i = 0; i < nodes.size(); i++) {
+			if (removed[i]) continue;
+			kept_ids[i] = kept.nodes.size();
+			kept.nodes.push_back(nodes[i]);
+		}
+		for (const auto& edge_set : edge_sets) {
+			if (invalid[edge_set.parent] || edge_set.children.empty()) continue;
+
+			kept.parent_ids.push_back(kept_ids[edge_set.parent]);
+			for (const auto& edge : edge_set.children) {
+				kept.children.push_back(kept_ids[edge.child]);
+				kept.scores.push_back(edge.weight);
+			}
+			kept.row_starts.push_back(kept.children.size());
+		}
+
+		MergedGraph merged(NodeLattice(origin, { gg.spacing[0], gg.spacing[1], gg.params.precision.node_z }));
+		vector<int> kept_indices;
+		merged.Add(kept, kept_indices);
+
+		// Crawl again from every invalidated node that's left, without expanding any node that's still valid
+		vector<real3> seeds, visited;
+		for (int i = 0; i < nodes.size(); i++) {
+			if (removed[i]) continue;
+			else if (!invalid[i] && expanded[i])
+				visited.push_back(CastToReal3(nodes[i]));
+			else if (invalid[i] && gg.bounds.Contains(nodes[i]))
+				seeds.push_back(CastToReal3(nodes[i]));
+		}
+
+		// Crawl from the start point too in case it was removed. It's skipped if it's still valid.
+		if (start && gg.bounds.Contains(*start))
+			seeds.push_back(*start);
+
+		vector<int> crawl_indices;
+		CallbackGraphSink sink([&](const GraphChunk& chunk) {
+			merged.Add(chunk, crawl_indices);
+		});
+		gg.sink = &sink;
+		gg.CrawlFromSeeds(origin, seeds, visited);
+		gg.sink = nullptr;
+
+		return merged.Assemble();
+	}
+}
@@ -0,0 +1,55 @@
+///
+/// \file		graph_update.h
+/// \brief		Contains definitions for updating a generated graph after its geometry has changed
+///
+///	\author		TBA
+///	\date		26 Jun 2020
+
+#pragma once
+
+#include <graph_generator.h>
+
+namespace HF::GraphGenerator {
+
+	/*! \brief An axis aligned box containing every piece of geometry that changed since a graph was generated. */
+	struct DirtyRegion {
+		real3 min;	///< Lowest x, y, and z coordinates of the changed geometry.
+		real3 max;	///< Highest x, y, and z coordinates of the changed geometry.
+	};
+
+	/*!
+		\brief Update a graph after the geometry within a region has changed, without generating it again.
+
+		\param gg Graph generator whose raytracer contains the updated geometry. Its `bounds` should be
+				  the same as when `graph` was generated. Its `sink` is overwritten.
+		\param settings Settings that `graph` was generated with.
+		\param graph Graph to update.
+		\param region Region containing every change to the geometry.
+
+		\returns A copy of `graph` updated for the new geometry.
+
+		\details
+		Every ray the generator casts while expanding a node is within `max_step_connections` nodes of
+		it on the x and y axes, and below the height of its children's floor rays. Nodes whose rays could
+		cross `region` are invalidated. Those directly over `region` are removed, and the rest lose their
+		edges and become seeds for a new crawl. The crawl finds the nodes and edges within the region
+		again, and stops at nodes whose edges are still valid. The result is spliced into the existing
+		nodes and edges to create the new graph.
+
+		Nodes that weren't removed keep their order, so if no nodes were removed, every node keeps its
+		ID. New nodes are given IDs after every existing node.
+
+		\remarks
+		Only the default cost of `graph` is updated. Other cost types and node attributes aren't
+		carried over, since the edges and nodes they refer to may have changed. Nodes that can no
+		longer be reached from the start point are kept.
+
+		\pre `graph` is compressed and was generated with the same settings and bounds.
+	*/
+	SpatialStructures::Graph RegenerateRegion(
+		GraphGenerator& gg,
+		const GeneratorSettings& settings,
+		const SpatialStructures::Graph& graph,
+		const DirtyRegion& region
+	);
+}
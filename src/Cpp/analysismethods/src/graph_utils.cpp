@@ -1,4 +1,6 @@
 #include <graph_generator.h>
+#include <crawl_cache.h>
+#include <floor_scenes.h>
 
 #include <HitStruct.h>
 #include <Constants.h>
@@ -6,6 +8,7 @@
 #include <embree_raytracer.h>
 #include <ray_data.h>
 #include <cassert>
+#include <type_traits>
 
 namespace HF::GraphGenerator {
 
@@ -112,6 +115,9 @@ namespace HF::GraphGenerator {
 	/*! 
 		\brief Determine if a hit is against the geometry type specified
 		
+		\tparam mode Filter mode of `geom_dict`. Since this is known at compile time, only the
+					  checks for this mode are compiled.
+
 		\param goal Hitflag that the intersection is being cheecked against
 		\param ID id of the mesh that was intesected
 		\param geom_dict Rules to use for determining if the intersection was successful
@@ -122,27 +128,99 @@ namespace HF::GraphGenerator {
 		This function serves as the sole place for intersection mesh ids to be checked using
 		the ifnormation in geom_dict. 
 
+		\pre `mode` is the same as `geom_dict.Mode`.
 	*/
+	template <GeometryFilterMode mode>
 	inline bool CheckGeometryID(HIT_FLAG goal, int id, const GeometryFlagMap & geom_dict) {
 		
 		// If the target is both or the geometry rules are set to NO_FLAG, all hits are counted as
 		// being on walkable geometry
-		if (geom_dict.Mode == GeometryFilterMode::ALL_INTERSECTIONS || goal == HIT_FLAG::BOTH)
+		if constexpr (mode == GeometryFilterMode::ALL_INTERSECTIONS)
+			return true;
+		else if (goal == HIT_FLAG::BOTH)
 			return true;
 		
 		// Otherwise do different checks based on the ruleset
-		else if (geom_dict.Mode == GeometryFilterMode::OBSTACLES_ONLY)
+		else if constexpr (mode == GeometryFilterMode::OBSTACLES_ONLY) {
 			// If only obstacles are specified, this works like a blacklist/whitelist
 			if (goal == OBSTACLES)
 				return geom_dict[id] == HIT_FLAG::OBSTACLES;
 			else
 				return geom_dict[id] != HIT_FLAG::OBSTACLES;
-
-		else if (geom_dict.Mode == GeometryFilterMode::OBSTACLES_AND_FLOORS)
+		}
+		else
 			// In OBSTACLES_AND_FLOORS mode, the id's type must exactly match the goal
 			return (goal == geom_dict[id]);
 	}
 
+	/*! \brief A filter mode as a type, so it can be passed to a generic lambda as a compile time constant. */
+	template <GeometryFilterMode mode>
+	using FilterModeConstant = std::integral_constant<GeometryFilterMode, mode>;
+
+	/*!
+		\brief Call a function with the ray tracer that `rt` is backed by.
+
+		\param rt Ray tracer to unwrap.
+		\param fn Generic function to call with either an EmbreeRayTracer or `rt` itself.
+
+		\returns The result of `fn`.
+
+		\details
+		Every call through MultiRT checks which ray tracer it holds before casting a ray. Checking
+		once here lets `fn` be compiled for each ray tracer, so calls to an EmbreeRayTracer can be
+		inlined. Ray tracers other than Embree are still called through `rt`.
+	*/
+	template <typename fn_type>
+	inline auto DispatchRayTracer(RayTracer& rt, fn_type&& fn) {
+		if (rt.type == RayTracer::EMBREE)
+			return fn(*reinterpret_cast<HF::RayTracer::EmbreeRayTracer*>(rt.RayTracer));
+		else
+			return fn(rt);
+	}
+
+	/*!
+		\brief Call a function with the ray tracer that `rt` is backed by and the filter mode of `geom_ids`.
+
+		\param fn Generic function taking a ray tracer and a FilterModeConstant.
+
+		\returns The result of `fn`.
+
+		\see DispatchRayTracer for details.
+	*/
+	template <typename fn_type>
+	inline auto DispatchKernel(RayTracer& rt, const GeometryFlagMap& geom_ids, fn_type&& fn) {
+		return DispatchRayTracer(rt, [&](auto& tracer) {
+			switch (geom_ids.Mode) {
+			case GeometryFilterMode::OBSTACLES_ONLY:
+				return fn(tracer, FilterModeConstant<GeometryFilterMode::OBSTACLES_ONLY>());
+			case GeometryFilterMode::OBSTACLES_AND_FLOORS:
+				return fn(tracer, FilterModeConstant<GeometryFilterMode::OBSTACLES_AND_FLOORS>());
+			default:
+				return fn(tracer, FilterModeConstant<GeometryFilterMode::ALL_INTERSECTIONS>());
+			}
+		});
+	}
+
+	/*! \brief Cast a set of rays using packets of an EmbreeRayTracer directly. */
+	inline vector<HitStruct<real_t>> CastIntersections(HF::RayTracer::EmbreeRayTracer& rt, const vector<real3>& origins, const vector<real3>& directions) {
+		return rt.PacketIntersections<real_t>(origins, directions);
+	}
+
+	/*! \brief Cast a set of rays through a MultiRT. */
+	inline vector<HitStruct<real_t>> CastIntersections(RayTracer& rt, const vector<real3>& origins, const vector<real3>& directions) {
+		return rt.Intersections(origins, directions);
+	}
+
+	/*! \brief Cast a set of occlusion rays using packets of an EmbreeRayTracer directly. */
+	inline vector<char> CastOcclusions(HF::RayTracer::EmbreeRayTracer& rt, const vector<real3>& origins, const vector<real3>& directions, const vector<real_t>& distances) {
+		return rt.PacketOcclusions(origins, directions, distances);
+	}
+
+	/*! \brief Cast a set of occlusion rays through a MultiRT. */
+	inline vector<char> CastOcclusions(RayTracer& rt, const vector<real3>& origins, const vector<real3>& directions, const vector<real_t>& distances) {
+		return rt.Occlusions(origins, directions, distances);
+	}
+
 	optional_real3 CheckRay(
 		RayTracer& ray_tracer,
 		const real3& origin,
@@ -157,8 +235,21 @@ namespace HF::GraphGenerator {
 		// Cast the ray. On success, this returns the ID and distance to intersection.
 		res = ray_tracer.Intersect(origin, direction);
 
+		return ResolveHit(res, origin, direction, node_z_tolerance, flag, geometry_dict);
+	}
+
+	/*! \brief ResolveHit for a filter mode known at compile time. */
+	template <GeometryFilterMode mode>
+	inline optional_real3 ResolveHitAs(
+		const HitStruct<real_t>& res,
+		const real3& origin,
+		const real3& direction,
+		real_t node_z_tolerance,
+		HIT_FLAG flag,
+		const GeometryFlagMap& geometry_dict)
+	{
 		// Check if it hit and the ID of the geometry matches what we were looking for. 
-		if (res.DidHit() && CheckGeometryID(flag, res.meshid, geometry_dict)) {
+		if (res.DidHit() && CheckGeometryID<mode>(flag, res.meshid, geometry_dict)) {
 			// Create a new optional point with a copy of the origin
 			optional_real3 return_pt(origin);
 
@@ -177,6 +268,24 @@ namespace HF::GraphGenerator {
 		return optional_real3();
 	}
 
+	optional_real3 ResolveHit(
+		const HitStruct<real_t>& res,
+		const real3& origin,
+		const real3& direction,
+		real_t node_z_tolerance,
+		HIT_FLAG flag,
+		const GeometryFlagMap& geometry_dict)
+	{
+		switch (geometry_dict.Mode) {
+		case GeometryFilterMode::OBSTACLES_ONLY:
+			return ResolveHitAs<GeometryFilterMode::OBSTACLES_ONLY>(res, origin, direction, node_z_tolerance, flag, geometry_dict);
+		case GeometryFilterMode::OBSTACLES_AND_FLOORS:
+			return ResolveHitAs<GeometryFilterMode::OBSTACLES_AND_FLOORS>(res, origin, direction, node_z_tolerance, flag, geometry_dict);
+		default:
+			return ResolveHitAs<GeometryFilterMode::ALL_INTERSECTIONS>(res, origin, direction, node_z_tolerance, flag, geometry_dict);
+		}
+	}
+
 	std::set<std::pair<int, int>> permutations(int limit) {
 		// Create a vector of all numbers between 1 and limit + 1, as well as their inverses
 		vector<int> steps;
@@ -215,89 +324,112 @@ namespace HF::GraphGenerator {
 		return out_directions;
 	}
 
-	vector<graph_edge> GetChildren(
-		const real3& parent,
-		const vector<real3>& possible_children,
-		RayTracer& rt,
-		const GraphParams& GP
-		)
+	bool OcclusionCheck(const real3& parent, const real3& child, RayTracer& RT)
 	{
-		std::vector<graph_edge> valid_edges;
+		// Use the distance between parent and child
+		// as the maximum distance for the occlusion check
+		return RT.Occluded(parent, DirectionTo(parent, child), DistanceTo(parent, child));
+	}
 
-		// Call CheckChildren to get rid of all children that aren't over valid ground or don't meet our upstep
-		// and downstep requirements. This array of children will also be moved directly ontop of the ground their over.
-		const auto checked_children = CheckChildren(parent, possible_children, rt, GP);
+	bool CheckSlope(const real3& parent, const real3& child, const GraphParams& gp)
+	{
+		// Slope is rise/run
+		const real_t run = sqrt(pow((parent[0] - child[0]), 2) + pow((parent[1] - child[1]), 2));
+		const real_t rise = child[2] - parent[2];
 
-		// Iterate through every child in the checked children
-		for (const auto& child : checked_children)
-		{
-			// Determine the type of connection between the parent and child
-			//  including if it is a step, slope, or not connected
-			const STEP connection_type = CheckConnection(parent, child, rt, GP);
+		// Calculate the angle between rise and run.
+		const real_t calc_slope = atan2(rise, run) * (static_cast<real_t>(180.00) / static_cast<real_t>(M_PI));
 
-			// If the node is connected Add it to out list of valid children
-			if (connection_type != STEP::NOT_CONNECTED)
-			{
-				// Add the edge to the array of children, storing the distance and connection type
-				valid_edges.emplace_back(graph_edge(ToNode(child), DistanceTo(parent, child), connection_type));
-			}
-		}
-		return valid_edges;
+		// Check against downslope and upslope.
+		return calc_slope > -1.0 * gp.down_slope && calc_slope < gp.up_slope;
 	}
 
-	std::vector<real3> CheckChildren(
-		const real3& parent,
-		const std::vector<real3>& possible_children,
-		RayTracer& rt,
-		const GraphParams& GP)
-	{
-		vector<real3> valid_children;
+	/*!
+		\brief Set up the ray used to check for a step based connection between parent and child.
 
-		// Iterate through every child in the set of possible children
-		for (const auto& child : possible_children)
-		{
+		\param parent Node that is being stepped from.
+		\param child Node that is being stepped to.
+		\param params Parameters containing the upstep, downstep and ground offset to use.
+		\param node1 Output for the origin of the step ray.
+		\param node2 Output for the end point of the step ray.
 
-			// Check if a ray intersects a mesh
-			optional_real3 potential_child = CheckRay(rt, child, down, GP.precision.node_z, HIT_FLAG::FLOORS, GP.geom_ids);
-			
-			if (potential_child)
-			{
-				// Get a reference to the child in the return value now that we know it's over valid ground
-				auto& confirmed_child = potential_child.pt;
+		\returns The type of step that will be taken if there is a line of sight between node1 and node2.
 
-				// TODO: this is a premature check and should be moved to the original calling function
-				//      after the step type check since upstep and downstep are parameters for stepping and not slope
+		\pre node1 and node2 contain parent and child offset from the ground by the ground offset.
+	*/
+	inline STEP SetupStepRay(
+		const real3& parent,
+		const real3& child,
+		const GraphParams& params,
+		real3& node1,
+		real3& node2)
+	{
+		const auto GROUND_OFFSET = params.precision.ground_offset;
 
-				// Check to see if the new position will satisfy up and downstep restrictions
-				real_t dstep = parent[2] - confirmed_child[2];
-				real_t ustep = confirmed_child[2] - parent[2];
+		STEP s = STEP::NONE;
+		// If parent is higher than child, the check is to go downstairs
+		// Since the child is lower, raise the child height by the downstep limit
+		// to be checked for a connection
+		if (parent[2] > child[2]) 
+		{
+			node1 = child;
+			node2 = parent;
+			node1[2] = node1[2] + params.down_step;
+			node2[2] = node2[2] + GROUND_OFFSET;
+			s = STEP::DOWN;
+		}
 
+		// If parent is lower than child, the check is to go upstairs
+		// Since the child is lower, raise the child height by the upstep limit
+		// to be checked for a connection
+		else if (node1[2] < node2[2]) 
+		{
+			node1 = parent;
+			node2 = child;
+			node1[2] = node1[2] + params.up_step;
+			node2[2] = node2[2] + GROUND_OFFSET;
+			s = STEP::UP;
+		}
 
-				if (dstep < GP.down_step && ustep < GP.up_step)
-					valid_children.push_back(confirmed_child);
-			}
+		// If they're on an equal plane then offset by upstep to see
+		// if the obstacle can be stepped over.
+		else if (node1[2] == node2[2]) 
+		{
+			node1 = parent;
+			node2 = child;
+			node1[2] = node1[2] + params.up_step;
+			node2[2] = node2[2] + GROUND_OFFSET;
+			s = STEP::OVER;
 		}
-		return valid_children;
+		return s;
 	}
 
-	bool OcclusionCheck(const real3& parent, const real3& child, RayTracer& RT)
-	{
-		// Use the distance between parent and child
-		// as the maximum distance for the occlusion check
-		return RT.Occluded(parent, DirectionTo(parent, child), DistanceTo(parent, child));
-	}
+	/*!
+		\brief Determine the connection type of a pair of nodes with a direct line of sight.
 
-	bool CheckSlope(const real3& parent, const real3& child, const GraphParams& gp)
+		\param parent Node that is being traversed from.
+		\param child Node that is being traversed to.
+		\param params Parameters containing the slope limits and ground offset to use.
+
+		\returns STEP::NONE if the nodes are on the same plane or the slope between them is within
+				 the limits in `params`. STEP::NOT_CONNECTED otherwise.
+	*/
+	inline STEP UnobstructedConnection(const real3& parent, const real3& child, const GraphParams& params)
 	{
-		// Slope is rise/run
-		const real_t run = sqrt(pow((parent[0] - child[0]), 2) + pow((parent[1] - child[1]), 2));
-		const real_t rise = child[2] - parent[2];
+		const auto GROUND_OFFSET = params.precision.ground_offset;
 
-		// Calculate the angle between rise and run.
-		const real_t calc_slope = atan2(rise, run) * (static_cast<real_t>(180.00) / static_cast<real_t>(M_PI));
+		// Offset the heights from the ground the same way as the line of sight ray
+		const real_t parent_z = parent[2] + GROUND_OFFSET;
+		const real_t child_z = child[2] + GROUND_OFFSET;
 
-		// Check against downslope and upslope.
-		return calc_slope > -1.0 * gp.down_slope && calc_slope < gp.up_slope;
+		// If there is a direct line of sight, and they're on the same plane
+		// then there is no step.
+		if (abs(parent_z - child_z) < GROUND_OFFSET) return STEP::NONE;
+
+		// If they are not on the same plane, it means this is a slope. Check if the slope is within the threshold.			
+		else if (CheckSlope(parent, child, params)) return STEP::NONE;
+
+		return STEP::NOT_CONNECTED;
 	}
 
 	HF::SpatialStructures::STEP CheckConnection(
@@ -318,54 +450,12 @@ namespace HF::GraphGenerator {
 		node2[2] += GROUND_OFFSET;
 
 		// See if there's a direct line of sight between parent and child
-		if (!OcclusionCheck(node1, node2, rt)) {
-			// If there is a direct line of sight, and they're on the same plane
-			// then there is no step.
-			if (abs(node1[2] - node2[2]) < GROUND_OFFSET) return STEP::NONE;
-
-			// If they are not on the same plane, it means this is a slope. Check if the slope is within the threshold.			
-			else if (CheckSlope(parent, child, params)) return STEP::NONE;
-
-			return STEP::NOT_CONNECTED;
-		}
+		if (!OcclusionCheck(node1, node2, rt))
+			return UnobstructedConnection(parent, child, params);
 
 		// Otherwise check for a step based connectiom
 		else {
-			STEP s = STEP::NONE;
-			// If parent is higher than child, the check is to go downstairs
-			// Since the child is lower, raise the child height by the downstep limit
-			// to be checked for a connection
-			if (parent[2] > child[2]) 
-			{
-				node1 = child;
-				node2 = parent;
-				node1[2] = node1[2] + params.down_step;
-				node2[2] = node2[2] + GROUND_OFFSET;
-				s = STEP::DOWN;
-			}
-
-			// If parent is lower than child, the check is to go upstairs
-			// Since the child is lower, raise the child height by the upstep limit
-			// to be checked for a connection
-			else if (node1[2] < node2[2]) 
-			{
-				node1 = parent;
-				node2 = child;
-				node1[2] = node1[2] + params.up_step;
-				node2[2] = node2[2] + GROUND_OFFSET;
-				s = STEP::UP;
-			}
-
-			// If they're on an equal plane then offset by upstep to see
-			// if the obstacle can be stepped over.
-			else if (node1[2] == node2[2]) 
-			{
-				node1 = parent;
-				node2 = child;
-				node1[2] = node1[2] + params.up_step;
-				node2[2] = node2[2] + GROUND_OFFSET;
-				s = STEP::OVER;
-			}
+			const STEP s = SetupStepRay(parent, child, params, node1, node2);
 
 			// If there is a line of sight then the nodes are connected
 			// with the step type we calculated
@@ -378,6 +468,327 @@ namespace HF::GraphGenerator {
 		return STEP::NOT_CONNECTED;
 	}
 
+	/*!
+		\brief Cast rays for the floor beneath a set of points using the walkable and non-walkable
+		geometry in separate scenes.
+
+		\param scenes Scenes to cast rays in.
+		\param origins Origin points of each ray.
+		\param directions Direction of each ray.
+		\param tolerance Other meshes within this distance of a floor are treated as being level with it.
+
+		\returns A HitStruct for every ray that hit a walkable mesh before any other mesh. Every other
+				 ray is returned as a miss.
+
+		\remarks
+		A mesh level with the floor, such as the bottom of an obstacle resting on it, never hides the floor.
+		When casting against the entire scene, which of the two is hit first depends on floating point error.
+
+		\see FloorScenes for details.
+	*/
+	inline vector<HitStruct<real_t>> CastFloorIntersections(
+		FloorScenes& scenes,
+		const vector<real3>& origins,
+		const vector<real3>& directions,
+		real_t tolerance)
+	{
+		auto results = scenes.floors.PacketIntersections<real_t>(origins, directions);
+
+		// Check for other geometry between the origin of every ray that hit a floor and the floor it hit
+		vector<int> hit_indices;
+		vector<real3> hit_origins, hit_directions;
+		vector<real_t> distances;
+		for (int i = 0; i < results.size(); i++) {
+			const real_t distance = results[i].distance - tolerance;
+			if (!results[i].DidHit() || distance <= 0) continue;
+
+			hit_indices.push_back(i);
+			hit_origins.push_back(origins[i]);
+			hit_directions.push_back(directions[i]);
+			distances.push_back(distance);
+		}
+
+		const auto occluded = scenes.others.PacketOcclusions(hit_origins, hit_directions, distances);
+		for (int j = 0; j < hit_indices.size(); j++)
+			if (occluded[j])
+				results[hit_indices[j]] = HitStruct<real_t>();
+
+		return results;
+	}
+
+	/*! \brief CheckChildren for a ray tracer and filter mode known at compile time. */
+	template <typename rt_type, GeometryFilterMode mode>
+	inline std::vector<real3> CheckChildrenAs(
+		const real3& parent,
+		const std::vector<real3>& possible_children,
+		rt_type& rt,
+		const GraphParams& GP,
+		CrawlCache* cache)
+	{
+		vector<real3> valid_children;
+
+		// Height of the floor under every child, or NAN if it isn't over valid ground
+		vector<real_t> floors(possible_children.size(), NAN);
+
+		// Look for every child in the cache first. Any child that isn't in it still needs a ray.
+		vector<HF::SpatialStructures::LatticeKey> keys;
+		vector<int> uncached;
+		uncached.reserve(possible_children.size());
+
+		if (cache) {
+			keys.resize(possible_children.size());
+			for (int i = 0; i < possible_children.size(); i++) {
+				const auto& child = possible_children[i];
+				keys[i] = cache->Lattice().Key(child[0], child[1], child[2]);
+
+				if (!cache->FindFloor(keys[i], floors[i]))
+					uncached.push_back(i);
+			}
+		}
+		else
+			for (int i = 0; i < possible_children.size(); i++)
+				uncached.push_back(i);
+
+		// Cast a ray straight down from every remaining child at once. All of these rays share
+		// a direction and are close together, so they can be traced as packets.
+		vector<real3> origins(uncached.size());
+		for (int j = 0; j < uncached.size(); j++)
+			origins[j] = possible_children[uncached[j]];
+
+		const vector<real3> directions(origins.size(), down);
+		vector<HitStruct<real_t>> results;
+		if constexpr (mode == GeometryFilterMode::OBSTACLES_AND_FLOORS)
+			results = GP.floor_scenes
+				? CastFloorIntersections(*GP.floor_scenes, origins, directions, GP.precision.node_z)
+				: CastIntersections(rt, origins, directions);
+		else
+			results = CastIntersections(rt, origins, directions);
+
+		for (int j = 0; j < uncached.size(); j++)
+		{
+			// Check if the ray intersected a mesh of the correct type
+			optional_real3 potential_child = ResolveHitAs<mode>(
+				results[j], origins[j], down, GP.precision.node_z, HIT_FLAG::FLOORS, GP.geom_ids
+			);
+
+			const int i = uncached[j];
+			if (potential_child)
+				floors[i] = potential_child.pt[2];
+
+			// Share the result with every other parent of this child
+			if (cache)
+				cache->InsertFloor(keys[i], floors[i]);
+		}
+
+		// Iterate through every child in the set of possible children
+		for (int i = 0; i < possible_children.size(); i++)
+		{
+			if (!std::isnan(floors[i]))
+			{
+				// Move the child directly on top of the ground it's over
+				const real3 confirmed_child{ possible_children[i][0], possible_children[i][1], floors[i] };
+
+				// TODO: this is a premature check and should be moved to the original calling function
+				//      after the step type check since upstep and downstep are parameters for stepping and not slope
+
+				// Check to see if the new position will satisfy up and downstep restrictions
+				real_t dstep = parent[2] - confirmed_child[2];
+				real_t ustep = confirmed_child[2] - parent[2];
+
+
+				if (dstep < GP.down_step && ustep < GP.up_step)
+					valid_children.push_back(confirmed_child);
+			}
+		}
+		return valid_children;
+	}
+
+	/*! \brief CheckConnections for a ray tracer known at compile time. */
+	template <typename rt_type>
+	inline std::vector<STEP> CheckConnectionsAs(
+		const real3& parent,
+		const std::vector<real3>& children,
+		rt_type& rt,
+		const GraphParams& params,
+		CrawlCache* cache)
+	{
+		const auto GROUND_OFFSET = params.precision.ground_offset;
+		const int n = children.size();
+
+		std::vector<STEP> out_steps(n, STEP::NOT_CONNECTED);
+
+		// Get the rays that were already cast for each connection when its child was the parent
+		vector<ConnectionRays> rays(n);
+		vector<HF::SpatialStructures::LatticeEdgeKey> keys;
+		vector<char> cached(n, false);
+		if (cache) {
+			keys.resize(n);
+			for (int i = 0; i < n; i++) {
+				keys[i] = cache->ConnectionKey(parent, children[i]);
+				cached[i] = cache->FindConnection(keys[i], rays[i]);
+			}
+		}
+
+		// Offset the parent and every child from the ground slightly, then build a
+		// line of sight ray between them for every child that doesn't have one yet
+		vector<real3> origins, directions;
+		vector<real_t> distances;
+		vector<int> los_indices;
+		vector<real3> offset_children(n);
+		auto offset_parent = parent;
+		offset_parent[2] += GROUND_OFFSET;
+
+		for (int i = 0; i < n; i++) {
+			offset_children[i] = children[i];
+			offset_children[i][2] += GROUND_OFFSET;
+
+			if (rays[i].line_of_sight != RAY_RESULT::UNKNOWN) continue;
+
+			los_indices.push_back(i);
+			origins.push_back(offset_parent);
+			directions.push_back(DirectionTo(offset_parent, offset_children[i]));
+			distances.push_back(DistanceTo(offset_parent, offset_children[i]));
+		}
+
+		// See if there's a direct line of sight between parent and every child
+		const auto los_occluded = CastOcclusions(rt, origins, directions, distances);
+		for (int j = 0; j < los_indices.size(); j++)
+			rays[los_indices[j]].line_of_sight = los_occluded[j] ? RAY_RESULT::OCCLUDED : RAY_RESULT::CLEAR;
+
+		// When the step limits are equal, stepping down to a node casts the same ray as stepping
+		// back up from it, so those can be shared. Stepping over is always cast from the parent.
+		const bool symmetric_steps = params.up_step == params.down_step;
+		auto is_shared_step = [symmetric_steps](STEP s) { return symmetric_steps && (s == STEP::UP || s == STEP::DOWN); };
+
+		// Children with a direct line of sight are connected by slope. Every other child
+		// needs a step ray, which are gathered and cast together afterwards.
+		vector<int> step_indices;
+		vector<STEP> step_types;
+		origins.clear(); directions.clear(); distances.clear();
+
+		for (int i = 0; i < n; i++) {
+			if (rays[i].line_of_sight == RAY_RESULT::CLEAR)
+				out_steps[i] = UnobstructedConnection(parent, children[i], params);
+			else {
+				auto node1 = offset_parent;
+				auto node2 = offset_children[i];
+				const STEP s = SetupStepRay(parent, children[i], params, node1, node2);
+
+				// Reuse the step ray from the other node if it was cast
+				if (is_shared_step(s) && rays[i].step != RAY_RESULT::UNKNOWN) {
+					if (rays[i].step == RAY_RESULT::CLEAR)
+						out_steps[i] = s;
+					continue;
+				}
+
+				step_types.push_back(s);
+				step_indices.push_back(i);
+
+				origins.push_back(node1);
+				directions.push_back(DirectionTo(node1, node2));
+				distances.push_back(DistanceTo(node1, node2));
+			}
+		}
+
+		// If there is a line of sight then the nodes are connected
+		// with the step type we calculated
+		if (!step_indices.empty()) {
+			const auto step_occluded = CastOcclusions(rt, origins, directions, distances);
+			for (int j = 0; j < step_indices.size(); j++) {
+				if (!step_occluded[j])
+					out_steps[step_indices[j]] = step_types[j];
+
+				if (is_shared_step(step_types[j]))
+					rays[step_indices[j]].step = step_occluded[j] ? RAY_RESULT::OCCLUDED : RAY_RESULT::CLEAR;
+			}
+		}
+
+		// Store the rays for every connection that wasn't already in the cache, so
+		// they can be reused when the child is checked as a parent
+		if (cache)
+			for (int i = 0; i < n; i++)
+				if (!cached[i])
+					cache->InsertConnection(keys[i], rays[i]);
+
+		return out_steps;
+	}
+
+	/*! \brief GetChildren for a ray tracer and filter mode known at compile time. */
+	template <typename rt_type, GeometryFilterMode mode>
+	inline vector<graph_edge> GetChildrenAs(
+		const real3& parent,
+		const vector<real3>& possible_children,
+		rt_type& rt,
+		const GraphParams& GP,
+		CrawlCache* cache
+		)
+	{
+		std::vector<graph_edge> valid_edges;
+
+		// Call CheckChildren to get rid of all children that aren't over valid ground or don't meet our upstep
+		// and downstep requirements. This array of children will also be moved directly ontop of the ground their over.
+		const auto checked_children = CheckChildrenAs<rt_type, mode>(parent, possible_children, rt, GP, cache);
+
+		// Determine the type of connection between the parent and every child
+		//  including if it is a step, slope, or not connected
+		const auto connection_types = CheckConnectionsAs(parent, checked_children, rt, GP, cache);
+
+		// Iterate through every child in the checked children
+		for (int i = 0; i < checked_children.size(); i++)
+		{
+			const auto& child = checked_children[i];
+			const STEP connection_type = connection_types[i];
+
+			// If the node is connected Add it to out list of valid children
+			if (connection_type != STEP::NOT_CONNECTED)
+			{
+				// Add the edge to the array of children, storing the distance and connection type
+				valid_edges.emplace_back(graph_edge(ToNode(child), DistanceTo(parent, child), connection_type));
+			}
+		}
+		return valid_edges;
+	}
+
+	vector<graph_edge> GetChildren(
+		const real3& parent,
+		const vector<real3>& possible_children,
+		RayTracer& rt,
+		const GraphParams& GP,
+		CrawlCache* cache
+		)
+	{
+		// Select the kernel once per parent so none of the rays it casts need to be dispatched
+		return DispatchKernel(rt, GP.geom_ids, [&](auto& tracer, auto mode) {
+			using tracer_type = std::remove_reference_t<decltype(tracer)>;
+			return GetChildrenAs<tracer_type, decltype(mode)::value>(parent, possible_children, tracer, GP, cache);
+		});
+	}
+
+	std::vector<real3> CheckChildren(
+		const real3& parent,
+		const std::vector<real3>& possible_children,
+		RayTracer& rt,
+		const GraphParams& GP,
+		CrawlCache* cache)
+	{
+		return DispatchKernel(rt, GP.geom_ids, [&](auto& tracer, auto mode) {
+			using tracer_type = std::remove_reference_t<decltype(tracer)>;
+			return CheckChildrenAs<tracer_type, decltype(mode)::value>(parent, possible_children, tracer, GP, cache);
+		});
+	}
+
+	std::vector<STEP> CheckConnections(
+		const real3& parent,
+		const std::vector<real3>& children,
+		RayTracer& rt,
+		const GraphParams& params,
+		CrawlCache* cache)
+	{
+		return DispatchRayTracer(rt, [&](auto& tracer) {
+			return CheckConnectionsAs(parent, children, tracer, params, cache);
+		});
+	}
+
 	std::vector<real3> GeneratePotentialChildren(
 		const real3& parent,
 		const std::vector<pair>& directions,
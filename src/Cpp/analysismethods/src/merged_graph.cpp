@@ -0,0 +1,105 @@
+///
+/// \file		merged_graph.cpp
+/// \brief		Contains implementation for the <see cref="HF::GraphGenerator::MergedGraph">MergedGraph</see> struct
+///
+///	\author		TBA
+///	\date		26 Jun 2020
+
+#include <merged_graph.h>
+#include <graph_sink.h>
+#include <graph.h>
+
+#include <algorithm>
+#include <cassert>
+#include <numeric>
+
+using HF::SpatialStructures::Graph;
+using HF::SpatialStructures::Node;
+using HF::SpatialStructures::NodeLattice;
+using HF::SpatialStructures::LatticeKey;
+
+using std::vector;
+
+namespace HF::GraphGenerator {
+
+	MergedGraph::MergedGraph(const NodeLattice& lattice) : lattice(lattice) {}
+
+	void MergedGraph::Add(const GraphChunk& chunk, vector<int>& local_indices, const GenerationBounds& owned)
+	{
+		assert(local_indices.size() == chunk.first_id);
+
+		for (const auto& node : chunk.nodes) {
+			const auto result = indices.emplace(lattice.Key(node), static_cast<int>(nodes.size()));
+			const int index = result.first->second;
+			if (result.second) {
+				nodes.push_back(node);
+				from_owner.push_back(false);
+				expanded.push_back(false);
+			}
+
+			// Positions found by different sources may differ slightly, so always use the owner's
+			if (!from_owner[index] && owned.Contains(node)) {
+				nodes[index] = node;
+				from_owner[index] = true;
+			}
+			local_indices.push_back(index);
+		}
+
+		for (int r = 0; r < chunk.parent_ids.size(); r++) {
+			const int parent = local_indices[chunk.parent_ids[r]];
+			if (expanded[parent] || !owned.Contains(nodes[parent])) continue;
+
+			expanded[parent] = true;
+			parents.push_back(parent);
+			for (int k = chunk.row_starts[r]; k < chunk.row_starts[r + 1]; k++) {
+				children.push_back(local_indices[chunk.children[k]]);
+				scores.push_back(chunk.scores[k]);
+			}
+			row_starts.push_back(children.size());
+		}
+	}
+
+	Graph MergedGraph::Assemble(bool order_by_key) const
+	{
+		if (nodes.empty()) return Graph();
+
+		vector<int> order(nodes.size());
+		std::iota(order.begin(), order.end(), 0);
+
+		// Sort nodes by their keys, so the IDs don't depend on the order sources were added in
+		if (order_by_key) {
+			vector<LatticeKey> keys(nodes.size());
+			for (int i = 0; i < nodes.size(); i++)
+				keys[i] = lattice.Key(nodes[i]);
+
+			std::sort(order.begin(), order.end(), [&keys](int a, int b) { return keys[a] < keys[b]; });
+		}
+
+		vector<int> ids(nodes.size());
+		vector<Node> sorted_nodes(nodes.size());
+		for (int i = 0; i < order.size(); i++) {
+			ids[order[i]] = i;
+			sorted_nodes[i] = nodes[order[i]];
+		}
+
+		// Count the edges of each parent, then sum them to find where each row begins
+		vector<int> outer_indices(nodes.size() + 1, 0);
+		for (int r = 0; r < parents.size(); r++)
+			outer_indices[ids[parents[r]] + 1] = row_starts[r + 1] - row_starts[r];
+		for (int i = 0; i < nodes.size(); i++)
+			outer_indices[i + 1] += outer_indices[i];
+
+		// Move each parent's edges to its row
+		vector<int> inner_indices(children.size());
+		vector<float> data(scores.size());
+		for (int r = 0; r < parents.size(); r++) {
+			const int row_start = outer_indices[ids[parents[r]]];
+			for (int k = row_starts[r]; k < row_starts[r + 1]; k++) {
+				inner_indices[row_start + k - row_starts[r]] = ids[children[k]];
+				data[row_start + k - row_starts[r]] = scores[k];
+			}
+		}
+
+		return Graph(sorted_nodes, std::move(outer_indices), std::move(inner_indices), std::move(data));
+	}
+}
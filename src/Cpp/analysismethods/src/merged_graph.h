@@ -0,0 +1,67 @@
+///
+/// \file		merged_graph.h
+/// \brief		Contains definitions for the <see cref="HF::GraphGenerator::MergedGraph">MergedGraph</see> struct
+///
+///	\author		TBA
+///	\date		26 Jun 2020
+
+#pragma once
+
+#include <graph_generator.h>
+#include <node.h>
+#include <robin_hood.h>
+
+#include <vector>
+
+namespace HF::GraphGenerator {
+	struct GraphChunk;
+
+	/*!
+		\brief Nodes and edges from several crawls, combined by their position on the lattice.
+
+		\details
+		Nodes are stored in the order they're first added, and edges refer to nodes by their index in
+		`nodes`. Each node has the edges of at most one parent, so the first source to add the edges
+		of a node decides them.
+
+		\see MergeTiles and RegenerateRegion for uses.
+	*/
+	struct MergedGraph {
+		HF::SpatialStructures::NodeLattice lattice;							///< Lattice shared by every source.
+		robin_hood::unordered_map<HF::SpatialStructures::LatticeKey, int> indices;	///< Index of each node in `nodes`.
+		std::vector<HF::SpatialStructures::Node> nodes;						///< Every node that has been added.
+		std::vector<char> from_owner;										///< Whether the position of each node came from its owner.
+		std::vector<char> expanded;											///< Whether the edges of each node have been added.
+
+		std::vector<int> parents;				///< Index of each parent with edges.
+		std::vector<int> row_starts{ 0 };		///< Index of each parent's first edge, followed by the number of edges.
+		std::vector<int> children;				///< Index of the child of each edge.
+		std::vector<float> scores;				///< Score of each edge.
+
+		/*! \brief Create an empty graph whose nodes are identified by their key on `lattice`. */
+		MergedGraph(const HF::SpatialStructures::NodeLattice& lattice);
+
+		/*!
+			\brief Add a chunk of nodes and edges.
+
+			\param chunk Chunk to add.
+			\param local_indices Index of every node in earlier chunks from the same source, by ID.
+								 The nodes of `chunk` are appended.
+			\param owned Bounds of the nodes owned by this source. Only the edges of these nodes
+						 are added, and only if edges haven't already been added for them. The
+						 position of a node is taken from the first source that owns it.
+		*/
+		void Add(const GraphChunk& chunk, std::vector<int>& local_indices, const GenerationBounds& owned = GenerationBounds());
+
+		/*!
+			\brief Create a graph from every node and edge.
+
+			\param order_by_key If true, nodes are ordered by their position on the lattice so the IDs don't
+								depend on the order that sources were added in. Otherwise, nodes are ordered
+								by when they were first added.
+
+			\returns A compressed graph, or an empty graph if no nodes were added.
+		*/
+		HF::SpatialStructures::Graph Assemble(bool order_by_key = false) const;
+	};
+}
@@ -0,0 +1,206 @@
+///
+/// \file		tiled_graph.cpp
+/// \brief		Contains implementation for generating a graph in independent tiles and merging the results
+///
+///	\author		TBA
+///	\date		26 Jun 2020
+
+#define NOMINMAX
+#include <tiled_graph.h>
+#include <graph_sink.h>
+#include <merged_graph.h>
+#include <graph.h>
+#include <node.h>
+#include <Constants.h>
+#include <HFExceptions.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+
+using HF::SpatialStructures::Graph;
+using HF::SpatialStructures::NodeLattice;
+using HF::SpatialStructures::roundhf_tmp;
+
+using std::vector;
+
+namespace HF::GraphGenerator {
+
+	/*!
+		\brief Restores the sink and bounds of a generator once it goes out of scope.
+
+		\details
+		Sinks used by tiles live on the stack, so the generator must stop pointing at them even if
+		a crawl throws.
+	*/
+	struct GeneratorOutputScope {
+		GraphGenerator& gg;			///< Generator to restore.
+		GraphSink* sink;			///< Sink of `gg` when the scope was created.
+		GenerationBounds bounds;	///< Bounds of `gg` when the scope was created.
+
+		GeneratorOutputScope(GraphGenerator& gg) : gg(gg), sink(gg.sink), bounds(gg.bounds) {}
+		~GeneratorOutputScope() {
+			gg.sink = sink;
+			gg.bounds = bounds;
+		}
+	};
+
+	vector<GraphTile> PlanTiles(
+		const GeneratorSettings& settings,
+		const GenerationBounds& domain,
+		int tile_cells,
+		int overlap_cells,
+		int seed_cells)
+	{
+		assert(tile_cells > 0 && seed_cells > 0 && overlap_cells >= 0);
+
+		// Nodes are placed on a lattice starting at the start point
+		const real_t origin_x = roundhf_tmp<real_t>(settings.start_point[0], settings.node_spacing_precision);
+		const real_t origin_y = roundhf_tmp<real_t>(settings.start_point[1], settings.node_spacing_precision);
+		const real_t step_x = settings.spacing[0];
+		const real_t step_y = settings.spacing[1];
+
+		// Find the range of columns and rows of the lattice in the domain
+		const int first_col = static_cast<int>(std::ceil((domain.min_x - origin_x) / step_x));
+		const int end_col = static_cast<int>(std::ceil((domain.max_x - origin_x) / step_x));
+		const int first_row = static_cast<int>(std::ceil((domain.min_y - origin_y) / step_y));
+		const int end_row = static_cast<int>(std::ceil((domain.max_y - origin_y) / step_y));
+
+		vector<GraphTile> tiles;
+		for (int r0 = first_row; r0 < end_row; r0 += tile_cells) {
+			for (int c0 = first_col; c0 < end_col; c0 += tile_cells) {
+				const int r1 = std::min(r0 + tile_cells, end_row);
+				const int c1 = std::min(c0 + tile_cells, end_col);
+
+				GraphTile tile;
+				tile.index = tiles.size();
+
+				// Place the edges of the core halfway between nodes
+				tile.core.min_x = origin_x + (c0 - 0.5) * step_x;
+				tile.core.max_x = origin_x + (c1 - 0.5) * step_x;
+				tile.core.min_y = origin_y + (r0 - 0.5) * step_y;
+				tile.core.max_y = origin_y + (r1 - 0.5) * step_y;
+
+				tile.clip.min_x = tile.core.min_x - overlap_cells * step_x;
+				tile.clip.max_x = tile.core.max_x + overlap_cells * step_x;
+				tile.clip.min_y = tile.core.min_y - overlap_cells * step_y;
+				tile.clip.max_y = tile.core.max_y + overlap_cells * step_y;
+
+				// Prefer the start point, since it's known to be on the ground the user wants
+				if (tile.core.Contains(settings.start_point))
+					tile.seeds.push_back(settings.start_point);
+
+				// Spread the rest of the seeds evenly across the core
+				for (int r = r0 + std::min(seed_cells, r1 - r0) / 2; r < r1; r += seed_cells)
+					for (int c = c0 + std::min(seed_cells, c1 - c0) / 2; c < c1; c += seed_cells)
+						tile.seeds.push_back(real3{
+							origin_x + c * step_x,
+							origin_y + r * step_y,
+							settings.start_point[2]
+						});
+
+				tiles.push_back(tile);
+			}
+		}
+		return tiles;
+	}
+
+	void GenerateTile(
+		GraphGenerator& gg,
+		const GeneratorSettings& settings,
+		const GraphTile& tile,
+		const std::string& path)
+	{
+		GeneratorOutputScope scope(gg);
+		gg.sink = nullptr;
+		gg.bounds = tile.clip;
+		const optional_real3 start = gg.SetupParameters(settings);
+
+		// Only seeds above the ground can be crawled from. If the start point of the graph
+		// isn't above the ground, then no tile has any nodes.
+		vector<real3> seeds;
+		if (start) {
+			for (const auto& seed : tile.seeds) {
+				const real3 rounded{
+					roundhf_tmp<real_t>(seed[0], gg.params.precision.node_spacing),
+					roundhf_tmp<real_t>(seed[1], gg.params.precision.node_spacing),
+					roundhf_tmp<real_t>(seed[2], gg.params.precision.node_z)
+				};
+				const optional_real3 checked = ValidateStartPoint(gg.ray_tracer, rounded, gg.params);
+				if (checked) seeds.push_back(*checked);
+			}
+		}
+
+		// Write to a temporary file so that path only exists once the tile is complete
+		const std::string temp_path = path + ".part";
+		std::remove(temp_path.c_str());
+		{
+			FileGraphSink file(temp_path);
+			if (!seeds.empty()) {
+				gg.sink = &file;
+				gg.CrawlFromSeeds(*start, seeds);
+			}
+		}
+
+		std::remove(path.c_str());
+		if (std::rename(temp_path.c_str(), path.c_str()) != 0)
+			throw HF::Exceptions::FileNotFound();
+	}
+
+	Graph MergeTiles(
+		GraphGenerator& gg,
+		const GeneratorSettings& settings,
+		const vector<GraphTile>& tiles,
+		const vector<std::string>& paths)
+	{
+		assert(tiles.size() == paths.size());
+
+		GeneratorOutputScope scope(gg);
+		gg.sink = nullptr;
+		gg.bounds = GenerationBounds();
+		const optional_real3 start = gg.SetupParameters(settings);
+		if (!start) return Graph();
+
+		MergedGraph merged(NodeLattice(*start, { gg.spacing[0], gg.spacing[1], gg.params.precision.node_z }));
+
+		// Add every tile in order of its index, keeping only the edges of nodes it owns
+		for (int t = 0; t < tiles.size(); t++) {
+			vector<int> local_indices;
+			ReadGraphChunks(paths[t], [&](const GraphChunk& chunk) {
+				merged.Add(chunk, local_indices, tiles[t].core);
+			});
+		}
+
+		// The domain is the union of every tile's core
+		GenerationBounds domain{ INFINITY, INFINITY, -INFINITY, -INFINITY };
+		for (const auto& tile : tiles) {
+			domain.min_x = std::min(domain.min_x, tile.core.min_x);
+			domain.min_y = std::min(domain.min_y, tile.core.min_y);
+			domain.max_x = std::max(domain.max_x, tile.core.max_x);
+			domain.max_y = std::max(domain.max_y, tile.core.max_y);
+		}
+
+		// Nodes in the domain that were never expanded by their owner are on the border between
+		// tiles. Crawl once more from these nodes, without expanding any node that already was.
+		vector<real3> border, visited;
+		for (int i = 0; i < merged.nodes.size(); i++) {
+			if (merged.expanded[i])
+				visited.push_back(CastToReal3(merged.nodes[i]));
+			else if (domain.Contains(merged.nodes[i]))
+				border.push_back(CastToReal3(merged.nodes[i]));
+		}
+
+		if (!border.empty()) {
+			vector<int> local_indices;
+			CallbackGraphSink sink([&](const GraphChunk& chunk) {
+				merged.Add(chunk, local_indices, domain);
+			});
+
+			gg.bounds = domain;
+			gg.sink = &sink;
+			gg.CrawlFromSeeds(*start, border, visited);
+		}
+
+		return merged.Assemble(true);
+	}
+}
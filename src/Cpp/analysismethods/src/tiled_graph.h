@@ -0,0 +1,115 @@
+///
+/// \file		tiled_graph.h
+/// \brief		Contains definitions for generating a graph in independent tiles and merging the results
+///
+///	\author		TBA
+///	\date		26 Jun 2020
+
+#pragma once
+
+#include <graph_generator.h>
+
+#include <string>
+#include <vector>
+
+namespace HF::GraphGenerator {
+
+	/*!
+		\brief A section of the domain of a graph that can be generated independently.
+
+		\details
+		Every node in the domain is owned by exactly one tile, the one whose core contains it. A tile
+		is crawled from its seeds, and may expand nodes up to `overlap` cells past its core so paths
+		that leave the core and come back are still found. Only the edges of nodes in the core are
+		kept when tiles are merged.
+	*/
+	struct GraphTile {
+		int index;					///< Index of this tile in the plan.
+		GenerationBounds core;		///< Nodes owned by this tile.
+		GenerationBounds clip;		///< Nodes that this tile is allowed to expand. Contains `core`.
+		std::vector<real3> seeds;	///< Points to start the crawl of this tile from, before they're checked for ground.
+	};
+
+	/*!
+		\brief Split a domain into a grid of tiles.
+
+		\param settings Settings of the graph. Tiles are aligned to the lattice of its start point.
+		\param domain Area to generate a graph in. Must be finite.
+		\param tile_cells Width of each tile in nodes.
+		\param overlap_cells Number of nodes that each tile can expand past the edges of its core.
+		\param seed_cells Number of nodes between the seeds of each tile, on both axes.
+
+		\returns Tiles covering every node of the lattice within `domain`, in row major order.
+
+		\details
+		The edges of each tile lie halfway between nodes, so every node is in the core of exactly one
+		tile. Seeds are placed at the height of the start point. If the start point is in a tile's core,
+		it's used as that tile's first seed.
+
+		\remarks The plan only depends on its arguments, so every process working on a graph can
+		create the same plan independently, and then generate the tiles assigned to it by index.
+	*/
+	std::vector<GraphTile> PlanTiles(
+		const GeneratorSettings& settings,
+		const GenerationBounds& domain,
+		int tile_cells,
+		int overlap_cells = 2,
+		int seed_cells = 8
+	);
+
+	/*!
+		\brief Generate a single tile and write it to a file.
+
+		\param gg Graph generator to use. Its `bounds` and `sink` are restored before returning, even if an exception is thrown.
+		\param settings Settings of the graph. Must be the same for every tile.
+		\param tile Tile to generate.
+		\param path File to write the tile to in the format of FileGraphSink.
+
+		\details
+		The tile is first written to a temporary file next to `path`, and only moved to `path` once
+		it's complete. If a process fails partway through a tile, `path` won't exist, so the tile can
+		be generated again without affecting any other tile.
+
+		\throws HF::Exceptions::FileNotFound if the file couldn't be written.
+	*/
+	void GenerateTile(
+		GraphGenerator& gg,
+		const GeneratorSettings& settings,
+		const GraphTile& tile,
+		const std::string& path
+	);
+
+	/*!
+		\brief Merge tiles written by GenerateTile into a single graph.
+
+		\param gg Graph generator to use for re-checking the borders of tiles. Its `bounds` and `sink` are
+		restored before returning, even if an exception is thrown.
+		\param settings Settings of the graph. Must be the same as those used to generate every tile.
+		\param tiles Every tile in the plan.
+		\param paths Path that each tile in `tiles` was written to.
+
+		\returns A graph containing the nodes and edges of every tile.
+
+		\details
+		Nodes found by more than one tile are identified by their position on the lattice, and the
+		position found by the tile that owns them is kept. Only the edges found by the owner of each
+		node are kept. Nodes that were reached by a tile but never expanded by their owner, such as
+		nodes that the owner's seeds couldn't reach within its clip bounds, are checked once more
+		after every tile is merged.
+
+		Nodes are given IDs in order of their position on the lattice, so the result only depends on
+		the plan, regardless of which process generated each tile or how many times it was generated.
+
+		\remarks
+		Every node that is reachable from any seed is included, so regions that can't be reached from
+		the start point may be part of the graph if a seed is placed on them.
+
+		\throws HF::Exceptions::FileNotFound if any tile's file couldn't be read.
+	*/
+	SpatialStructures::Graph MergeTiles(
+		GraphGenerator& gg,
+		const GeneratorSettings& settings,
+		const std::vector<GraphTile>& tiles,
+		const std::vector<std::string>& paths
+	);
+}
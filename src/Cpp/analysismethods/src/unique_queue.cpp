@@ -8,16 +8,21 @@
 #include <unique_queue.h>
 
 namespace HF::GraphGenerator{
+	UniqueQueue::UniqueQueue(const HF::SpatialStructures::NodeLattice& lattice) : lattice(lattice) {}
+
+	const HF::SpatialStructures::NodeLattice& UniqueQueue::Lattice() const { return lattice; }
+
 	bool UniqueQueue::push(const HF::SpatialStructures::Node& p)
 	{
 		// Only insert if it's not set to 1
-		if (hashmap[p])
+		int& seen = hashmap[lattice.Key(p)];
+		if (seen)
 			return false;
 
 		// Push it to the end of the queue, then 
 		// mark it in the hashmap.
 		node_queue.push(p);
-		hashmap[p] = 1;
+		seen = 1;
 		
 		return true;
 	}
@@ -36,18 +41,18 @@ namespace HF::GraphGenerator{
 		node_queue.pop();
 
 		// Erase r from the hashmap to "forget" about it
-		hashmap.erase(r);
+		hashmap.erase(lattice.Key(r));
 		return r;
 	}
 
 	bool UniqueQueue::hasNode(const HF::SpatialStructures::Node& p) const {
-		return hashmap.count(p) > 0;
+		return hashmap.count(lattice.Key(p)) > 0;
 	}
 
 	bool UniqueQueue::forcePush(const HF::SpatialStructures::Node& p) {
 		// Forcibly set this to 1. Will have no effect
 		// if we've already seen this node.
-		hashmap[p] = 1;
+		hashmap[lattice.Key(p)] = 1;
 
 		node_queue.push(p);
 		return true;
@@ -35,9 +35,29 @@ namespace HF::GraphGenerator {
 			Values of 0 indicate that a node has never been pushed before.
 			Values of 1 indicate that a node has already been in the hashmap previously.
 		*/
-		robin_hood::unordered_map<HF::SpatialStructures::Node, int> hashmap;
+		robin_hood::unordered_map<HF::SpatialStructures::LatticeKey, int> hashmap;
+
+		HF::SpatialStructures::NodeLattice lattice; ///< Lattice used to convert nodes to keys for hashmap
 
 	public:
+		/*! 
+			\brief Create an empty queue that identifies nodes at the precision of DHART_API. 
+
+			\see HF::SpatialStructures::NodeLattice::NodeLattice() for the default lattice.
+		*/
+		UniqueQueue() = default;
+
+		/*!
+			\brief Create an empty queue that identifies nodes by their position on a specific lattice.
+
+			\param lattice Lattice to quantize nodes with. Any two nodes that are snapped to the same
+							point on this lattice will be considered the same node.
+		*/
+		UniqueQueue(const HF::SpatialStructures::NodeLattice& lattice);
+
+		/*! \brief Get the lattice used to identify nodes in this queue. */
+		const HF::SpatialStructures::NodeLattice& Lattice() const;
+
 
 		/// <summary> Add a node to the queue if it has never previously been in the queue. </summary>
 		/// <param name="p"> Node to add to the queue. </param>
@@ -6,6 +6,7 @@
 ///	\date		17 Jun 2020
 
 #include <boost_graph.h>
+#include <path_hierarchy.h>
 
 #include <graph.h>
 #include <node.h>
@@ -64,6 +65,9 @@ namespace HF::Pathfinding {
 		// Resize predecessor and distance arrays to maximum size.
 		p.resize(n);
 		d.resize(n);
+
+		// Plan paths on the graph's hierarchy for this cost type if it has one
+		hierarchy = graph.GetPathHierarchy(cost_type);
 	}
 
 	BoostGraph::~BoostGraph() = default;
@@ -12,6 +12,9 @@
 #include <boost/graph/compressed_sparse_row_graph.hpp>
 #include <boost/graph/adjacency_list.hpp>
 
+#include <memory>
+#include <string>
+
 
 // Define a hash function for arrays of 3 floats.
 namespace std {
@@ -91,6 +94,8 @@ namespace HF {
 	}
 
 	namespace Pathfinding {
+		class PathHierarchy;
+
 		// Note: These structs and typedefs are used to simplify creation and usage of the boost
 		// graph and serve no purpose outside of that.
 
@@ -168,6 +173,9 @@ namespace HF {
 			graph_t g;							///< The underlying graph in boost.
 			std::vector<vertex_descriptor> p;	///< Vertex array preallocated to the number of nodes in the graph.
 			std::vector<double> d;				///< Distance array preallocated to the number of nodes in the graph.
+			/// Abstract graph that FindPath, FindPaths, and InsertPathsIntoArray plan paths on if set. Taken
+			/// from the graph this was created from. \see EnablePathHierarchy
+			std::shared_ptr<const PathHierarchy> hierarchy;
 
 			/// <summary> Create a boost graph from a HF::SpatialStructures::Graph. </summary>
 			/*!
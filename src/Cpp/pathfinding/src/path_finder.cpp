@@ -15,6 +15,7 @@
 #include<math.h>
 #include<execution>
 #include <memory>
+#include <stdexcept>
 
 #include <boost/graph/dijkstra_shortest_paths.hpp>
 #include <boost/graph/breadth_first_search.hpp>
@@ -23,6 +24,7 @@
 #include <boost/math/special_functions/fpclassify.hpp>
 
 #include <boost_graph.h>
+#include <path_hierarchy.h>
 #include <path.h>
 
 using namespace HF::SpatialStructures;
@@ -163,8 +165,22 @@ namespace HF::Pathfinding {
 		return dist_pred;
 	}
 
+	void EnablePathHierarchy(Graph& graph, float cluster_size, const std::string& cost_type)
+	{
+		if (cluster_size < 0)
+			throw std::out_of_range("The size of clusters can't be negative!");
+
+		if (cluster_size == 0)
+			graph.SetPathHierarchy(nullptr, cost_type);
+		else
+			graph.SetPathHierarchy(std::make_shared<const PathHierarchy>(graph, cluster_size, cost_type), cost_type);
+	}
+
 	Path FindPath(BoostGraph* bg, int start_id, int end_id)
 	{
+		if (bg->hierarchy)
+			return bg->hierarchy->FindPath(start_id, end_id);
+
 		// Get a reference to the graph contained by this boost graph
 		const graph_t& graph = bg->g;
 		
@@ -180,6 +196,15 @@ namespace HF::Pathfinding {
 		// Get the graph from bg
 		const graph_t& graph = bg->g;
 		vector<Path> paths(start_points.size());
+
+		// Paths on the hierarchy don't share any work, so find each of them separately
+		if (bg->hierarchy) {
+			const PathHierarchy& hierarchy = *bg->hierarchy;
+#pragma omp parallel for schedule(dynamic)
+			for (int i = 0; i < start_points.size(); i++)
+				paths[i] = hierarchy.FindPath(start_points[i], end_points[i]);
+			return paths;
+		}
 		
 		// Generate predecessor matrices for every unique start point
 		robin_hood::unordered_map<int, DistPred> dpm;
@@ -215,24 +240,29 @@ namespace HF::Pathfinding {
 		int cores_to_use = std::min(core_count-1, static_cast<int>(start_points.size()));
 		omp_set_num_threads(cores_to_use);
 
-		// Copy and sort the input array of starting points
-		std::vector<int> start_copy = start_points;
-		std::sort(std::execution::par_unseq, start_copy.begin(),start_copy.end());
+		// Paths on the hierarchy don't share any work, so they don't need predecessor matrices
+		const PathHierarchy* hierarchy = bg->hierarchy.get();
+
+		if (!hierarchy) {
+			// Copy and sort the input array of starting points
+			std::vector<int> start_copy = start_points;
+			std::sort(std::execution::par_unseq, start_copy.begin(),start_copy.end());
 		
-		// Remove all duplicates, effectively creating an array of unique start ids
-		std::vector<int> unique_starts;
-		std::unique_copy(start_copy.begin(), start_copy.end(), std::back_inserter(unique_starts));
-
-		// Preallocate entries for the hash map in sequence so we don't corrupt the heap trying to
-		// add elements in parallel.
-		for (auto uc : unique_starts)
-			dpm.emplace(std::pair<int, DistPred>{uc, DistPred()});
-
-		// Build predecessor and distance matrices for each unique start point in parallel
-	#pragma omp parallel for schedule(dynamic) if (unique_starts.size() > cores_to_use && cores_to_use > 4)
-		for (int i = 0; i < unique_starts.size(); i++) {
-			int start_point = unique_starts[i];
-			dpm[start_point] = BuildDistanceAndPredecessor(graph, start_point);
+			// Remove all duplicates, effectively creating an array of unique start ids
+			std::vector<int> unique_starts;
+			std::unique_copy(start_copy.begin(), start_copy.end(), std::back_inserter(unique_starts));
+
+			// Preallocate entries for the hash map in sequence so we don't corrupt the heap trying to
+			// add elements in parallel.
+			for (auto uc : unique_starts)
+				dpm.emplace(std::pair<int, DistPred>{uc, DistPred()});
+
+			// Build predecessor and distance matrices for each unique start point in parallel
+		#pragma omp parallel for schedule(dynamic) if (unique_starts.size() > cores_to_use && cores_to_use > 4)
+			for (int i = 0; i < unique_starts.size(); i++) {
+				int start_point = unique_starts[i];
+				dpm[start_point] = BuildDistanceAndPredecessor(graph, start_point);
+			}
 		}
 
 		// Create paths in parallel.
@@ -243,11 +273,14 @@ namespace HF::Pathfinding {
 			int start = start_points[i];
 			int end = end_points[i];
 
-			// Get a reference to the distance and predecessor array for this start point.
-			const auto& dist_pred = dpm[start];
-
-			// Construct the shortest path, store a point for it in out_paths at index i
-			out_paths[i] = new Path(ConstructShortestPathFromPred(start, end, dist_pred));
+			// Construct the path, store a point for it in out_paths at index i
+			if (hierarchy)
+				out_paths[i] = new Path(hierarchy->FindPath(start, end));
+			else {
+				// Get a reference to the distance and predecessor array for this start point.
+				const auto& dist_pred = dpm[start];
+				out_paths[i] = new Path(ConstructShortestPathFromPred(start, end, dist_pred));
+			}
 
 			// Store a pointer to that path's PathMembers in out_path_members
 			out_path_members[i] = out_paths[i]->GetPMPointer();
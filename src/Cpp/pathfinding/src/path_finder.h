@@ -167,6 +167,53 @@ namespace HF {
 			const HF::SpatialStructures::Graph & g,
 			const std::string & cost_type = ""
 		);
+
+		/*!
+			\brief Build a PathHierarchy for a graph, and store it in the graph for pathfinding to use.
+
+			\param graph Graph to build the hierarchy for.
+			\param cluster_size Length of the sides of the cube each cluster of the hierarchy covers. Paths
+								between clusters are planned on the hierarchy, then found inside each cluster.
+								Pass 0 to remove the hierarchy and search the whole graph again.
+			\param cost_type Cost type of `graph` to build the hierarchy for. Leave blank to use the cost type
+							 the graph was constructed with.
+
+			\details
+			The hierarchy is stored in `graph` by its cost type. Boost graphs created from `graph` with the same
+			cost type afterwards take the hierarchy, so FindPath, FindPaths and InsertPathsIntoArray plan paths
+			on it, including those called through the C interface. The graph discards the hierarchy as soon as
+			any of its edges or costs change, and every later search covers the whole graph until this is called
+			again.
+
+			\pre `graph` must be compressed.
+
+			\throws std::out_of_range if `cluster_size` is negative.
+			\throws HF::Exceptions::NoCost if `cost_type` is not blank and isn't a cost type of `graph`.
+
+			\remarks
+			Build a hierarchy for large graphs where paths cross a large part of the graph. Paths found through
+			the hierarchy must pass through the portals between clusters, so their cost may be slightly higher
+			than the cost of the shortest path. Larger clusters give paths closer to the shortest path, but take
+			longer to search.
+
+			\see PathHierarchy for details on how paths are found on the hierarchy.
+
+			\code
+				// be sure to #include "path_finder.h", #include "boost_graph.h", and #include "graph.h"
+
+				// Plan paths on a compressed graph g through clusters of 10 meters
+				HF::Pathfinding::EnablePathHierarchy(g, 10.0f);
+
+				// Boost graphs created from g now use the hierarchy
+				auto boostGraph = HF::Pathfinding::CreateBoostGraph(g);
+				HF::SpatialStructures::Path path = HF::Pathfinding::FindPath(boostGraph.get(), 0, 3);
+			\endcode
+		*/
+		void EnablePathHierarchy(
+			HF::SpatialStructures::Graph & graph,
+			float cluster_size,
+			const std::string & cost_type = ""
+		);
 		
 		/// <summary> Find a path between points A and B using Dijkstra's Shortest Path algorithm. </summary>
 		/// <param name="bg"> The boost graph containing edges/nodes. </param>
@@ -180,10 +227,15 @@ namespace HF {
 			node B is reached. This algorithm is implemented using dijkstra_shortest_path from the BoostGraphLibrary
 			https://www.boost.org/doc/libs/1_73_0/libs/graph/doc/dijkstra_shortest_paths_no_color_map.html
 
+			If `bg` has a hierarchy, the path is planned on the hierarchy instead, and may cost slightly more
+			than the shortest path.
+
 			\note 
 			Use FindPaths for multiple paths as it's able to reuse a lot of work compared to running this in a
 			loop.
 
+			\see EnablePathHierarchy to plan long paths on a hierarchy.
+
 			\code
 				// be sure to #include "path_finder.h", #include "boost_graph.h", and #include "graph.h"
 
@@ -225,7 +277,8 @@ namespace HF {
 			\details
 			More efficient than calling FindPath manually in a loop. Sorts paths by starting point,
 			calculates only one predecessor matrix per unique starting point, then finds a
-			path for every pair. 
+			path for every pair. If `bg` has a hierarchy, every path is found on the hierarchy
+			in parallel instead.
 
 			\pre Length of start_points must match that of end_points.
 			
@@ -338,6 +391,9 @@ namespace HF {
 			\post 2) out_paths will point to a vector of pointers to paths with an element for every path.
 			\post 3) out_sizes will point to an array of integers containing the size of every path in out_paths
 
+			\details If `bg` has a hierarchy, every path is found on the hierarchy instead of building predecessor
+			matrices. \see EnablePathHierarchy
+
 			\remarks 
 			Usually the C-Interface is able to simply wrap existing functions with minimal code to make them accessible to exernal
 			callers, however in this specific situation there were real performance gains to be found by implementing this function
@@ -0,0 +1,448 @@
+///
+///	\file		path_hierarchy.cpp
+/// \brief		Contains implementation for the <see cref="HF::Pathfinding::PathHierarchy">PathHierarchy</see> class
+///
+///	\author		TBA
+///	\date		26 Jun 2020
+///
+
+#include <path_hierarchy.h>
+
+#include <graph.h>
+#include <node.h>
+#include <Edge.h>
+#include <path.h>
+#include <robin_hood.h>
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <functional>
+#include <limits>
+#include <numeric>
+#include <queue>
+#include <stdexcept>
+#include <tuple>
+
+using HF::SpatialStructures::Graph;
+using HF::SpatialStructures::Node;
+using HF::SpatialStructures::NodeLattice;
+using HF::SpatialStructures::LatticeKey;
+using HF::SpatialStructures::Path;
+using std::vector;
+
+namespace HF::Pathfinding {
+
+	constexpr float infinity = std::numeric_limits<float>::infinity();
+
+	/// \brief Number of border nodes an entrance must have to get portals at its ends as well as its center.
+	constexpr int wide_entrance = 6;
+
+	/*! \brief A node settled by a search, and the edge that it was reached through. */
+	struct Visit {
+		float distance;	///< Cost of the shortest path between the node and the source of the search.
+		int next;		///< Node on the other end of the edge to this node, or -1 for the source.
+		float cost;		///< Cost of the edge to this node.
+	};
+
+	/// \brief Every node settled by a search.
+	using Visits = robin_hood::unordered_map<int, Visit>;
+
+	/// \brief A queue of nodes by their distance, with the nearest node on top.
+	using Frontier = std::priority_queue<
+		std::pair<float, int>,
+		vector<std::pair<float, int>>,
+		std::greater<std::pair<float, int>>
+	>;
+
+	/*!
+		\brief Run Dijkstra's algorithm from a node without leaving its cluster, or a second cluster.
+
+		\param offsets Index of the first edge of each node in `nodes`.
+		\param nodes Node on the other end of every edge.
+		\param costs Cost of every edge.
+		\param cluster_of Cluster of every node.
+		\param source Node to start the search from.
+		\param other_cluster Another cluster that the search may enter, or -1 to stay in the cluster of `source`.
+		\param target Node to stop the search at once it's settled, or -1 to settle every node it can reach.
+
+		\returns Every node that was settled. Following `next` from any of them
+				 leads back to `source`.
+	*/
+	inline Visits SearchCluster(
+		const vector<int>& offsets,
+		const vector<int>& nodes,
+		const vector<float>& costs,
+		const vector<int>& cluster_of,
+		int source,
+		int other_cluster = -1,
+		int target = -1)
+	{
+		const int cluster = cluster_of[source];
+
+		Visits settled;
+		Visits tentative;
+		Frontier frontier;
+		tentative.emplace(source, Visit{ 0, -1, 0 });
+		frontier.emplace(0.0f, source);
+
+		while (!frontier.empty()) {
+			const auto [distance, node] = frontier.top();
+			frontier.pop();
+
+			const auto visit = tentative.find(node);
+			if (visit == tentative.end() || visit->second.distance < distance) continue;
+			settled.emplace(node, visit->second);
+			tentative.erase(visit);
+			if (node == target) break;
+
+			for (int k = offsets[node]; k < offsets[node + 1]; k++) {
+				const int neighbor = nodes[k];
+				if ((cluster_of[neighbor] != cluster && cluster_of[neighbor] != other_cluster)
+					|| settled.count(neighbor) > 0) continue;
+
+				const float new_distance = distance + costs[k];
+				const auto existing = tentative.find(neighbor);
+				if (existing != tentative.end() && existing->second.distance <= new_distance) continue;
+
+				tentative[neighbor] = Visit{ new_distance, node, costs[k] };
+				frontier.emplace(new_distance, neighbor);
+			}
+		}
+		return settled;
+	}
+
+	/*!
+		\brief Append the nodes of a path found by a forward search to a list of nodes and costs.
+
+		\param visits Result of a search over the outgoing edges of each node.
+		\param end Last node of the path. Must have been settled by the search.
+		\param out_nodes Nodes of the path so far. The last node must be the source of the search.
+		\param out_costs Cost of the edge from each node in `out_nodes` to the next. The last cost is 0.
+	*/
+	inline void AppendForward(const Visits& visits, int end, vector<int>& out_nodes, vector<float>& out_costs) {
+		// The nodes are found from the end back to the source
+		vector<std::pair<int, float>> nodes;
+		for (int node = end; visits.at(node).next >= 0; node = visits.at(node).next)
+			nodes.emplace_back(node, visits.at(node).cost);
+
+		for (auto node = nodes.rbegin(); node != nodes.rend(); ++node) {
+			out_costs.back() = node->second;
+			out_nodes.push_back(node->first);
+			out_costs.push_back(0);
+		}
+	}
+
+	/*!
+		\brief Append the nodes of a path found by a search over incoming edges to a list of nodes and costs.
+
+		\param visits Result of a search over the incoming edges of each node.
+		\param start First node of the path. Must be the last node of `out_nodes`.
+		\param out_nodes Nodes of the path so far.
+		\param out_costs Cost of the edge from each node in `out_nodes` to the next. The last cost is 0.
+	*/
+	inline void AppendBackward(const Visits& visits, int start, vector<int>& out_nodes, vector<float>& out_costs) {
+		for (int node = start; visits.at(node).next >= 0; node = visits.at(node).next) {
+			out_costs.back() = visits.at(node).cost;
+			out_nodes.push_back(visits.at(node).next);
+			out_costs.push_back(0);
+		}
+	}
+
+	PathHierarchy::PathHierarchy(const Graph& graph, float cluster_size, const std::string& cost_type)
+	{
+		if (!(cluster_size > 0))
+			throw std::out_of_range("The size of clusters must be greater than 0!");
+
+		const auto edge_sets = graph.GetEdges(cost_type);
+		const vector<Node> nodes = graph.Nodes();
+		const int num_nodes = std::max(static_cast<int>(edge_sets.size()), graph.MaxID() + 1);
+
+		// Store every usable edge in both directions
+		offsets.assign(num_nodes + 1, 0);
+		reverse_offsets.assign(num_nodes + 1, 0);
+		for (const auto& edge_set : edge_sets)
+			for (const auto& edge : edge_set.children)
+				if (std::isfinite(edge.weight) && edge.weight >= 0) {
+					offsets[edge_set.parent + 1]++;
+					reverse_offsets[edge.child + 1]++;
+				}
+		std::partial_sum(offsets.begin(), offsets.end(), offsets.begin());
+		std::partial_sum(reverse_offsets.begin(), reverse_offsets.end(), reverse_offsets.begin());
+
+		targets.resize(offsets.back());
+		weights.resize(offsets.back());
+		sources.resize(reverse_offsets.back());
+		reverse_weights.resize(reverse_offsets.back());
+		vector<int> forward_fill(offsets.begin(), offsets.end() - 1);
+		vector<int> reverse_fill(reverse_offsets.begin(), reverse_offsets.end() - 1);
+		for (const auto& edge_set : edge_sets)
+			for (const auto& edge : edge_set.children)
+				if (std::isfinite(edge.weight) && edge.weight >= 0) {
+					const int f = forward_fill[edge_set.parent]++;
+					targets[f] = edge.child;
+					weights[f] = edge.weight;
+
+					const int r = reverse_fill[edge.child]++;
+					sources[r] = edge_set.parent;
+					reverse_weights[r] = edge.weight;
+				}
+
+		// Assign every node to the cube around it. Nodes without a position share a cluster at the origin.
+		const NodeLattice lattice({ 0, 0, 0 }, { cluster_size, cluster_size, cluster_size });
+		robin_hood::unordered_map<LatticeKey, int> clusters;
+		cluster_of.resize(num_nodes);
+		for (int i = 0; i < num_nodes; i++) {
+			const LatticeKey key = i < nodes.size() ? lattice.Key(nodes[i]) : LatticeKey{ 0, 0, 0 };
+			cluster_of[i] = clusters.emplace(key, static_cast<int>(clusters.size())).first->second;
+		}
+		const int num_clusters = clusters.size();
+
+		// Find every node with an edge into another cluster, once for each cluster it leads to
+		struct BorderNode { int node; int other_cluster; };
+		vector<BorderNode> border;
+		robin_hood::unordered_map<uint64_t, int> border_index;
+		auto border_key = [](int node, int other_cluster) {
+			return (static_cast<uint64_t>(node) << 32) | static_cast<uint32_t>(other_cluster);
+		};
+		for (int node = 0; node < num_nodes; node++)
+			for (int k = offsets[node]; k < offsets[node + 1]; k++) {
+				const int other_cluster = cluster_of[targets[k]];
+				if (other_cluster != cluster_of[node]
+					&& border_index.emplace(border_key(node, other_cluster), static_cast<int>(border.size())).second)
+					border.push_back(BorderNode{ node, other_cluster });
+			}
+
+		// Join border nodes leading to the same cluster that are connected by an edge into entrances
+		vector<int> entrance_of(border.size());
+		std::iota(entrance_of.begin(), entrance_of.end(), 0);
+		auto find = [&entrance_of](int i) {
+			while (entrance_of[i] != i) i = entrance_of[i] = entrance_of[entrance_of[i]];
+			return i;
+		};
+		for (int i = 0; i < border.size(); i++) {
+			const int node = border[i].node;
+			for (int k = offsets[node]; k < offsets[node + 1]; k++) {
+				const auto neighbor = border_index.find(border_key(targets[k], border[i].other_cluster));
+				if (neighbor != border_index.end() && cluster_of[targets[k]] == cluster_of[node])
+					entrance_of[find(i)] = find(neighbor->second);
+			}
+		}
+
+		// Gather the border nodes of every entrance
+		robin_hood::unordered_map<int, vector<int>> entrances;
+		for (int i = 0; i < border.size(); i++)
+			entrances[find(i)].push_back(i);
+		vector<int> entrance_ids;
+		for (const auto& entrance : entrances) entrance_ids.push_back(entrance.first);
+		std::sort(entrance_ids.begin(), entrance_ids.end());
+
+		// Squared distance between the position of a node and a point. Nodes without a position are at the origin.
+		auto distance_to = [&nodes](int node, double x, double y, double z) {
+			if (node >= nodes.size()) return x * x + y * y + z * z;
+			const double dx = nodes[node].x - x, dy = nodes[node].y - y, dz = nodes[node].z - z;
+			return dx * dx + dy * dy + dz * dz;
+		};
+		auto position = [&nodes](int node) {
+			return node < nodes.size()
+				? std::array<double, 3>{ nodes[node].x, nodes[node].y, nodes[node].z }
+				: std::array<double, 3>{ 0, 0, 0 };
+		};
+
+		// Make portals of the center of each entrance and the node across its cheapest edge into the other
+		// cluster. Wide entrances also get portals at both of their ends, so paths don't need to detour
+		// through their center.
+		robin_hood::unordered_map<int, int> portal_of;
+		vector<std::tuple<int, int, float>> cross_edges;
+		auto add_portal = [this, &portal_of](int node) {
+			const auto inserted = portal_of.emplace(node, static_cast<int>(portals.size()));
+			if (inserted.second) portals.push_back(node);
+			return inserted.first->second;
+		};
+		for (int id : entrance_ids) {
+			const vector<int>& members = entrances[id];
+
+			// The node nearest the center, the node furthest from the center, and the node furthest from that
+			auto extreme = [&](const std::array<double, 3>& point, bool nearest) {
+				int result = members[0];
+				double result_distance = distance_to(border[result].node, point[0], point[1], point[2]);
+				for (int i : members) {
+					const double distance = distance_to(border[i].node, point[0], point[1], point[2]);
+					if (nearest ? distance < result_distance : distance > result_distance) {
+						result = i;
+						result_distance = distance;
+					}
+				}
+				return result;
+			};
+			std::array<double, 3> center{ 0, 0, 0 };
+			for (int i : members) {
+				const auto p = position(border[i].node);
+				for (int axis = 0; axis < 3; axis++) center[axis] += p[axis] / members.size();
+			}
+			vector<int> chosen{ extreme(center, true) };
+			if (members.size() >= wide_entrance) {
+				chosen.push_back(extreme(center, false));
+				chosen.push_back(extreme(position(border[chosen.back()].node), false));
+			}
+
+			for (int i : chosen) {
+				const BorderNode& node = border[i];
+				int best = -1;
+				for (int k = offsets[node.node]; k < offsets[node.node + 1]; k++)
+					if (cluster_of[targets[k]] == node.other_cluster && (best < 0 || weights[k] < weights[best]))
+						best = k;
+
+				const int a = add_portal(node.node);
+				const int b = add_portal(targets[best]);
+				cross_edges.emplace_back(a, b, weights[best]);
+				for (int k = reverse_offsets[node.node]; k < reverse_offsets[node.node + 1]; k++)
+					if (sources[k] == targets[best]) {
+						cross_edges.emplace_back(b, a, reverse_weights[k]);
+						break;
+					}
+			}
+		}
+
+		// Group portals by their cluster
+		cluster_offsets.assign(num_clusters + 1, 0);
+		for (int node : portals) cluster_offsets[cluster_of[node] + 1]++;
+		std::partial_sum(cluster_offsets.begin(), cluster_offsets.end(), cluster_offsets.begin());
+		cluster_portals.resize(portals.size());
+		vector<int> cluster_fill(cluster_offsets.begin(), cluster_offsets.end() - 1);
+		for (int p = 0; p < portals.size(); p++)
+			cluster_portals[cluster_fill[cluster_of[portals[p]]]++] = p;
+
+		// Connect the portals of each cluster by the shortest paths between them inside it
+		vector<vector<std::pair<int, float>>> abstract_edges(portals.size());
+#pragma omp parallel for schedule(dynamic)
+		for (int cluster = 0; cluster < num_clusters; cluster++) {
+			for (int i = cluster_offsets[cluster]; i < cluster_offsets[cluster + 1]; i++) {
+				const int p = cluster_portals[i];
+				const Visits visits = SearchCluster(offsets, targets, weights, cluster_of, portals[p]);
+				for (int j = cluster_offsets[cluster]; j < cluster_offsets[cluster + 1]; j++) {
+					const int q = cluster_portals[j];
+					const auto visit = visits.find(portals[q]);
+					if (q != p && visit != visits.end())
+						abstract_edges[p].emplace_back(q, visit->second.distance);
+				}
+			}
+		}
+		for (const auto& [a, b, weight] : cross_edges)
+			abstract_edges[a].emplace_back(b, weight);
+
+		// Store the abstract graph, keeping only the cheapest edge between each pair of portals
+		abstract_offsets.assign(portals.size() + 1, 0);
+		for (int p = 0; p < portals.size(); p++) {
+			auto& edges = abstract_edges[p];
+			std::sort(edges.begin(), edges.end());
+			for (int k = 0; k < edges.size(); k++) {
+				if (k > 0 && edges[k].first == edges[k - 1].first) continue;
+				abstract_targets.push_back(edges[k].first);
+				abstract_weights.push_back(edges[k].second);
+			}
+			abstract_offsets[p + 1] = abstract_targets.size();
+		}
+	}
+
+	Path PathHierarchy::FindPath(int start_id, int end_id) const
+	{
+		const int num_nodes = cluster_of.size();
+		if (start_id == end_id || start_id < 0 || end_id < 0 || start_id >= num_nodes || end_id >= num_nodes)
+			return Path();
+
+		const int start_cluster = cluster_of[start_id];
+		const int end_cluster = cluster_of[end_id];
+
+		// Search the clusters of both the start and end points from each of them, so paths between
+		// neighboring clusters don't need to pass through a portal
+		const Visits from_start = SearchCluster(offsets, targets, weights, cluster_of, start_id, end_cluster);
+		const Visits to_end = SearchCluster(reverse_offsets, sources, reverse_weights, cluster_of, end_id, start_cluster);
+
+		// A path that stays inside the two clusters is the best path found so far
+		float best = infinity;
+		int best_portal = -1;
+		const auto direct = from_start.find(end_id);
+		if (direct != from_start.end()) best = direct->second.distance;
+
+		// Search the abstract graph from every portal that the start point reaches until the remaining
+		// portals are further from the start point than the best path to the end point
+		robin_hood::unordered_map<int, std::pair<float, int>> reached;
+		Frontier frontier;
+		for (int cluster : { start_cluster, end_cluster })
+			for (int i = cluster_offsets[cluster]; i < cluster_offsets[cluster + 1]; i++) {
+				const int p = cluster_portals[i];
+				const auto visit = from_start.find(portals[p]);
+				if (visit == from_start.end() || reached.count(p) > 0) continue;
+
+				reached[p] = { visit->second.distance, -1 };
+				frontier.emplace(visit->second.distance, p);
+			}
+		while (!frontier.empty()) {
+			const auto [distance, p] = frontier.top();
+			frontier.pop();
+			if (distance >= best) break;
+			if (reached[p].first < distance) continue;
+
+			const auto visit = to_end.find(portals[p]);
+			if (visit != to_end.end() && distance + visit->second.distance < best) {
+				best = distance + visit->second.distance;
+				best_portal = p;
+			}
+
+			for (int k = abstract_offsets[p]; k < abstract_offsets[p + 1]; k++) {
+				const int q = abstract_targets[k];
+				const float new_distance = distance + abstract_weights[k];
+				const auto existing = reached.find(q);
+				if (existing != reached.end() && existing->second.first <= new_distance) continue;
+
+				reached[q] = { new_distance, p };
+				frontier.emplace(new_distance, q);
+			}
+		}
+		if (best == infinity) return Path();
+
+		vector<int> path_nodes{ start_id };
+		vector<float> path_costs{ 0 };
+		if (best_portal < 0)
+			AppendForward(from_start, end_id, path_nodes, path_costs);
+		else {
+			// Follow the abstract path back to the cluster of the start point
+			vector<int> abstract_path;
+			for (int p = best_portal; p >= 0; p = reached.at(p).second)
+				abstract_path.push_back(portals[p]);
+			std::reverse(abstract_path.begin(), abstract_path.end());
+
+			// Replace every abstract edge with the nodes it stands for
+			AppendForward(from_start, abstract_path.front(), path_nodes, path_costs);
+			for (int i = 1; i < abstract_path.size(); i++) {
+				const int from = abstract_path[i - 1];
+				const int to = abstract_path[i];
+				if (cluster_of[from] == cluster_of[to])
+					AppendForward(SearchCluster(offsets, targets, weights, cluster_of, from, -1, to), to, path_nodes, path_costs);
+				else {
+					float cost = infinity;
+					for (int k = offsets[from]; k < offsets[from + 1]; k++)
+						if (targets[k] == to) cost = std::min(cost, weights[k]);
+					path_costs.back() = cost;
+					path_nodes.push_back(to);
+					path_costs.push_back(0);
+				}
+			}
+			AppendBackward(to_end, abstract_path.back(), path_nodes, path_costs);
+		}
+
+		Path path;
+		for (int i = 0; i < path_nodes.size(); i++)
+			path.AddNode(path_nodes[i], path_costs[i]);
+		return path;
+	}
+
+	int PathHierarchy::NumClusters() const {
+		return cluster_offsets.empty() ? 0 : static_cast<int>(cluster_offsets.size()) - 1;
+	}
+
+	int PathHierarchy::NumPortals() const {
+		return portals.size();
+	}
+}
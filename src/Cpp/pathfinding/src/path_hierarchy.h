@@ -0,0 +1,105 @@
+///
+///	\file		path_hierarchy.h
+/// \brief		Contains definitions for the <see cref="HF::Pathfinding::PathHierarchy">PathHierarchy</see> class
+///
+///	\author		TBA
+///	\date		26 Jun 2020
+///
+
+#pragma once
+
+#include <vector>
+#include <string>
+
+namespace HF {
+	namespace SpatialStructures {
+		class Graph;
+		class Path;
+	}
+
+	namespace Pathfinding {
+
+		/*!
+			\brief An abstract graph over clusters of a graph, for planning long paths without searching every node.
+
+			\details
+			The nodes of the graph are divided into clusters by their position on a grid of cubes. Where edges
+			cross between two clusters, each connected run of their nodes along the border is an entrance. The
+			node of each entrance nearest its center, and the node across its cheapest edge into the other cluster,
+			become portals. Entrances of 6 or more nodes get portals at both of their ends as well. The abstract
+			graph connects every pair of portals in the same cluster by the cost of the shortest path between them
+			inside the cluster, and connects the portals of each entrance by the edge between them.
+
+			To find a path, the clusters of the start and end points are searched from the start point, and
+			towards the end point. The abstract graph is then searched from the portals reached from the start
+			point until none of the remaining portals can lead to a cheaper path to the end point. Finally each
+			abstract edge of the result is replaced by the path inside its cluster.
+
+			\remarks
+			Each search only visits two clusters or the portals, so finding a path takes much less time than
+			searching the whole graph when clusters are large compared to the spacing of the graph, but paths
+			that leave those clusters must pass through portals, so their cost may be slightly higher than the
+			cost of the shortest path. Paths that stay inside the clusters of their start and end points are
+			always the shortest.
+
+			\invariant The hierarchy only reflects the graph it was built from. It must be built again if the
+			graph changes.
+
+			\see EnablePathHierarchy for storing a hierarchy in a graph, so FindPath and FindPaths use it.
+		*/
+		class PathHierarchy {
+			std::vector<int> offsets;				///< Index of the first edge of each node in `targets`.
+			std::vector<int> targets;				///< Child of every edge, grouped by parent.
+			std::vector<float> weights;				///< Cost of every edge in `targets`.
+			std::vector<int> reverse_offsets;		///< Index of the first edge to each node in `sources`.
+			std::vector<int> sources;				///< Parent of every edge, grouped by child.
+			std::vector<float> reverse_weights;		///< Cost of every edge in `sources`.
+
+			std::vector<int> cluster_of;			///< Cluster of every node.
+			std::vector<int> portals;				///< ID of the node of every portal.
+			std::vector<int> cluster_offsets;		///< Index of the first portal of each cluster in `cluster_portals`.
+			std::vector<int> cluster_portals;		///< Index of every portal, grouped by cluster.
+
+			std::vector<int> abstract_offsets;		///< Index of the first abstract edge of each portal.
+			std::vector<int> abstract_targets;		///< Portal at the end of every abstract edge.
+			std::vector<float> abstract_weights;	///< Cost of every abstract edge.
+
+		public:
+			/*!
+				\brief Build a hierarchy for a graph.
+
+				\param graph Graph to build the hierarchy for.
+				\param cluster_size Length of the sides of the cube each cluster covers.
+				\param cost_type Cost type of `graph` to use for the cost of paths. Leave blank to use
+								 the cost type the graph was constructed with.
+
+				\pre `graph` must be compressed.
+
+				\throws std::out_of_range if `cluster_size` is not greater than 0.
+				\throws HF::Exceptions::NoCost if `cost_type` is not blank and isn't a cost type of `graph`.
+			*/
+			PathHierarchy(
+				const HF::SpatialStructures::Graph& graph,
+				float cluster_size,
+				const std::string& cost_type = ""
+			);
+
+			/*!
+				\brief Find a path between two nodes.
+
+				\param start_id ID of the node to start at.
+				\param end_id ID of the node to end at.
+
+				\returns A path from `start_id` to `end_id`, or an empty path if there is no path between
+						 them, either isn't in the graph, or they're the same node.
+			*/
+			HF::SpatialStructures::Path FindPath(int start_id, int end_id) const;
+
+			/// \brief Get the number of clusters that contain at least one node.
+			int NumClusters() const;
+
+			/// \brief Get the number of portals in the abstract graph.
+			int NumPortals() const;
+		};
+	}
+}
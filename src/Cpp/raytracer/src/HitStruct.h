@@ -1,5 +1,6 @@
 #pragma once
 
+#include <array>
 
 namespace HF::RayTracer {
 	/// <summary> A simple hit struct to carry all relevant information about hits. </summary>
@@ -19,6 +20,59 @@ namespace HF::RayTracer {
 		}
 	};
 
+	/*!
+		\brief A hit that also describes the surface of the triangle that was hit.
+
+		\details
+		Every member is taken from the same intersection as the distance, so no extra rays are needed to
+		find the slope or type of the surface at the hit point. Members other than those of HitStruct are
+		left at their defaults if no hit was recorded.
+
+		\see EmbreeRayTracer::IntersectSurface for casting a ray that returns a SurfaceHit.
+	*/
+	template <typename numeric_type = double>
+	struct SurfaceHit : public HitStruct<numeric_type> {
+		int primid = -1;	///< ID of the hit triangle in its mesh. Set to -1 if no hit was recorded.
+		float u = 0;		///< Barycentric weight of the second vertex of the hit triangle at the hit point.
+		float v = 0;		///< Barycentric weight of the third vertex of the hit triangle at the hit point.
+
+		/// Unit geometric normal of the hit triangle. Points to the side the vertices of the triangle
+		/// wind counter-clockwise around.
+		std::array<float, 3> normal{ 0, 0, 0 };
+
+		/// Attribute of the hit triangle, such as a material or whether it's walkable. Set to 0 if
+		/// the hit mesh has no attributes. \see EmbreeRayTracer::SetTriangleAttributes
+		int attribute = 0;
+	};
+
+	/*!
+		\brief A hit that also records which triangle of the mesh was hit.
+
+		\see EmbreeRayTracer::IntersectAll for collecting every hit along a ray.
+	*/
+	template <typename numeric_type = double>
+	struct PrimitiveHit : public HitStruct<numeric_type> {
+		int primid = -1;	///< ID of the hit triangle in its mesh. Set to -1 if no hit was recorded.
+
+		PrimitiveHit() = default;
+
+		PrimitiveHit(numeric_type in_distance, int in_meshid, int in_primid)
+			: HitStruct<numeric_type>(in_distance, in_meshid), primid(in_primid) {}
+	};
+
+	/*!
+		\brief The closest point on any surface to a query point.
+
+		\details `distance` is the distance from the query point to `point`, and `primid` is the
+		triangle `point` is on.
+
+		\see EmbreeRayTracer::ClosestPoint for finding the closest point to a query point.
+	*/
+	template <typename numeric_type = double>
+	struct ClosestPointHit : public PrimitiveHit<numeric_type> {
+		std::array<float, 3> point{ 0, 0, 0 }; ///< Closest point on the surface. Left at zero if no surface was found.
+	};
+
 	const int FAIL_ID = ((unsigned int)-1);
 	inline bool DidIntersect(int mesh_id) {
 		return mesh_id != FAIL_ID;
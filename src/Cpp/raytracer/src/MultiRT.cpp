@@ -1,6 +1,7 @@
 #include <MultiRT.h>
 #include <embree_raytracer.h>
 #include <ray_data.h>
+#include <HFExceptions.h>
 #include <cassert>
 
 #include <stdio.h>
@@ -54,4 +55,52 @@ namespace HF::RayTracer {
 		else
 			assert(false);
 	}
+
+	std::vector<HitStruct<MultiRT::real_t>> MultiRT::Intersections(
+		const std::vector<MultiRT::real3>& origins,
+		const std::vector<MultiRT::real3>& directions)
+	{
+		if (this->type == EMBREE)
+			return reinterpret_cast<HF::RayTracer::EmbreeRayTracer*>(this->RayTracer)->PacketIntersections<real_t>(origins, directions);
+
+		std::vector<HitStruct<real_t>> results(origins.size());
+		for (int i = 0; i < origins.size(); i++)
+			results[i] = this->Intersect(origins[i], directions[i]);
+
+		return results;
+	}
+
+	std::vector<char> MultiRT::Occlusions(
+		const std::vector<MultiRT::real3>& origins,
+		const std::vector<MultiRT::real3>& directions,
+		const std::vector<MultiRT::real_t>& distances)
+	{
+		if (this->type == EMBREE)
+			return reinterpret_cast<HF::RayTracer::EmbreeRayTracer*>(this->RayTracer)->PacketOcclusions(origins, directions, distances);
+
+		std::vector<char> results(origins.size());
+		for (int i = 0; i < origins.size(); i++)
+			results[i] = this->Occluded(origins[i], directions[i], distances[i]);
+
+		return results;
+	}
+
+	std::vector<MultiRT::real_t> MultiRT::ClosestDistances(
+		const std::vector<MultiRT::real3>& points,
+		MultiRT::real_t max_distance,
+		MultiRT::real_t min_height)
+	{
+		if (this->type != EMBREE)
+			throw HF::Exceptions::NotImplemented();
+
+		const auto closest = reinterpret_cast<HF::RayTracer::EmbreeRayTracer*>(this->RayTracer)->ClosestPoints<real_t>(
+			points, static_cast<float>(max_distance), -1, static_cast<float>(min_height)
+		);
+
+		std::vector<real_t> results(points.size());
+		for (int i = 0; i < points.size(); i++)
+			results[i] = closest[i].distance;
+
+		return results;
+	}
 }
@@ -1,6 +1,7 @@
 #pragma once
 
 #include <array>
+#include <vector>
 #include <HitStruct.h>
 
 namespace HF::RayTracer {
@@ -28,6 +29,67 @@ namespace HF::RayTracer {
 		bool Occluded(const real3 & origin, const real3& direction, real_t distance);
 
 		HitStruct<real_t> Intersect(const real3& origin, const real3& direction);
+
+		/*!
+			\brief Cast a set of rays, returning a result for each ray.
+
+			\param origins Origin points of each ray.
+			\param directions Direction of each ray.
+
+			\returns A HitStruct for every ray in the same order as `origins`.
+
+			\details
+			When backed by an EmbreeRayTracer, rays are traced in 16-wide packets. Otherwise
+			each ray is cast individually.
+
+			\pre origins and directions must be the same length.
+		*/
+		std::vector<HitStruct<real_t>> Intersections(
+			const std::vector<real3>& origins,
+			const std::vector<real3>& directions
+		);
+
+		/*!
+			\brief Cast a set of occlusion rays, returning a result for each ray.
+
+			\param origins Origin points of each ray.
+			\param directions Direction of each ray.
+			\param distances Maximum distance of each ray.
+
+			\returns `true` for every ray that was occluded and `false` for every ray that was not, in the
+			          same order as `origins`.
+
+			\details
+			When backed by an EmbreeRayTracer, rays are traced in 16-wide packets. Otherwise
+			each ray is cast individually.
+
+			\pre origins, directions, and distances must all be the same length.
+		*/
+		std::vector<char> Occlusions(
+			const std::vector<real3>& origins,
+			const std::vector<real3>& directions,
+			const std::vector<real_t>& distances
+		);
+
+		/*!
+			\brief Find the distance from each of a set of points to the closest surface.
+
+			\param points Points to find the closest surfaces to.
+			\param max_distance Only consider surfaces within this distance of each point.
+			\param min_height Ignore the parts of surfaces lower than this distance above each point.
+
+			\returns The distance from every point to its closest surface, or -1 if there was no surface
+					  within `max_distance`, in the same order as `points`.
+
+			\throws HF::Exceptions::NotImplemented if this isn't backed by an EmbreeRayTracer.
+
+			\see EmbreeRayTracer::ClosestPoints for details on how the distances are found.
+		*/
+		std::vector<real_t> ClosestDistances(
+			const std::vector<real3>& points,
+			real_t max_distance,
+			real_t min_height
+		);
 	};
 }
 
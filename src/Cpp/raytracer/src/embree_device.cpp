@@ -0,0 +1,95 @@
+///
+/// \file		embree_device.cpp
+/// \brief		Contains implementation for the Embree device shared by every <see cref="HF::RayTracer::EmbreeRayTracer">EmbreeRayTracer</see>
+///
+///	\author		TBA
+///	\date		26 Jun 2020
+
+#include <embree_device.h>
+
+#include <mutex>
+#include <stdexcept>
+
+namespace HF::RayTracer {
+
+	/// Guards shared_options and shared_device.
+	static std::mutex registry_mutex;
+
+	/// Settings to create shared_device with.
+	static DeviceOptions shared_options;
+
+	/// Device shared by every ray tracer. Null until the first call to AcquireDevice.
+	static RTCDevice shared_device = nullptr;
+
+	std::string DeviceOptions::ConfigString() const {
+		std::string config;
+		if (num_threads > 0)
+			config += "threads=" + std::to_string(num_threads);
+		if (set_affinity)
+			config += std::string(config.empty() ? "" : ",") + "set_affinity=1";
+		return config;
+	}
+
+	bool DeviceOptions::operator==(const DeviceOptions& other) const {
+		return num_threads == other.num_threads && set_affinity == other.set_affinity;
+	}
+
+	RTCBuildQuality BuildOptions::EmbreeQuality() const {
+		switch (quality) {
+		case BuildQuality::LOW:
+			return RTC_BUILD_QUALITY_LOW;
+		case BuildQuality::MEDIUM:
+			return RTC_BUILD_QUALITY_MEDIUM;
+		default:
+			return RTC_BUILD_QUALITY_HIGH;
+		}
+	}
+
+	RTCSceneFlags BuildOptions::EmbreeFlags() const {
+		RTCSceneFlags flags = RTC_SCENE_FLAG_ROBUST | RTC_SCENE_FLAG_CONTEXT_FILTER_FUNCTION;
+		if (compact) flags = flags | RTC_SCENE_FLAG_COMPACT;
+		if (dynamic) flags = flags | RTC_SCENE_FLAG_DYNAMIC;
+		return flags;
+	}
+
+	RTCBuildQuality BuildOptions::EmbreeGeometryQuality() const {
+		return dynamic ? RTC_BUILD_QUALITY_REFIT : RTC_BUILD_QUALITY_MEDIUM;
+	}
+
+	void SetDeviceOptions(const DeviceOptions& options) {
+		if (options.num_threads < 0)
+			throw std::out_of_range("The number of threads for Embree can't be negative!");
+
+		std::lock_guard<std::mutex> lock(registry_mutex);
+		if (shared_device && !(options == shared_options)) {
+			rtcReleaseDevice(shared_device);
+			shared_device = nullptr;
+		}
+		shared_options = options;
+	}
+
+	DeviceOptions GetDeviceOptions() {
+		std::lock_guard<std::mutex> lock(registry_mutex);
+		return shared_options;
+	}
+
+	RTCDevice AcquireDevice() {
+		std::lock_guard<std::mutex> lock(registry_mutex);
+		if (!shared_device) {
+			shared_device = rtcNewDevice(shared_options.ConfigString().c_str());
+			if (!shared_device)
+				throw std::runtime_error("Embree failed to create a device!");
+		}
+
+		rtcRetainDevice(shared_device);
+		return shared_device;
+	}
+
+	void ReleaseSharedDevice() {
+		std::lock_guard<std::mutex> lock(registry_mutex);
+		if (shared_device) {
+			rtcReleaseDevice(shared_device);
+			shared_device = nullptr;
+		}
+	}
+}
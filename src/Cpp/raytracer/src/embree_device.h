@@ -0,0 +1,114 @@
+///
+/// \file		embree_device.h
+/// \brief		Contains definitions for the Embree device shared by every <see cref="HF::RayTracer::EmbreeRayTracer">EmbreeRayTracer</see>
+///
+///	\author		TBA
+///	\date		26 Jun 2020
+
+#pragma once
+
+#include <rtcore.h>
+#include <string>
+
+namespace HF::RayTracer {
+
+	/*!
+		\brief Settings for the Embree device that ray tracers are created on.
+
+		\see SetDeviceOptions for changing the settings of the shared device.
+	*/
+	struct DeviceOptions {
+		int num_threads = 0;		///< Number of threads Embree builds BVHs with. Set to 0 to use every hardware thread.
+		bool set_affinity = false;	///< If true, pin each of Embree's threads to a single hardware thread.
+
+		/// \brief Get the configuration string Embree creates a device with for these options.
+		std::string ConfigString() const;
+
+		/// \brief Check if two sets of options are the same.
+		bool operator==(const DeviceOptions& other) const;
+	};
+
+	/// \brief Quality of the BVH Embree builds for a scene.
+	enum class BuildQuality {
+		LOW,		///< Build as quickly as possible at the cost of slower rays.
+		MEDIUM,		///< Balance the time to build against the speed of rays.
+		HIGH		///< Build the BVH that casts rays the fastest. This takes the longest to build.
+	};
+
+	/*!
+		\brief Settings for building the BVH of a ray tracer's scene.
+
+		\details
+		The defaults build the BVH that casts rays the fastest. Use LOW quality for ray tracers that
+		are only used for a few queries, and `compact` to save memory on large models.
+
+		\remarks
+		Scenes are always built with robust intersections, since analysis relies on rays not slipping
+		between triangles that share edges.
+	*/
+	struct BuildOptions {
+		BuildQuality quality = BuildQuality::HIGH;	///< Quality of the BVH.
+		bool compact = false;						///< If true, use a BVH layout that takes less memory but is slower to cast rays in.
+		bool dynamic = false;						///< If true, optimize the BVH for geometry that's frequently added or changed.
+
+		/// \brief Get the Embree build quality for `quality`.
+		RTCBuildQuality EmbreeQuality() const;
+
+		/*!
+			\brief Get the Embree scene flags for these options.
+
+			\returns The flags for `compact` and `dynamic`, along with the flags every scene is built
+					 with.
+		*/
+		RTCSceneFlags EmbreeFlags() const;
+
+		/*!
+			\brief Get the Embree build quality for the triangle geometry of a scene built with these options.
+
+			\returns RTC_BUILD_QUALITY_REFIT if `dynamic` is set, so edited meshes refit their BVH instead
+					 of rebuilding it. RTC_BUILD_QUALITY_MEDIUM, Embree's default, otherwise.
+		*/
+		RTCBuildQuality EmbreeGeometryQuality() const;
+	};
+
+	/*!
+		\brief Change the settings of the shared device.
+
+		\param options Settings to create the shared device with.
+
+		\details
+		If the shared device already exists with different settings, it's replaced. Ray tracers that
+		were already created keep using the old device until they're destroyed.
+
+		\throws std::out_of_range if `options.num_threads` is less than 0.
+	*/
+	void SetDeviceOptions(const DeviceOptions& options);
+
+	/// \brief Get the settings of the shared device.
+	DeviceOptions GetDeviceOptions();
+
+	/*!
+		\brief Get the Embree device shared by every ray tracer, creating it if it doesn't exist.
+
+		\returns The shared device, with a reference held for the caller. The caller must release
+				 it with `rtcReleaseDevice`.
+
+		\details
+		Each Embree device runs its own thread pool, so sharing a single device stops processes that
+		load many models from creating a thread pool for every model.
+
+		\remarks Safe to call from multiple threads.
+
+		\throws std::runtime_error if Embree fails to create the device.
+	*/
+	RTCDevice AcquireDevice();
+
+	/*!
+		\brief Release the reference the registry holds on the shared device.
+
+		\details
+		The device is destroyed once every ray tracer using it is destroyed. The next call to
+		AcquireDevice creates a new device.
+	*/
+	void ReleaseSharedDevice();
+}
@@ -6,9 +6,11 @@
 ///	\date		26 Jun 2020
 
 #include <embree_raytracer.h>
+#include <ray_batch.h>
 #include <corecrt_math_defines.h>
 #include <functional>
 #include <iostream>
+#include <numeric>
 #include <thread>
 #include <robin_hood.h>
 
@@ -39,6 +41,7 @@ namespace HF::RayTracer {
 		hit.ray.time = 0.0f; // Time of ray for motion blur, unrelated to our package
 
 		hit.hit.geomID = RTC_INVALID_GEOMETRY_ID;
+		hit.hit.instID[0] = RTC_INVALID_GEOMETRY_ID;
 		hit.hit.primID = -1;
 
 		return hit;
@@ -61,6 +64,106 @@ namespace HF::RayTracer {
 			
 		return ray;
 	}
+
+	/*! 
+		\brief An intersect context that only accepts hits on a single mesh.
+
+		\remarks
+		Embree passes the address of `context` to FilterMesh, which casts it back to this struct
+		to find `mesh_id`, so `context` must be the first member.
+	*/
+	struct MeshFilterContext {
+		RTCIntersectContext context;	///< Context to cast rays with.
+		unsigned int mesh_id;			///< ID of the only mesh that hits are accepted on.
+	};
+
+	/*!
+		\brief Reject every hit in a group of rays that isn't on the mesh of their MeshFilterContext.
+
+		\details Embree calls this for every hit it finds while traversing the BVH, so rays keep
+		going through other meshes instead of stopping at the first hit on any of them.
+	*/
+	void FilterMesh(const RTCFilterFunctionNArguments* args) {
+		const auto* filter_context = reinterpret_cast<const MeshFilterContext*>(args->context);
+		for (unsigned int i = 0; i < args->N; i++)
+			if (args->valid[i] != 0) {
+				const unsigned int mesh_id = HitMeshID(
+					RTCHitN_geomID(args->hit, args->N, i),
+					RTCHitN_instID(args->hit, args->N, i, 0)
+				);
+				if (mesh_id != filter_context->mesh_id)
+					args->valid[i] = 0;
+			}
+	}
+
+	/// \brief Create a copy of `context` that only accepts hits on the mesh with the ID `mesh_id`.
+	inline MeshFilterContext CreateMeshFilterContext(const RTCIntersectContext& context, int mesh_id) {
+		MeshFilterContext filter_context{ context, static_cast<unsigned int>(mesh_id) };
+		filter_context.context.filter = FilterMesh;
+		return filter_context;
+	}
+
+	/// A hit recorded by CollectHits, before it's converted to a PrimitiveHit.
+	struct RecordedHit {
+		float distance;			///< Distance from the ray's origin to the hit, as calculated by Embree.
+		unsigned int geom_id;	///< ID of the hit geometry.
+		unsigned int prim_id;	///< ID of the hit triangle in the geometry.
+		unsigned int inst_id;	///< ID of the instance the geometry was in, or RTC_INVALID_GEOMETRY_ID.
+	};
+
+	/*!
+		\brief An intersect context that records the closest hits of a ray instead of stopping at the first.
+
+		\remarks
+		Like MeshFilterContext, `context` must be the first member so CollectHits can find the rest.
+	*/
+	struct MultiHitContext {
+		RTCIntersectContext context;	///< Context to cast rays with.
+		int mesh_id;					///< ID of the only mesh that hits are recorded on, or -1 for every mesh.
+		unsigned int max_hits;			///< Maximum number of hits to keep.
+		std::vector<RecordedHit> hits;	///< Closest hits found so far, sorted by distance.
+	};
+
+	/*!
+		\brief Record every hit of a single ray in its MultiHitContext, then reject it.
+
+		\details Rejecting every hit makes Embree keep traversing the BVH until the whole ray segment has
+		been searched. Once `max_hits` hits have been recorded, only hits closer than the farthest one
+		are kept.
+	*/
+	void CollectHits(const RTCFilterFunctionNArguments* args) {
+		auto* multi_hit = reinterpret_cast<MultiHitContext*>(args->context);
+		auto& hits = multi_hit->hits;
+
+		for (unsigned int i = 0; i < args->N; i++) {
+			if (args->valid[i] == 0) continue;
+			args->valid[i] = 0;
+
+			const RecordedHit hit{
+				RTCRayN_tfar(args->ray, args->N, i),
+				RTCHitN_geomID(args->hit, args->N, i),
+				RTCHitN_primID(args->hit, args->N, i),
+				RTCHitN_instID(args->hit, args->N, i, 0)
+			};
+			if (multi_hit->mesh_id >= 0 && HitMeshID(hit.geom_id, hit.inst_id) != static_cast<unsigned int>(multi_hit->mesh_id))
+				continue;
+
+			// Triangles that span several leaves of the BVH can be reported more than once
+			const bool duplicate = std::any_of(hits.begin(), hits.end(), [&hit](const RecordedHit& other) {
+				return other.prim_id == hit.prim_id && other.geom_id == hit.geom_id && other.inst_id == hit.inst_id;
+			});
+			if (duplicate) continue;
+
+			const auto position = std::upper_bound(hits.begin(), hits.end(), hit.distance,
+				[](float distance, const RecordedHit& other) { return distance < other.distance; }) - hits.begin();
+			if (hits.size() >= multi_hit->max_hits) {
+				if (position == hits.size()) continue;
+				hits.pop_back();
+			}
+			hits.insert(hits.begin() + position, hit);
+		}
+	}
+
 	/// <summary>
 	/// Check an embree device for errors.
 	/// </summary>
@@ -126,52 +229,20 @@ namespace HF::RayTracer {
 		}
 	}
 
-	/// <summary>
-	/// Package raw arrays of floats and indices in buffers to the required Embree types.
-	/// </summary>
-	/// <param name="in_vertices">
-	/// An array of floats in which every 3 floats represents a vertex.
-	/// </param>
-	/// <param name="in_indices">
-	/// An array of integers in which every 3 integers represents a triangle.
-	/// </param>
-	/// <param name="out_vertices"> Output array for vertexes.</param>
-	/// <param name="out_triangles"> Output array for triangles.</param>
-	/// \todo May be faster as a std::move or std::copy.
-	inline void buffersToStructs(
-		std::vector<float>& in_vertices,
-		std::vector<int>& in_indices,
-		std::vector<Vertex>& out_vertices,
-		std::vector<Triangle>& out_triangles
-	) {
-		out_vertices.resize(in_vertices.size() / 3);
-		for (int i = 0; i < in_vertices.size(); i += 3) {
-			out_vertices[i / 3] = Vertex{
-				in_vertices[i],
-				in_vertices[i + 1],
-				in_vertices[i + 2]
-			};
-		}
-
-		out_triangles.resize(in_indices.size() / 3);
-		for (int i = 0; i < in_indices.size(); i += 3) {
-			out_triangles[i / 3] = Triangle{
-				in_indices[i],
-				in_indices[i + 1],
-				in_indices[i + 2]
-			};
-		}
-	}
-
-	EmbreeRayTracer::EmbreeRayTracer(bool use_precise)
+	EmbreeRayTracer::EmbreeRayTracer(bool use_precise, const BuildOptions& options)
 	{
 		this->use_precise = false;
+		build_options = options;
 		SetupScene();
 	}
 
-	EmbreeRayTracer::EmbreeRayTracer(std::vector<HF::Geometry::MeshInfo<float>>& MI, bool use_precise) {
+	EmbreeRayTracer::EmbreeRayTracer(std::vector<HF::Geometry::MeshInfo<float>>& MI, bool use_precise)
+		: EmbreeRayTracer(MI, use_precise, BuildOptions()) {}
+
+	EmbreeRayTracer::EmbreeRayTracer(std::vector<HF::Geometry::MeshInfo<float>>& MI, bool use_precise, const BuildOptions& options) {
 		// Throw if MI's size is less than 0
 		this->use_precise = true;
+		build_options = options;
 
 		if (MI.empty())
 			throw std::logic_error("Embree Ray Tracer was passed an empty vector of mesh info!");
@@ -181,17 +252,23 @@ namespace HF::RayTracer {
 		AddMesh(MI, true);
 	}
 
-	EmbreeRayTracer::EmbreeRayTracer(HF::Geometry::MeshInfo<float>& MI, bool use_precise) {
+	EmbreeRayTracer::EmbreeRayTracer(HF::Geometry::MeshInfo<float>& MI, bool use_precise, const BuildOptions& options) {
+		build_options = options;
 		SetupScene();
 		this->use_precise = use_precise;
 		AddMesh(MI, true);
 	}
 
 	void EmbreeRayTracer::SetupScene() {
-		device = rtcNewDevice("");
+		device = AcquireDevice();
+		CreateScene();
+	}
+
+	void EmbreeRayTracer::CreateScene() {
 		scene = rtcNewScene(device);
-		rtcSetSceneBuildQuality(scene, RTC_BUILD_QUALITY_HIGH);
-		rtcSetSceneFlags(scene, RTC_SCENE_FLAG_ROBUST);
+		state = std::make_shared<SceneState>();
+		rtcSetSceneBuildQuality(scene, build_options.EmbreeQuality());
+		rtcSetSceneFlags(scene, build_options.EmbreeFlags());
 		// Initialize the intersect context, which should later allow RTC_INTERSECT_CONTEXT_FLAG_COHERENT
 		rtcInitIntersectContext(&context);
 	}
@@ -202,7 +279,9 @@ namespace HF::RayTracer {
 		device = ERT2.device;
 		context = ERT2.context;
 		scene = ERT2.scene;
-		geometry = ERT2.geometry;
+		state = ERT2.state;
+		use_precise = ERT2.use_precise;
+		build_options = ERT2.build_options;
 
 		// Increment embree's internal refrence counter.
 		rtcRetainScene(scene);
@@ -221,9 +300,103 @@ namespace HF::RayTracer {
 			// Don't know the specific error that will be raised here (Documentation just states some error code)
 			if (error != RTCError::RTC_ERROR_NONE)
 				return InsertGeom(geom);
+
+			state->geometry_ids[id] = geom;
 		}
 	
-		return static_cast<int>(rtcAttachGeometry(scene, geom));
+		const int new_id = static_cast<int>(rtcAttachGeometry(scene, geom));
+		state->geometry_ids[new_id] = geom;
+		state->version++;
+		return new_id;
+	}
+
+	EmbreeRayTracer EmbreeRayTracer::Subset(const std::vector<int>& mesh_ids, bool exclude) const
+	{
+		// Start from a copy so the device and settings are shared, then give it a scene of its own
+		EmbreeRayTracer subset(*this);
+		rtcReleaseScene(subset.scene);
+		subset.CreateScene();
+
+		// Keep every buffer and prototype alive for as long as the subset, even if meshes are later
+		// removed from this raytracer
+		subset.state->prototypes = state->prototypes;
+		subset.state->vertex_counts = state->vertex_counts;
+		subset.state->shared_buffers = state->shared_buffers;
+
+		// The same geometry may be attached with more than one ID, so select by geometry rather than ID
+		std::vector<RTCGeometry> selected;
+		for (int id : mesh_ids) {
+			const auto it = state->geometry_ids.find(id);
+			if (it != state->geometry_ids.end()) selected.push_back(it->second);
+		}
+
+		for (const auto& [id, geom] : state->geometry_ids) {
+			const bool is_selected = std::find(selected.begin(), selected.end(), geom) != selected.end();
+			if (is_selected == exclude) continue;
+
+			rtcAttachGeometryByID(subset.scene, geom, id);
+			subset.state->geometry_ids[id] = geom;
+			const auto attributes = state->triangle_attributes.find(id);
+			if (attributes != state->triangle_attributes.end())
+				subset.state->triangle_attributes[id] = attributes->second;
+			if (std::find(subset.state->geometry.begin(), subset.state->geometry.end(), geom) == subset.state->geometry.end())
+				subset.state->geometry.push_back(geom);
+		}
+		rtcCommitScene(subset.scene);
+
+		return subset;
+	}
+
+	void EmbreeRayTracer::SetBuildOptions(const BuildOptions& options)
+	{
+		build_options = options;
+
+		for (RTCGeometry geom : state->geometry) {
+			if (PrototypeOf(geom)) continue;
+			rtcSetGeometryBuildQuality(geom, build_options.EmbreeGeometryQuality());
+			rtcCommitGeometry(geom);
+		}
+
+		// Instances must be rebuilt before the scene they're in
+		for (const auto& prototype : state->prototypes) {
+			rtcSetSceneBuildQuality(prototype.get(), build_options.EmbreeQuality());
+			rtcSetSceneFlags(prototype.get(), build_options.EmbreeFlags());
+			rtcCommitScene(prototype.get());
+		}
+
+		rtcSetSceneBuildQuality(scene, build_options.EmbreeQuality());
+		rtcSetSceneFlags(scene, build_options.EmbreeFlags());
+		rtcCommitScene(scene);
+	}
+
+	const BuildOptions& EmbreeRayTracer::GetBuildOptions() const
+	{
+		return build_options;
+	}
+
+	bool EmbreeRayTracer::SetTriangleAttributes(int mesh_id, const std::vector<int>& attributes)
+	{
+		if (state->geometry_ids.count(mesh_id) == 0) return false;
+
+		if (attributes.empty())
+			state->triangle_attributes.erase(mesh_id);
+		else
+			state->triangle_attributes[mesh_id] = std::make_shared<const std::vector<int>>(attributes);
+		state->version++;
+		return true;
+	}
+
+	int EmbreeRayTracer::TriangleAttribute(int mesh_id, int prim_id) const
+	{
+		const auto attributes = state->triangle_attributes.find(mesh_id);
+		if (attributes == state->triangle_attributes.end() || prim_id < 0 || prim_id >= attributes->second->size())
+			return 0;
+		return (*attributes->second)[prim_id];
+	}
+
+	unsigned int EmbreeRayTracer::SceneVersion() const
+	{
+		return state->version;
 	}
 
 	inline Vector3D cross(const Vector3D& x, const Vector3D& y) {
@@ -283,10 +456,11 @@ namespace HF::RayTracer {
 		unsigned int geom_id,
 		unsigned int prim_id, 
 		const Vector3D & origin, 
-		const Vector3D & direction) const
+		const Vector3D & direction,
+		unsigned int inst_id) const
 	{
 		// Get the triangle intersected by this hit
-		auto triangle = this->GetTriangle(geom_id, prim_id);
+		auto triangle = this->GetTriangle(geom_id, prim_id, inst_id);
 
 		// Perform the raytriangle intersection
 		return RayTriangleIntersection(
@@ -334,37 +508,51 @@ namespace HF::RayTracer {
 	}
 
 	RTCGeometry EmbreeRayTracer::ConstructGeometryFromBuffers(vector<Triangle>& tris, vector<Vertex>& verts) {
+		// Pad both buffers, then hand them over to be shared with embree
+		tris.push_back(Triangle{ 0, 0, 0 });
+		verts.push_back(Vertex{ 0, 0, 0 });
+		return ConstructSharedGeometry(std::move(tris), std::move(verts));
+	}
+
+	RTCGeometry EmbreeRayTracer::ConstructSharedGeometry(vector<Triangle>&& tris, vector<Vertex>&& verts) {
+		// Move the buffers somewhere they'll live as long as this raytracer and its copies
+		auto index_buffer = std::make_shared<vector<Triangle>>(std::move(tris));
+		auto vertex_buffer = std::make_shared<vector<Vertex>>(std::move(verts));
+		const size_t num_tris = index_buffer->size() - 1;
+		const size_t num_verts = vertex_buffer->size() - 1;
+
 		// Create new geometry object
 		RTCGeometry geom = rtcNewGeometry(device, RTC_GEOMETRY_TYPE_TRIANGLE);
 
-		// Allocate it's triangle and index buffers in embree
-		triangles = static_cast<Triangle*>(
-			rtcSetNewGeometryBuffer(
-				geom,
-				RTC_BUFFER_TYPE_INDEX,
-				0,
-				RTC_FORMAT_UINT3,
-				sizeof(Triangle),
-				tris.size() + 1
-			)
-			);
-		Vertices = static_cast<Vertex*>(
-			rtcSetNewGeometryBuffer(
-				geom,
-				RTC_BUFFER_TYPE_VERTEX,
-				0,
-				RTC_FORMAT_FLOAT3,
-				sizeof(Vertex),
-				verts.size() + 1
-			)
-			);
-
-		// Move data from input tris/verts into buffers
-		std::move(tris.begin(), tris.end(), triangles);
-		std::move(verts.begin(), verts.end(), Vertices);
+		// Point it at the buffers, leaving out the padding at their ends
+		rtcSetSharedGeometryBuffer(
+			geom,
+			RTC_BUFFER_TYPE_INDEX,
+			0,
+			RTC_FORMAT_UINT3,
+			index_buffer->data(),
+			0,
+			sizeof(Triangle),
+			num_tris
+		);
+		rtcSetSharedGeometryBuffer(
+			geom,
+			RTC_BUFFER_TYPE_VERTEX,
+			0,
+			RTC_FORMAT_FLOAT3,
+			vertex_buffer->data(),
+			0,
+			sizeof(Vertex),
+			num_verts
+		);
+		triangles = index_buffer->data();
+		Vertices = vertex_buffer->data();
+		state->shared_buffers[geom] = { index_buffer, vertex_buffer };
 
 		// Add a reference to this geometry to internal array of geometry.
-		geometry.push_back(geom);
+		state->geometry.push_back(geom);
+		state->vertex_counts[geom] = static_cast<int>(num_verts);
+		rtcSetGeometryBuildQuality(geom, build_options.EmbreeGeometryQuality());
 		
 		// Commit this geometry to finalize the process then return
 		rtcCommitGeometry(geom);
@@ -372,18 +560,29 @@ namespace HF::RayTracer {
 		return geom;
 	}
 
-	bool EmbreeRayTracer::AddMesh(HF::Geometry::MeshInfo<float>& Mesh, bool Commit) {
-
-		if (Mesh.NumTris() < 1 || Mesh.NumVerts() < 1) 
+	RTCGeometry EmbreeRayTracer::ConstructGeometryFromMesh(const HF::Geometry::MeshInfo<float>& mesh) {
+		if (mesh.NumTris() < 1 || mesh.NumVerts() < 1)
 			throw HF::Exceptions::InvalidOBJ();
-		// Get vertex and triangle data from the mesh
 
-		std::vector<Triangle> tris;	std::vector<Vertex> verts;
-		auto indices = Mesh.getRawIndices(); auto vertices = Mesh.GetIndexedVertices();
-		buffersToStructs(vertices, indices, verts, tris);
+		// The mesh stores each vertex and triangle as 3 consecutive elements, just like embree
+		static_assert(sizeof(Vertex) == 3 * sizeof(float), "Vertex must match the layout of a mesh's vertices");
+		static_assert(sizeof(Triangle) == 3 * sizeof(int), "Triangle must match the layout of a mesh's indices");
+		const auto vertices = mesh.GetVertexPointer();
+		const auto indices = mesh.GetIndexPointer();
+
+		// Copy the mesh's storage straight into padded buffers
+		vector<Vertex> verts(vertices.size / 3 + 1, Vertex{ 0, 0, 0 });
+		vector<Triangle> tris(indices.size / 3 + 1, Triangle{ 0, 0, 0 });
+		std::copy(vertices.data, vertices.data + vertices.size, &verts[0].x);
+		std::copy(indices.data, indices.data + indices.size, &tris[0].v0);
+
+		return ConstructSharedGeometry(std::move(tris), std::move(verts));
+	}
+
+	bool EmbreeRayTracer::AddMesh(HF::Geometry::MeshInfo<float>& Mesh, bool Commit) {
 
 		// Construct geometry using embree
-		auto geom = ConstructGeometryFromBuffers(tris, verts);
+		auto geom = ConstructGeometryFromMesh(Mesh);
 
 		// Add the Mesh to the scene and update it's ID
 		Mesh.meshid = InsertGeom(geom, Mesh.meshid);
@@ -408,6 +607,290 @@ namespace HF::RayTracer {
 		return true;
 	}
 
+	/// <summary> Get the transform of an instance as a 3x4 column major matrix. </summary>
+	inline std::array<float, 12> InstanceTransform(RTCGeometry instance)
+	{
+		std::array<float, 12> transform;
+		rtcGetGeometryTransform(instance, 0.0f, RTC_FORMAT_FLOAT3X4_COLUMN_MAJOR, transform.data());
+		return transform;
+	}
+
+	/*!
+		\brief Move vertices from the scene into the space of an instance's prototype.
+
+		\param m Transform of the instance as a 3x4 column major matrix.
+		\param vertices X, Y, and Z coordinates of every vertex, one after another. These are overwritten.
+
+		\details The rows of the inverse of a 3x3 matrix are the cross products of its columns, divided
+		by its determinant.
+
+		\throws std::invalid_argument if `m` can't be inverted.
+	*/
+	inline void ToPrototypeSpace(const std::array<float, 12>& m, std::vector<float>& vertices)
+	{
+		const std::array<float, 3> x{ m[0], m[1], m[2] }, y{ m[3], m[4], m[5] }, z{ m[6], m[7], m[8] };
+		auto cross = [](const std::array<float, 3>& a, const std::array<float, 3>& b) {
+			return std::array<float, 3>{ a[1] * b[2] - a[2] * b[1], a[2] * b[0] - a[0] * b[2], a[0] * b[1] - a[1] * b[0] };
+		};
+		const auto rx = cross(y, z), ry = cross(z, x), rz = cross(x, y);
+		const float det = x[0] * rx[0] + x[1] * rx[1] + x[2] * rx[2];
+		if (det == 0)
+			throw std::invalid_argument("The transform of the instance can't be inverted!");
+
+		for (int i = 0; i < vertices.size(); i += 3) {
+			const float px = vertices[i] - m[9], py = vertices[i + 1] - m[10], pz = vertices[i + 2] - m[11];
+			vertices[i] = (rx[0] * px + rx[1] * py + rx[2] * pz) / det;
+			vertices[i + 1] = (ry[0] * px + ry[1] * py + ry[2] * pz) / det;
+			vertices[i + 2] = (rz[0] * px + rz[1] * py + rz[2] * pz) / det;
+		}
+	}
+
+	int EmbreeRayTracer::AddPrototype(const HF::Geometry::MeshInfo<float>& Mesh)
+	{
+		auto geom = ConstructGeometryFromMesh(Mesh);
+		CreatePrototype(geom);
+		return static_cast<int>(state->prototypes.size()) - 1;
+	}
+
+	RTCScene EmbreeRayTracer::CreatePrototype(RTCGeometry geom)
+	{
+		// Give the prototype a scene of its own, which every instance of it will share
+		RTCScene prototype = rtcNewScene(device);
+		rtcSetSceneBuildQuality(prototype, build_options.EmbreeQuality());
+		rtcSetSceneFlags(prototype, build_options.EmbreeFlags());
+		rtcAttachGeometry(prototype, geom);
+		rtcCommitScene(prototype);
+
+		state->prototypes.emplace_back(prototype, rtcReleaseScene);
+		return prototype;
+	}
+
+	int EmbreeRayTracer::AddInstance(int prototype_id, const std::array<float, 12>& transform, int mesh_id, bool Commit)
+	{
+		if (prototype_id < 0 || prototype_id >= static_cast<int>(state->prototypes.size()))
+			throw std::out_of_range("There is no prototype with the ID " + std::to_string(prototype_id) + "!");
+
+		RTCScene prototype = state->prototypes[prototype_id].get();
+		RTCGeometry geom = rtcNewGeometry(device, RTC_GEOMETRY_TYPE_INSTANCE);
+		rtcSetGeometryInstancedScene(geom, prototype);
+		rtcSetGeometryTransform(geom, 0, RTC_FORMAT_FLOAT3X4_COLUMN_MAJOR, transform.data());
+
+		// Store the prototype on the instance so its triangles can be found from hits
+		rtcSetGeometryUserData(geom, prototype);
+		rtcCommitGeometry(geom);
+		state->geometry.push_back(geom);
+
+		const int id = InsertGeom(geom, mesh_id);
+
+		if (Commit)
+			rtcCommitScene(scene);
+
+		return id;
+	}
+
+	bool EmbreeRayTracer::AddInstancedMeshes(std::vector<HF::Geometry::MeshInfo<float>>& Meshes, bool Commit)
+	{
+		// Greatest difference between the vertices of two meshes for them to be considered copies
+		const float tolerance = 0.0001f;
+
+		// A set of meshes that are copies of each other
+		struct CopySet {
+			std::vector<float> shape;		///< Vertices of the first mesh, relative to its first vertex.
+			std::array<float, 3> origin;	///< First vertex of the first mesh.
+			int count = 0;					///< Number of meshes in the set.
+			int prototype = -1;				///< ID of the set's prototype once it has been created.
+		};
+
+		// Group meshes by their triangles, then by the shape of their vertices. Sets are found by
+		// their index in the vector of their triangles, since the vector may grow.
+		std::map<std::vector<int>, std::vector<CopySet>> sets_by_indices;
+		std::vector<std::pair<std::vector<CopySet>*, int>> set_of_mesh(Meshes.size());
+		std::vector<std::vector<float>> vertices_of_mesh(Meshes.size());
+		for (int i = 0; i < Meshes.size(); i++) {
+			if (Meshes[i].NumTris() < 1 || Meshes[i].NumVerts() < 1)
+				throw HF::Exceptions::InvalidOBJ();
+
+			const auto& vertices = vertices_of_mesh[i] = Meshes[i].GetIndexedVertices();
+			std::vector<float> shape(vertices.size());
+			for (int v = 0; v < vertices.size(); v++)
+				shape[v] = vertices[v] - vertices[v % 3];
+
+			auto& sets = sets_by_indices[Meshes[i].getRawIndices()];
+			auto match = std::find_if(sets.begin(), sets.end(), [&shape, tolerance](const CopySet& set) {
+				for (int v = 0; v < shape.size(); v++)
+					if (std::abs(set.shape[v] - shape[v]) > tolerance) return false;
+				return true;
+			});
+			if (match == sets.end()) {
+				sets.push_back(CopySet{ std::move(shape), { vertices[0], vertices[1], vertices[2] } });
+				match = std::prev(sets.end());
+			}
+
+			match->count++;
+			set_of_mesh[i] = { &sets, static_cast<int>(match - sets.begin()) };
+		}
+
+		// Add meshes in their original order so they're given the same IDs AddMesh would give them
+		for (int i = 0; i < Meshes.size(); i++) {
+			auto& mesh = Meshes[i];
+			auto& set = (*set_of_mesh[i].first)[set_of_mesh[i].second];
+			if (set.count < 2) {
+				AddMesh(mesh, false);
+				continue;
+			}
+
+			// The first mesh of each set becomes its prototype, and stays where it is
+			if (set.prototype < 0)
+				set.prototype = AddPrototype(mesh);
+
+			const auto& vertices = vertices_of_mesh[i];
+			const std::array<float, 12> transform{
+				1, 0, 0,
+				0, 1, 0,
+				0, 0, 1,
+				vertices[0] - set.origin[0], vertices[1] - set.origin[1], vertices[2] - set.origin[2]
+			};
+			mesh.meshid = AddInstance(set.prototype, transform, mesh.meshid, false);
+		}
+
+		if (Commit)
+			rtcCommitScene(scene);
+
+		return true;
+	}
+
+	int EmbreeRayTracer::NumPrototypes() const
+	{
+		return static_cast<int>(state->prototypes.size());
+	}
+
+	RTCScene EmbreeRayTracer::PrototypeOf(RTCGeometry geom) const
+	{
+		// Only instances are given user data, which is set to their prototype by AddInstance
+		return static_cast<RTCScene>(rtcGetGeometryUserData(geom));
+	}
+
+	bool EmbreeRayTracer::UpdateMesh(int mesh_id, const std::vector<float>& vertices, bool Commit)
+	{
+		const auto it = state->geometry_ids.find(mesh_id);
+		if (it == state->geometry_ids.end()) return false;
+
+		// Instances have their vertices in the only geometry of their prototype
+		RTCGeometry geom = it->second;
+		RTCScene prototype = PrototypeOf(geom);
+		RTCGeometry mesh = prototype ? rtcGetGeometry(prototype, 0) : geom;
+
+		const int num_vertices = state->vertex_counts.at(mesh);
+		if (vertices.size() != 3 * num_vertices)
+			throw std::invalid_argument(
+				"Mesh " + std::to_string(mesh_id) + " has " + std::to_string(num_vertices)
+				+ " vertices, but " + std::to_string(vertices.size()) + " coordinates were given!"
+			);
+
+		std::vector<float> new_vertices = vertices;
+		if (prototype) {
+			ToPrototypeSpace(InstanceTransform(geom), new_vertices);
+
+			// If other meshes are instances of the same prototype, copy it so they stay where they are
+			const bool is_shared = std::any_of(state->geometry_ids.begin(), state->geometry_ids.end(),
+				[this, geom, prototype](const auto& id_and_geom) {
+					return id_and_geom.second != geom && PrototypeOf(id_and_geom.second) == prototype;
+				});
+			if (is_shared) {
+				const auto& buffers = state->shared_buffers.at(mesh);
+				auto tris = *std::static_pointer_cast<const vector<Triangle>>(buffers[0]);
+				auto verts = *std::static_pointer_cast<const vector<Vertex>>(buffers[1]);
+				mesh = ConstructSharedGeometry(std::move(tris), std::move(verts));
+				prototype = CreatePrototype(mesh);
+				rtcSetGeometryInstancedScene(geom, prototype);
+				rtcSetGeometryUserData(geom, prototype);
+			}
+		}
+
+		// Overwrite the vertex buffer in place so Embree can refit or rebuild the mesh's triangles
+		Vertex* buffer = static_cast<Vertex*>(rtcGetGeometryBufferData(mesh, RTC_BUFFER_TYPE_VERTEX, 0));
+		for (int i = 0; i < num_vertices; i++)
+			buffer[i] = Vertex{ new_vertices[3 * i], new_vertices[3 * i + 1], new_vertices[3 * i + 2] };
+		rtcUpdateGeometryBuffer(mesh, RTC_BUFFER_TYPE_VERTEX, 0);
+		rtcCommitGeometry(mesh);
+
+		// Rebuild the prototype, then let the instance know that its bounds changed
+		if (prototype) {
+			rtcCommitScene(prototype);
+			rtcCommitGeometry(geom);
+		}
+		state->version++;
+
+		if (Commit)
+			rtcCommitScene(scene);
+
+		return true;
+	}
+
+	bool EmbreeRayTracer::RemoveMesh(int mesh_id, bool Commit)
+	{
+		const auto it = state->geometry_ids.find(mesh_id);
+		if (it == state->geometry_ids.end()) return false;
+
+		// The same geometry may be attached with more than one ID, so detach it from all of them
+		RTCGeometry geom = it->second;
+		for (auto id_it = state->geometry_ids.begin(); id_it != state->geometry_ids.end();) {
+			if (id_it->second == geom) {
+				rtcDetachGeometry(scene, id_it->first);
+				state->triangle_attributes.erase(id_it->first);
+				id_it = state->geometry_ids.erase(id_it);
+			}
+			else
+				++id_it;
+		}
+		state->geometry.erase(std::remove(state->geometry.begin(), state->geometry.end(), geom), state->geometry.end());
+
+		// Nothing in this scene reads the mesh's buffers anymore. Subsets hold on to buffers of their own.
+		state->vertex_counts.erase(geom);
+		state->shared_buffers.erase(geom);
+		state->version++;
+
+		if (Commit)
+			rtcCommitScene(scene);
+
+		return true;
+	}
+
+	bool EmbreeRayTracer::SetMeshTransform(int mesh_id, const std::array<float, 12>& transform, bool Commit)
+	{
+		const auto it = state->geometry_ids.find(mesh_id);
+		if (it == state->geometry_ids.end()) return false;
+
+		RTCGeometry geom = it->second;
+		if (!PrototypeOf(geom)) {
+			// Move the mesh into a prototype of its own
+			RTCScene prototype = CreatePrototype(geom);
+
+			RTCGeometry instance = rtcNewGeometry(device, RTC_GEOMETRY_TYPE_INSTANCE);
+			rtcSetGeometryInstancedScene(instance, prototype);
+			rtcSetGeometryUserData(instance, prototype);
+			state->geometry.push_back(instance);
+
+			// Put the instance in the mesh's place under every ID the mesh had
+			for (auto& [id, attached] : state->geometry_ids) {
+				if (attached != geom) continue;
+				rtcDetachGeometry(scene, id);
+				rtcAttachGeometryByID(scene, instance, id);
+				attached = instance;
+			}
+			geom = instance;
+		}
+
+		rtcSetGeometryTransform(geom, 0, RTC_FORMAT_FLOAT3X4_COLUMN_MAJOR, transform.data());
+		rtcCommitGeometry(geom);
+		state->version++;
+
+		if (Commit)
+			rtcCommitScene(scene);
+
+		return true;
+	}
+
 	bool EmbreeRayTracer::PointIntersection(
 		std::array<float, 3>& origin,
 		const std::array<float, 3>& dir,
@@ -447,11 +930,12 @@ namespace HF::RayTracer {
 		return	Vector3D{buffer[index].x, buffer[index].y,buffer[index].z};
 	}
 
-	std::array<Vector3D, 3> EmbreeRayTracer::GetTriangle(unsigned int geomID, unsigned int primID) const
+	/// <summary> Get the vertices of a triangle from the buffers of a geometry. </summary>
+	inline std::array<Vector3D, 3> TriangleFromGeometry(RTCGeometry geom, unsigned int primID)
 	{
-		// Get the index buffer for the geometry at geomID
+		// Get the index buffer for the geometry
 		Triangle* index_buffer = reinterpret_cast<Triangle*>(rtcGetGeometryBufferData(
-			rtcGetGeometry(this->scene, geomID),
+			geom,
 			RTCBufferType::RTC_BUFFER_TYPE_INDEX,
 			0
 		));
@@ -464,7 +948,7 @@ namespace HF::RayTracer {
 
 		// Get a pointer to this geometry's vertex buffer
 		Vertex * vertex_buffer = reinterpret_cast<Vertex *>(rtcGetGeometryBufferData(
-			rtcGetGeometry(this->scene, geomID),
+			geom,
 			RTCBufferType::RTC_BUFFER_TYPE_VERTEX,
 			0
 		));
@@ -477,6 +961,189 @@ namespace HF::RayTracer {
 		};
 	}
 
+	/*!
+		\brief Find the closest point to `p` on the triangle `a`, `b`, `c`.
+
+		\remarks
+		Finds which vertex, edge, or the face of the triangle the point projects onto using
+		barycentric coordinates, as described in Ericson's Real-Time Collision Detection, 5.1.5.
+	*/
+	inline Vector3D ClosestPointOnTriangle(const Vector3D& p, const Vector3D& a, const Vector3D& b, const Vector3D& c)
+	{
+		const Vector3D ab = b - a, ac = c - a, ap = p - a;
+		const double d1 = dot(ab, ap), d2 = dot(ac, ap);
+		if (d1 <= 0 && d2 <= 0) return a;
+
+		const Vector3D bp = p - b;
+		const double d3 = dot(ab, bp), d4 = dot(ac, bp);
+		if (d3 >= 0 && d4 <= d3) return b;
+
+		const double vc = d1 * d4 - d3 * d2;
+		if (vc <= 0 && d1 >= 0 && d3 <= 0) return a + ab * (d1 / (d1 - d3));
+
+		const Vector3D cp = p - c;
+		const double d5 = dot(ab, cp), d6 = dot(ac, cp);
+		if (d6 >= 0 && d5 <= d6) return c;
+
+		const double vb = d5 * d2 - d1 * d6;
+		if (vb <= 0 && d2 >= 0 && d6 <= 0) return a + ac * (d2 / (d2 - d6));
+
+		const double va = d3 * d6 - d5 * d4;
+		if (va <= 0 && (d4 - d3) >= 0 && (d5 - d6) >= 0)
+			return b + (c - b) * ((d4 - d3) / ((d4 - d3) + (d5 - d6)));
+
+		const double denom = 1.0 / (va + vb + vc);
+		return a + ab * (vb * denom) + ac * (vc * denom);
+	}
+
+	/// The closest point found so far by a point query, and the settings of the query.
+	struct ClosestPointQuery {
+		RTCScene scene;			///< Scene being queried.
+		Vector3D point;			///< Point to find the closest surface to.
+		int mesh_id;			///< ID of the only mesh to consider, or -1 to consider every mesh.
+		double min_z;			///< Parts of triangles below this height are ignored.
+
+		double distance;								///< Distance from `point` to `closest`. Starts at the radius of the query.
+		Vector3D closest = Vector3D(0, 0, 0);			///< Closest point found so far.
+		unsigned int geom_id = RTC_INVALID_GEOMETRY_ID;	///< ID of the geometry `closest` is on.
+		unsigned int prim_id = RTC_INVALID_GEOMETRY_ID;	///< ID of the triangle `closest` is on.
+		unsigned int inst_id = RTC_INVALID_GEOMETRY_ID;	///< ID of the instance `closest` is in, if any.
+	};
+
+	/*!
+		\brief Check a triangle found by rtcPointQuery, and shrink the query if it's the closest so far.
+
+		\details
+		Triangles are moved into the scene's space before they're checked, so the query stays in
+		world space even inside instances. If the query has a minimum height, the triangle is first
+		clipped to the part above it, which leaves a polygon of up to 4 vertices.
+
+		\returns True if the radius of the query was shrunk.
+	*/
+	bool FindClosestPoint(RTCPointQueryFunctionArguments* args)
+	{
+		auto* query = reinterpret_cast<ClosestPointQuery*>(args->userPtr);
+		const unsigned int inst_id = args->context->instStackSize > 0 ? args->context->instID[0] : RTC_INVALID_GEOMETRY_ID;
+		if (query->mesh_id >= 0 && HitMeshID(args->geomID, inst_id) != static_cast<unsigned int>(query->mesh_id))
+			return false;
+
+		// Get the triangle, moving it to where its instance is
+		std::array<Vector3D, 3> triangle = [&]() {
+			if (inst_id == RTC_INVALID_GEOMETRY_ID)
+				return TriangleFromGeometry(rtcGetGeometry(query->scene, args->geomID), args->primID);
+
+			RTCGeometry instance = rtcGetGeometry(query->scene, inst_id);
+			RTCScene prototype = static_cast<RTCScene>(rtcGetGeometryUserData(instance));
+			auto instanced = TriangleFromGeometry(rtcGetGeometry(prototype, args->geomID), args->primID);
+
+			const float* m = args->context->inst2world[0];
+			for (auto& p : instanced)
+				p = Vector3D(
+					m[0] * p.x + m[4] * p.y + m[8] * p.z + m[12],
+					m[1] * p.x + m[5] * p.y + m[9] * p.z + m[13],
+					m[2] * p.x + m[6] * p.y + m[10] * p.z + m[14]
+				);
+			return instanced;
+		}();
+
+		// Clip the triangle to the part above min_z
+		std::array<Vector3D, 4> polygon{ triangle[0], triangle[0], triangle[0], triangle[0] };
+		int num_vertices = 0;
+		for (int i = 0; i < 3; i++) {
+			const Vector3D& a = triangle[i];
+			const Vector3D& b = triangle[(i + 1) % 3];
+			const bool a_above = a.z >= query->min_z, b_above = b.z >= query->min_z;
+			if (a_above) polygon[num_vertices++] = a;
+			if (a_above != b_above) polygon[num_vertices++] = a + (b - a) * ((query->min_z - a.z) / (b.z - a.z));
+		}
+
+		// Check every triangle in a fan of the clipped polygon
+		bool shrunk = false;
+		for (int i = 1; i + 1 < num_vertices; i++) {
+			const Vector3D closest = ClosestPointOnTriangle(query->point, polygon[0], polygon[i], polygon[i + 1]);
+			const Vector3D offset = closest - query->point;
+			const double distance = std::sqrt(dot(offset, offset));
+			if (distance < query->distance) {
+				query->distance = distance;
+				query->closest = closest;
+				query->geom_id = args->geomID;
+				query->prim_id = args->primID;
+				query->inst_id = inst_id;
+				shrunk = true;
+			}
+		}
+
+		if (shrunk && query->distance < args->query->radius)
+			args->query->radius = static_cast<float>(query->distance);
+		return shrunk;
+	}
+
+	ClosestPointHit<double> EmbreeRayTracer::ClosestPoint_IMPL(float x, float y, float z, float max_distance, int mesh_id, float min_height) const
+	{
+		const float radius = max_distance > 0 ? max_distance : INFINITY;
+		ClosestPointQuery query{ scene, Vector3D(x, y, z), mesh_id, static_cast<double>(z) + min_height, radius };
+
+		RTCPointQuery point_query;
+		point_query.x = x; point_query.y = y; point_query.z = z;
+		point_query.time = 0.0f;
+		point_query.radius = radius;
+
+		RTCPointQueryContext context;
+		rtcInitPointQueryContext(&context);
+		rtcPointQuery(scene, &point_query, &context, FindClosestPoint, &query);
+
+		ClosestPointHit<double> result;
+		if (!DidIntersect(query.geom_id)) return result;
+
+		result.distance = query.distance;
+		result.meshid = HitMeshID(query.geom_id, query.inst_id);
+		result.primid = static_cast<int>(query.prim_id);
+		result.point = { static_cast<float>(query.closest.x), static_cast<float>(query.closest.y), static_cast<float>(query.closest.z) };
+		return result;
+	}
+
+	std::array<Vector3D, 3> EmbreeRayTracer::GetTriangle(unsigned int geomID, unsigned int primID) const
+	{
+		return TriangleFromGeometry(rtcGetGeometry(this->scene, geomID), primID);
+	}
+
+	std::array<Vector3D, 3> EmbreeRayTracer::GetTriangle(unsigned int geomID, unsigned int primID, unsigned int instID) const
+	{
+		if (instID == RTC_INVALID_GEOMETRY_ID)
+			return GetTriangle(geomID, primID);
+
+		// Get the triangle from the prototype, then move it to where the instance is
+		RTCGeometry instance = state->geometry_ids.at(static_cast<int>(instID));
+		RTCScene prototype = static_cast<RTCScene>(rtcGetGeometryUserData(instance));
+		auto triangle = TriangleFromGeometry(rtcGetGeometry(prototype, geomID), primID);
+
+		const auto m = InstanceTransform(instance);
+		for (auto& p : triangle)
+			p = Vector3D(
+				m[0] * p.x + m[3] * p.y + m[6] * p.z + m[9],
+				m[1] * p.x + m[4] * p.y + m[7] * p.z + m[10],
+				m[2] * p.x + m[5] * p.y + m[8] * p.z + m[11]
+			);
+		return triangle;
+	}
+
+	void EmbreeRayTracer::TransformNormal(unsigned int instID, float& nx, float& ny, float& nz) const
+	{
+		// The normal of a triangle with its vertices transformed by M is the cofactor matrix of M
+		// times its original normal, whose columns are the cross products of M's columns
+		const auto m = InstanceTransform(state->geometry_ids.at(static_cast<int>(instID)));
+		const std::array<float, 3> x{ m[0], m[1], m[2] }, y{ m[3], m[4], m[5] }, z{ m[6], m[7], m[8] };
+		auto cross = [](const std::array<float, 3>& a, const std::array<float, 3>& b) {
+			return std::array<float, 3>{ a[1] * b[2] - a[2] * b[1], a[2] * b[0] - a[0] * b[2], a[0] * b[1] - a[1] * b[0] };
+		};
+		const auto cx = cross(y, z), cy = cross(z, x), cz = cross(x, y);
+
+		const float n[3] = { nx, ny, nz };
+		nx = cx[0] * n[0] + cy[0] * n[1] + cz[0] * n[2];
+		ny = cx[1] * n[0] + cy[1] * n[1] + cz[1] * n[2];
+		nz = cx[2] * n[0] + cy[2] * n[1] + cz[2] * n[2];
+	}
+
 	std::vector<char> EmbreeRayTracer::PointIntersections(
 		std::vector<std::array<float, 3>>& origins,
 		std::vector<std::array<float, 3>>& directions,
@@ -545,19 +1212,60 @@ namespace HF::RayTracer {
 		float dx, float dy, float dz,
 		float max_distance, int mesh_id)
 	{
-		RTCRayHit hit = ConstructHit(x, y, z, dx, dy, dz);
+		RTCRayHit hit = ConstructHit(x, y, z, dx, dy, dz, max_distance);
 
-		rtcIntersect1(scene, &context, &hit);
+		if (mesh_id < 0)
+			rtcIntersect1(scene, &context, &hit);
+		else {
+			MeshFilterContext filter_context = CreateMeshFilterContext(context, mesh_id);
+			rtcIntersect1(scene, &filter_context.context, &hit);
+		}
 
 		return hit;
 	}
 
+	std::vector<PrimitiveHit<double>> EmbreeRayTracer::IntersectAll_IMPL(
+		float x, float y, float z,
+		float dx, float dy, float dz,
+		int max_hits, float max_distance, int mesh_id)
+	{
+		std::vector<PrimitiveHit<double>> results;
+		if (max_hits <= 0) return results;
+
+		MultiHitContext multi_hit{ context, mesh_id, static_cast<unsigned int>(max_hits), {} };
+		multi_hit.context.filter = CollectHits;
+		multi_hit.hits.reserve(max_hits);
+
+		RTCRayHit hit = ConstructHit(x, y, z, dx, dy, dz, max_distance);
+		rtcIntersect1(scene, &multi_hit.context, &hit);
+
+		results.reserve(multi_hit.hits.size());
+		for (const auto& recorded : multi_hit.hits) {
+			// Use a precise ray intersection if required
+			const double distance = this->use_precise
+				? CalculatePreciseDistance(
+					recorded.geom_id,
+					recorded.prim_id,
+					Vector3D(x, y, z),
+					Vector3D(dx, dy, dz),
+					recorded.inst_id)
+				: recorded.distance;
+
+			results.emplace_back(
+				distance,
+				HitMeshID(recorded.geom_id, recorded.inst_id),
+				static_cast<int>(recorded.prim_id)
+			);
+		}
+		return results;
+	}
+
 	bool EmbreeRayTracer::Occluded_IMPL(
 		const std::array<float, 3>& origin,
 		const std::array<float, 3>& direction,
 		float max_dist
 	) {
-		return Occluded_IMPL(origin[0], origin[1], origin[2], direction[0], direction[1], direction[2]);
+		return Occluded_IMPL(origin[0], origin[1], origin[2], direction[0], direction[1], direction[2], max_dist);
 	}
 
 	std::vector<char> EmbreeRayTracer::Occlusions(
@@ -621,13 +1329,144 @@ namespace HF::RayTracer {
 		return out_array;
 	}
 
+	/// Number of rays passed to Embree at once when casting a RayBatch.
+	constexpr int batch_chunk_size = 1024;
+
+	void EmbreeRayTracer::IntersectBatch(RayBatch& batch, bool use_parallel)
+	{
+		const int n = batch.size();
+		const int num_chunks = (n + batch_chunk_size - 1) / batch_chunk_size;
+
+#pragma omp parallel for if(use_parallel) schedule(dynamic)
+		for (int chunk = 0; chunk < num_chunks; chunk++) {
+			const int start = chunk * batch_chunk_size;
+			const int count = (std::min)(batch_chunk_size, n - start);
+
+			// Components that Embree needs but the batch doesn't store
+			std::vector<float> time(count, 0.0f), ng_x(count), ng_y(count), ng_z(count), u(count), v(count);
+			std::vector<unsigned int> id(count), flags(count, 0), prim_id(count);
+			std::vector<unsigned int> geom_id(count, RTC_INVALID_GEOMETRY_ID), inst_id(count, RTC_INVALID_GEOMETRY_ID);
+			std::iota(id.begin(), id.end(), 0);
+
+			// Embree overwrites tfar with the distance to each hit, so start from a copy of it
+			float* tfar = batch.distance.data() + start;
+			std::copy(batch.tfar.begin() + start, batch.tfar.begin() + start + count, tfar);
+
+			RTCRayHitNp rays;
+			rays.ray.org_x = batch.org_x.data() + start;
+			rays.ray.org_y = batch.org_y.data() + start;
+			rays.ray.org_z = batch.org_z.data() + start;
+			rays.ray.dir_x = batch.dir_x.data() + start;
+			rays.ray.dir_y = batch.dir_y.data() + start;
+			rays.ray.dir_z = batch.dir_z.data() + start;
+			rays.ray.tnear = batch.tnear.data() + start;
+			rays.ray.tfar = tfar;
+			rays.ray.time = time.data();
+			rays.ray.mask = batch.mask.data() + start;
+			rays.ray.id = id.data();
+			rays.ray.flags = flags.data();
+			rays.hit.Ng_x = ng_x.data();
+			rays.hit.Ng_y = ng_y.data();
+			rays.hit.Ng_z = ng_z.data();
+			rays.hit.u = u.data();
+			rays.hit.v = v.data();
+			rays.hit.primID = prim_id.data();
+			rays.hit.geomID = geom_id.data();
+			rays.hit.instID[0] = inst_id.data();
+
+			RTCIntersectContext stream_context = context;
+			rtcIntersectNp(scene, &stream_context, &rays, count);
+
+			for (int i = 0; i < count; i++) {
+				const int ray = start + i;
+				if (!DidIntersect(geom_id[i])) {
+					batch.distance[ray] = -1;
+					batch.meshid[ray] = -1;
+					continue;
+				}
+
+				// Use a precise ray intersection if required
+				if (this->use_precise)
+					batch.distance[ray] = CalculatePreciseDistance(
+						geom_id[i],
+						prim_id[i],
+						Vector3D(batch.org_x[ray], batch.org_y[ray], batch.org_z[ray]),
+						Vector3D(batch.dir_x[ray], batch.dir_y[ray], batch.dir_z[ray]),
+						inst_id[i]
+					);
+				batch.meshid[ray] = HitMeshID(geom_id[i], inst_id[i]);
+			}
+		}
+	}
+
+	void EmbreeRayTracer::OccludedBatch(RayBatch& batch, bool use_parallel)
+	{
+		const int n = batch.size();
+		const int num_chunks = (n + batch_chunk_size - 1) / batch_chunk_size;
+
+#pragma omp parallel for if(use_parallel) schedule(dynamic)
+		for (int chunk = 0; chunk < num_chunks; chunk++) {
+			const int start = chunk * batch_chunk_size;
+			const int count = (std::min)(batch_chunk_size, n - start);
+
+			// Embree sets tfar to -infinity for rays that hit anything, so cast a copy of it
+			std::vector<float> tfar(batch.tfar.begin() + start, batch.tfar.begin() + start + count);
+			std::vector<float> time(count, 0.0f);
+			std::vector<unsigned int> id(count), flags(count, 0);
+			std::iota(id.begin(), id.end(), 0);
+
+			RTCRayNp rays;
+			rays.org_x = batch.org_x.data() + start;
+			rays.org_y = batch.org_y.data() + start;
+			rays.org_z = batch.org_z.data() + start;
+			rays.dir_x = batch.dir_x.data() + start;
+			rays.dir_y = batch.dir_y.data() + start;
+			rays.dir_z = batch.dir_z.data() + start;
+			rays.tnear = batch.tnear.data() + start;
+			rays.tfar = tfar.data();
+			rays.time = time.data();
+			rays.mask = batch.mask.data() + start;
+			rays.id = id.data();
+			rays.flags = flags.data();
+
+			RTCIntersectContext stream_context = context;
+			rtcOccludedNp(scene, &stream_context, &rays, count);
+
+			for (int i = 0; i < count; i++)
+				batch.occluded[start + i] = (tfar[i] == -INFINITY);
+		}
+	}
+
 	bool EmbreeRayTracer::Occluded_IMPL(float x, float y, float z, float dx, float dy, float dz, float distance, int mesh_id)
 	{
 		auto ray = ConstructRay(x, y, z, dx, dy, dz, distance);
-		rtcOccluded1(scene, &context, &ray);
+
+		if (mesh_id < 0)
+			rtcOccluded1(scene, &context, &ray);
+		else {
+			MeshFilterContext filter_context = CreateMeshFilterContext(context, mesh_id);
+			rtcOccluded1(scene, &filter_context.context, &ray);
+		}
 		return ray.tfar == -INFINITY;
 	}
 
+	void EmbreeRayTracer::Intersect16_IMPL(const int* valid, RTCRayHit16& rays)
+	{
+		// Rays in a packet are expected to be similar, so hint embree to trace them coherently
+		RTCIntersectContext packet_context = context;
+		packet_context.flags = RTC_INTERSECT_CONTEXT_FLAG_COHERENT;
+
+		rtcIntersect16(valid, scene, &packet_context, &rays);
+	}
+
+	void EmbreeRayTracer::Occluded16_IMPL(const int* valid, RTCRay16& rays)
+	{
+		RTCIntersectContext packet_context = context;
+		packet_context.flags = RTC_INTERSECT_CONTEXT_FLAG_COHERENT;
+
+		rtcOccluded16(valid, scene, &packet_context, &rays);
+	}
+
 	// Increment reference counters to prevent destruction when this thing goes out of scope
 	void EmbreeRayTracer::operator=(const EmbreeRayTracer& ERT2) {
 
@@ -635,7 +1474,8 @@ namespace HF::RayTracer {
 		device = ERT2.device;
 		context = ERT2.context;
 		scene = ERT2.scene;
-		geometry = ERT2.geometry;
+		state = ERT2.state;
+		build_options = ERT2.build_options;
 
 		rtcRetainScene(scene);
 		rtcRetainDevice(device);
@@ -15,7 +15,12 @@
 #include <corecrt_math_defines.h>
 #include <vector>
 #include <array>
+#include <algorithm>
+#include <cmath>
+#include <map>
+#include <memory>
 #include <HitStruct.h>
+#include <embree_device.h>
 #define _USE_MATH_DEFINES
 
 namespace HF::Geometry {
@@ -52,6 +57,13 @@ namespace HF::RayTracer {
 				z - v2.z
 			};
 		}
+		inline Vector3D operator+(const Vector3D& v2) const {
+			return Vector3D{
+				x + v2.x,
+				y + v2.y,
+				z + v2.z
+			};
+		}
 		// Scalar multiplication overload 
 		inline Vector3D operator*(const double&a) const {
 			return Vector3D{
@@ -65,10 +77,53 @@ namespace HF::RayTracer {
 	//*! \brief Determine whether this mesh did or did not intersect */
 	bool DidIntersect(int mesh_id);
 
+	/*! \brief Get the ID of the mesh a hit belongs to.
+
+		\param geom_id ID of the hit geometry, from Embree's hit.geomID.
+		\param inst_id ID of the instance the hit geometry was in, from Embree's hit.instID[0].
+
+		\returns `inst_id` if the hit was inside an instance, `geom_id` otherwise.
+	*/
+	inline unsigned int HitMeshID(unsigned int geom_id, unsigned int inst_id) {
+		return inst_id == RTC_INVALID_GEOMETRY_ID ? geom_id : inst_id;
+	}
+
 	struct RayRequest;
+	struct RayBatch;
 	struct Vertex;
 	struct Triangle;
 
+	/*!
+		\brief Set a single lane of a 16-wide ray packet.
+
+		\param packet Packet to update.
+		\param lane Index of the lane to update.
+		\param x X component of the ray's origin.
+		\param y Y component of the ray's origin.
+		\param z Z component of the ray's origin.
+		\param dx X component of the ray's direction.
+		\param dy Y component of the ray's direction.
+		\param dz Z component of the ray's direction.
+		\param tnear Start of the ray segment.
+		\param distance Maximum distance of the ray. If not greater than zero, the ray will be infinite.
+	*/
+	inline void SetPacketLane(
+		RTCRay16& packet, int lane,
+		float x, float y, float z,
+		float dx, float dy, float dz,
+		float tnear, float distance)
+	{
+		packet.org_x[lane] = x; packet.org_y[lane] = y; packet.org_z[lane] = z;
+		packet.dir_x[lane] = dx; packet.dir_y[lane] = dy; packet.dir_z[lane] = dz;
+
+		packet.tnear[lane] = tnear;
+		packet.tfar[lane] = distance > 0 ? distance : INFINITY;
+		packet.time[lane] = 0.0f;
+		packet.mask[lane] = -1;
+		packet.id[lane] = lane;
+		packet.flags[lane] = 0;
+	}
+
 	/// <summary> A wrapper for Intel's Embree Library. </summary>
 	/// <remarks>
 	/// Provides several functions to quickly and simply perform ray intersections using Embree.
@@ -76,7 +131,8 @@ namespace HF::RayTracer {
 	/// Embree's reference counters on copy, and decrementing them on deletion. This class also
 	/// provides methods for adding geometry to Embree's geometry buffers.
 	/// </remarks>
-	/// \todo Many functions support MeshID but don't actually check for it. 
+	/// Rays cast with a mesh ID skip hits on every other mesh with an intersection filter, so they
+	/// still traverse the full BVH. Use Subset to build a ray tracer that only contains some meshes.
 	class EmbreeRayTracer {
 		/// All objects in Embree are created from this. https://www.embree.org/api.html#device-object
 		RTCDevice device; 
@@ -90,17 +146,29 @@ namespace HF::RayTracer {
 		Vertex* Vertices;
 
 		bool use_precise = false; ///< If true, use custom triangle intersection intersection instead of embree's
-
-		std::vector<RTCGeometry> geometry; //> A list of the geometry being used by RTCScene.
+		BuildOptions build_options; ///< Settings used to build the BVH of scene.
+
+		/// Everything known about the meshes in scene. Copies of a raytracer share its scene, so they share this
+		/// too, and meshes added, edited or removed through any of them are seen by all of them.
+		struct SceneState {
+			std::vector<RTCGeometry> geometry; //> A list of the geometry being used by RTCScene.
+			std::map<int, RTCGeometry> geometry_ids; ///< Every geometry attached to scene, by the ID it was attached with.
+			std::map<int, std::shared_ptr<const std::vector<int>>> triangle_attributes; ///< Attribute of every triangle, by the ID of its mesh.
+			std::vector<std::shared_ptr<RTCSceneTy>> prototypes; ///< Scene holding the mesh of every prototype, by prototype ID.
+			std::map<RTCGeometry, int> vertex_counts; ///< Number of vertices in every triangle geometry.
+			std::map<RTCGeometry, std::vector<std::shared_ptr<const void>>> shared_buffers; ///< Index and vertex buffer that Embree reads every triangle geometry from.
+			unsigned int version = 0; ///< Incremented every time a mesh or its attributes change. \see SceneVersion
+		};
+		std::shared_ptr<SceneState> state; ///< Meshes of scene, shared with every copy of this raytracer.
 
 	private:
 		/*! \brief Performs all the necessary operations to set up the scene.
 
 			\details
-			1) Creates device
+			1) Acquires the shared device
 			2) Creates the scene using device
-			3) Sets the build quality of the scene
-			4) Sets scene flags
+			3) Sets the build quality of the scene from build_options
+			4) Sets scene flags from build_options
 			5) Inits Intersect_IMPL context
 
 
@@ -108,9 +176,17 @@ namespace HF::RayTracer {
 			Any changes to the internal settings of embree should be handled here. I.E. Enforcing
 			That all bvh's used be of robust quality, assigning a custom context, etc.
 
+			\see AcquireDevice for details on the shared device.
+
 		*/
 		void SetupScene();
 
+		/*! \brief Create an empty scene on device with the same settings as SetupScene, and empty state to go with it.
+		
+			\pre `device` has been created.
+		*/
+		void CreateScene();
+
 		/*! 
 			\brief Get the vertices for a specific triangle in a mesh.
 		
@@ -126,6 +202,48 @@ namespace HF::RayTracer {
 		*/
 		std::array<Vector3D, 3> GetTriangle(unsigned int geomID, unsigned int primID) const;
 
+		/*!
+			\brief Get the vertices of a triangle in a mesh that may be inside an instance.
+
+			\param geomID ID of the geometry the triangle belongs to.
+			\param primID ID of the triangle to retrieve.
+			\param instID ID of the instance the geometry is in, or RTC_INVALID_GEOMETRY_ID if it
+						  isn't in an instance.
+
+			\returns The 3 vertices of the triangle, transformed by the instance if there is one.
+		*/
+		std::array<Vector3D, 3> GetTriangle(unsigned int geomID, unsigned int primID, unsigned int instID) const;
+
+		/*!
+			\brief Transform a normal from the space of an instance's prototype into the scene.
+
+			\param instID ID of the instance.
+			\param nx X component of the normal. Updated with the transformed normal.
+			\param ny Y component of the normal. Updated with the transformed normal.
+			\param nz Z component of the normal. Updated with the transformed normal.
+
+			\remarks The transformed normal isn't normalized.
+		*/
+		void TransformNormal(unsigned int instID, float& nx, float& ny, float& nz) const;
+
+		/*!
+			\brief Get the prototype of an instance.
+
+			\param geom Geometry to get the prototype of.
+
+			\returns The scene instanced by `geom`, or nullptr if `geom` isn't an instance.
+		*/
+		RTCScene PrototypeOf(RTCGeometry geom) const;
+
+		/*!
+			\brief Put geometry in a scene of its own that instances can share, and add it to `prototypes`.
+
+			\param geom Geometry to use as the prototype.
+
+			\returns The scene of the new prototype.
+		*/
+		RTCScene CreatePrototype(RTCGeometry geom);
+
 		/*!\brief Attach geometry to the current scene.
 			
 			\param geom Geometry to attach
@@ -143,6 +261,7 @@ namespace HF::RayTracer {
 			\param prim_id ID of the primitive in geometry the ray intersected
 			\param origin The origin point of the ray
 			\param direction the direction the ray was casted in
+			\param inst_id ID of the instance the geometry was in, or RTC_INVALID_GEOMETRY_ID if it wasn't in one
 
 			\returns The distance between origin and the triangle it intersected
 
@@ -164,7 +283,8 @@ namespace HF::RayTracer {
 			unsigned int geom_id,
 			unsigned int prim_id,
 			const Vector3D& origin,
-			const Vector3D& direction) const;
+			const Vector3D& direction,
+			unsigned int inst_id = RTC_INVALID_GEOMETRY_ID) const;
 
 		/// <summary> Implementation for fundamental ray intersection. </summary>
 		/// <param name="x"> x component of the ray's origin. </param>
@@ -178,8 +298,8 @@ namespace HF::RayTracer {
 		/// ignored. If set to -1, all intersections will be counted regardless of distance.
 		/// </param>
 		/// <param name="mesh_id">
-		/// (UNIMPLEMENTED) the id of the only mesh for this ray to collide with. Any geometry
-		/// wihtout this ID is ignored.
+		/// The id of the only mesh for this ray to collide with. Any geometry without this ID
+		/// is ignored. If set to -1, every mesh is counted.
 		/// </param>
 		/// <returns> A HitStruct containing information about the intersection if any occurred. </returns>
 		/**
@@ -235,6 +355,45 @@ namespace HF::RayTracer {
 			int mesh_id = -1
 		);
 
+		/*! \brief Collect the closest hits along a single ray in one traversal of the BVH.
+
+			\param x X component of the ray's origin.
+			\param y Y component of the ray's origin.
+			\param z Z component of the ray's origin.
+			\param dx X component of the ray's direction.
+			\param dy Y component of the ray's direction.
+			\param dz Z component of the ray's direction.
+			\param max_hits Maximum number of hits to collect.
+			\param max_distance Maximum distance of the ray. Set to -1 for infinite distance.
+			\param mesh_id Only collect hits on the mesh with this ID. Set to -1 to collect hits on every mesh.
+
+			\returns Up to `max_hits` hits, sorted from nearest to farthest. Distances are calculated
+					 with CalculatePreciseDistance if `use_precise` is set.
+
+			\see IntersectAll for a description of how hits are collected.
+		*/
+		std::vector<PrimitiveHit<double>> IntersectAll_IMPL(
+			float x, float y, float z,
+			float dx, float dy, float dz,
+			int max_hits, float max_distance, int mesh_id
+		);
+
+		/*! \brief Find the closest point on any surface to a point with rtcPointQuery.
+
+			\param x X coordinate of the query point.
+			\param y Y coordinate of the query point.
+			\param z Z coordinate of the query point.
+			\param max_distance Only consider surfaces within this distance. Set to -1 for infinite distance.
+			\param mesh_id Only consider the mesh with this ID. Set to -1 to consider every mesh.
+			\param min_height Ignore the parts of surfaces lower than this distance above the query point.
+
+			\see ClosestPoint for a description of the result.
+		*/
+		ClosestPointHit<double> ClosestPoint_IMPL(
+			float x, float y, float z,
+			float max_distance, int mesh_id, float min_height
+		) const;
+
 		/// <summary> Implementation for fundamental occlusion ray intersection. </summary>
 		/// <param name="x"> x component of the ray's origin. </param>
 		/// <param name="y"> y component of the ray's origin. </param>
@@ -247,7 +406,7 @@ namespace HF::RayTracer {
 		/// negative, count all hits regardless of distance.
 		/// </param>
 		/// <param name="mesh_id">
-		/// (NOT IMPLEMENTED) The id of the only mesh for this ray to collide with. -1 for all.
+		/// The id of the only mesh for this ray to collide with. -1 for all.
 		/// </param>
 		/// <returns> True if the ray intersected any geometry. False otherwise. </returns>
 		/*!
@@ -370,20 +529,225 @@ namespace HF::RayTracer {
 		/*!
 			\brief Create a new instance of RTCGeometry from a triangle and vertex buffer
 
-			\param tris Triangle buffer to construct new geometry with
-			\param verts Vertex buffer to construct geometry with
+			\param tris Triangle buffer to construct new geometry with. Its contents are moved into the geometry.
+			\param verts Vertex buffer to construct geometry with. Its contents are moved into the geometry.
 
 			\returns Committed Geometry containing the specified triangles and vertices.
 
 		*/
 		RTCGeometry ConstructGeometryFromBuffers(std::vector<Triangle>& tris, std::vector<Vertex>& verts);
 
+		/*!
+			\brief Create a new instance of RTCGeometry that reads from buffers owned by this raytracer.
+
+			\param tris Triangle buffer, followed by one triangle of padding.
+			\param verts Vertex buffer, followed by one vertex of padding.
+
+			\returns Committed Geometry containing the specified triangles and vertices.
+
+			\details
+			The buffers are given to Embree with `rtcSetSharedGeometryBuffer` instead of being copied
+			into buffers allocated by Embree. Embree reads the last element of a buffer with 16 byte
+			loads, so the padding keeps those reads inside the buffer. The buffers are kept alive
+			by `shared_buffers` until the mesh is removed, or this raytracer, every copy of it, and every
+			subset of it are destroyed.
+		*/
+		RTCGeometry ConstructSharedGeometry(std::vector<Triangle>&& tris, std::vector<Vertex>&& verts);
+
+		/*!
+			\brief Create a new instance of RTCGeometry from the vertices and indices of a mesh.
+
+			\param mesh Mesh to construct geometry from.
+
+			\returns Committed Geometry containing the triangles of `mesh`.
+
+			\details
+			The mesh's storage is copied once, straight into the padded buffers that Embree shares.
+			Embree holds no copy of its own, so `mesh` can be destroyed as soon as this returns.
+
+			\throws HF::Exceptions::InvalidOBJ if `mesh` has no triangles.
+		*/
+		RTCGeometry ConstructGeometryFromMesh(const HF::Geometry::MeshInfo<float>& mesh);
+
+		/*! \brief Store the surface of a hit. Does nothing for hits that don't describe their surface.
+
+			\see StoreSurface(SurfaceHit<return_type>&, unsigned int, float, float, float, float, float, unsigned int) const
+		*/
+		template <typename return_type>
+		inline void StoreSurface(HitStruct<return_type>& out, unsigned int prim_id, float u, float v, float nx, float ny, float nz, unsigned int inst_id) const {}
+
+		/*! \brief Store the triangle, barycentric coordinates, normal and attribute of a hit.
+
+			\param out Hit to update. Its meshid must already be set to the mesh that was hit.
+			\param prim_id ID of the hit triangle in its mesh.
+			\param u Barycentric weight of the second vertex of the triangle.
+			\param v Barycentric weight of the third vertex of the triangle.
+			\param nx X component of the unnormalized geometric normal computed by Embree.
+			\param ny Y component of the unnormalized geometric normal computed by Embree.
+			\param nz Z component of the unnormalized geometric normal computed by Embree.
+			\param inst_id ID of the instance the triangle was in, or RTC_INVALID_GEOMETRY_ID if it wasn't in one.
+		*/
+		template <typename return_type>
+		inline void StoreSurface(SurfaceHit<return_type>& out, unsigned int prim_id, float u, float v, float nx, float ny, float nz, unsigned int inst_id) const {
+			out.primid = static_cast<int>(prim_id);
+			out.u = u;
+			out.v = v;
+
+			// Embree gives the normal of hits inside instances in the space of their prototype
+			if (inst_id != RTC_INVALID_GEOMETRY_ID)
+				TransformNormal(inst_id, nx, ny, nz);
+
+			// Embree's normal points away from the side the vertices wind counter-clockwise around
+			const float length = std::sqrt(nx * nx + ny * ny + nz * nz);
+			if (length > 0) out.normal = { -nx / length, -ny / length, -nz / length };
+
+			out.attribute = TriangleAttribute(out.meshid, out.primid);
+		}
+
+		/*! \brief Cast a single ray and store its result in a hit of any type.
+
+			\tparam hit_type HitStruct or SurfaceHit.
+
+			\see Intersect for a description of the parameters.
+		*/
+		template <typename hit_type, typename numeric1, typename numeric2>
+		hit_type CastRay(
+			numeric1 x, numeric1 y, numeric1 z,
+			numeric2 dx, numeric2 dy, numeric2 dz,
+			float distance, int mesh_id)
+		{
+			// create output value
+			hit_type out_struct;
+
+			// Cast the ray
+			auto result = Intersect_IMPL(
+				x,y,z,
+				dx,dy,dz, distance, mesh_id
+			);
+
+			// If an intersection occured, update the struct. 
+			if (DidIntersect(result.hit.geomID))
+			{
+				// Use a precise ray intersection if required
+				if (!(this->use_precise))
+					out_struct.distance = result.ray.tfar;
+				else
+					out_struct.distance = CalculatePreciseDistance(
+						result.hit.geomID,
+						result.hit.primID,
+						Vector3D(x,y,z),
+						Vector3D(dx,dy,dz),
+						result.hit.instID[0]
+					);
+				out_struct.meshid = HitMeshID(result.hit.geomID, result.hit.instID[0]);
+				StoreSurface(
+					out_struct, result.hit.primID, result.hit.u, result.hit.v,
+					result.hit.Ng_x, result.hit.Ng_y, result.hit.Ng_z, result.hit.instID[0]
+				);
+			}
+
+			return out_struct;
+		}
+
+		/*! \brief Cast rays in 16-wide packets and store their results in hits of any type.
+
+			\tparam hit_type HitStruct or SurfaceHit.
+
+			\see PacketIntersections for a description of the parameters.
+		*/
+		template <typename hit_type, typename N, typename V>
+		std::vector<hit_type> CastPackets(const N& origins, const V& directions)
+		{
+			const int n = static_cast<int>(origins.size());
+			std::vector<hit_type> results(n);
+
+			alignas(64) int valid[16];
+			RTCRayHit16 packet;
+
+			for (int start = 0; start < n; start += 16) {
+				const int count = (std::min)(16, n - start);
+
+				// Fill every lane of the packet, masking off lanes past the end of the input
+				for (int lane = 0; lane < 16; lane++) {
+					if (lane < count) {
+						const auto& origin = origins[start + lane];
+						const auto& direction = directions[start + lane];
+						SetPacketLane(
+							packet.ray, lane,
+							origin[0], origin[1], origin[2],
+							direction[0], direction[1], direction[2],
+							0.00000001f, -1.0f
+						);
+						packet.hit.geomID[lane] = RTC_INVALID_GEOMETRY_ID;
+						packet.hit.instID[0][lane] = RTC_INVALID_GEOMETRY_ID;
+						valid[lane] = -1;
+					}
+					else
+						valid[lane] = 0;
+				}
+
+				Intersect16_IMPL(valid, packet);
+
+				// Copy results for all valid lanes
+				for (int lane = 0; lane < count; lane++) {
+					if (!DidIntersect(packet.hit.geomID[lane])) continue;
+
+					const auto& origin = origins[start + lane];
+					const auto& direction = directions[start + lane];
+					auto& out_struct = results[start + lane];
+
+					// Use a precise ray intersection if required
+					if (!(this->use_precise))
+						out_struct.distance = packet.ray.tfar[lane];
+					else
+						out_struct.distance = CalculatePreciseDistance(
+							packet.hit.geomID[lane],
+							packet.hit.primID[lane],
+							Vector3D(origin[0], origin[1], origin[2]),
+							Vector3D(direction[0], direction[1], direction[2]),
+							packet.hit.instID[0][lane]
+						);
+					out_struct.meshid = HitMeshID(packet.hit.geomID[lane], packet.hit.instID[0][lane]);
+					StoreSurface(
+						out_struct, packet.hit.primID[lane], packet.hit.u[lane], packet.hit.v[lane],
+						packet.hit.Ng_x[lane], packet.hit.Ng_y[lane], packet.hit.Ng_z[lane], packet.hit.instID[0][lane]
+					);
+				}
+			}
+			return results;
+		}
+
+		/*!
+			\brief Trace a packet of up to 16 rays with rtcIntersect16.
+
+			\param valid Validity mask for the packet. Lanes set to -1 are traced, lanes set to 0 are ignored.
+			\param rays Packet of rays to trace. On return, contains the results of every valid lane.
+
+			\pre `valid` must be aligned to a 64 byte boundary.
+
+			\see PacketIntersections for filling a packet from containers of origins and directions.
+		*/
+		void Intersect16_IMPL(const int* valid, RTCRayHit16& rays);
+
+		/*!
+			\brief Trace a packet of up to 16 occlusion rays with rtcOccluded16.
+
+			\param valid Validity mask for the packet. Lanes set to -1 are traced, lanes set to 0 are ignored.
+			\param rays Packet of rays to trace. The tfar of every occluded lane will be set to -infinity.
+
+			\pre `valid` must be aligned to a 64 byte boundary.
+
+			\see PacketOcclusions for filling a packet from containers of origins and directions.
+		*/
+		void Occluded16_IMPL(const int* valid, RTCRay16& rays);
+
 	public:
 		/*!
 			\brief Construct an empty EmbreeRayTracer;
 		
 			\param use_precise If set to true, use a more precise intesection algorithm to determine
 				   the distance between rays origin points and their points of intesection
+			\param options Settings to build the BVH with.
 			\code
 				// Requires #include "embree_raytracer.h", #include "objloader.h"
 
@@ -394,7 +758,7 @@ namespace HF::RayTracer {
 				EmbreeRayTracer ert;
 			\endcode
 		*/
-		EmbreeRayTracer(bool use_precise = false);
+		EmbreeRayTracer(bool use_precise = false, const BuildOptions& options = BuildOptions());
 
 		/// <summary> Create a new EmbreeRayTracer and add a single mesh to the scene. </summary>
 		/// <param name="MI"> The mesh to use for scene construction. </param>
@@ -426,14 +790,35 @@ namespace HF::RayTracer {
 		*/
 		EmbreeRayTracer(std::vector<HF::Geometry::MeshInfo<float>>& MI, bool use_precise_intersection = false);
 
+		/*!
+			\brief Create a new EmbreeRayTracer from several meshes with custom settings for its BVH.
+
+			\param MI The meshes to use for scene construction.
+			\param use_precise_intersection If set to true, use a more precise intesection algorithm to determine
+											the distance between rays origin points and their points of intesection
+			\param options Settings to build the BVH with.
+
+			\throws std::logic_error if MI is empty.
+		*/
+		EmbreeRayTracer(
+			std::vector<HF::Geometry::MeshInfo<float>>& MI,
+			bool use_precise_intersection,
+			const BuildOptions& options
+		);
+
 		/*! 
 			\brief Construct the raytracer using only a single mesh.
 			
 			\param MI MeshInfo<float> instance to create the BVH with.
 			\param use_precise If set to true, use a more precise intesection algorithm to determine
 							   the distance between rays origin points and their points of intesection
+			\param options Settings to build the BVH with.
 		*/
-		EmbreeRayTracer(HF::Geometry::MeshInfo<float>& MI, bool use_precise = false);
+		EmbreeRayTracer(
+			HF::Geometry::MeshInfo<float>& MI,
+			bool use_precise = false,
+			const BuildOptions& options = BuildOptions()
+		);
 
 
 		/*! \brief Construct a raytracer using another raytracer.
@@ -642,6 +1027,163 @@ namespace HF::RayTracer {
 */
 		bool AddMesh(std::vector<HF::Geometry::MeshInfo<float>>& Meshes, bool Commit = true);
 
+		/*!
+			\brief Add a mesh that can be placed in the scene any number of times with AddInstance.
+
+			\param Mesh Mesh to use as the prototype. Its ID is ignored.
+
+			\returns The ID of the new prototype.
+
+			\details
+			The prototype gets a BVH of its own, which is shared by every instance of it. Prototypes
+			aren't part of the scene until they're instanced.
+
+			\throws HF::Exceptions::InvalidOBJ if `Mesh` has no triangles.
+		*/
+		int AddPrototype(const HF::Geometry::MeshInfo<float>& Mesh);
+
+		/*!
+			\brief Place a copy of a prototype in the scene.
+
+			\param prototype_id ID of the prototype to place, from AddPrototype.
+			\param transform Transformation from the space of the prototype to the scene, as a 3x4
+							 column major matrix. The first three columns are the X, Y and Z axes of the
+							 prototype, and the last column is its translation.
+			\param mesh_id ID to give the instance. If this ID is already taken, the next available ID is
+						   used instead. Set to -1 to always use the next available ID.
+			\param Commit Whether or not to commit the scene after adding the instance.
+
+			\returns The mesh ID of the instance.
+
+			\details
+			Hits on an instance report the mesh ID of the instance, so every copy of a prototype can be
+			told apart. The triangles of the prototype aren't copied, so memory use and build time grow
+			with the number of unique meshes rather than the number of copies.
+
+			\throws std::out_of_range if `prototype_id` isn't the ID of a prototype.
+		*/
+		int AddInstance(int prototype_id, const std::array<float, 12>& transform, int mesh_id = -1, bool Commit = true);
+
+		/*!
+			\brief Add several meshes, sharing the geometry of meshes that are moved copies of each other.
+
+			\param Meshes Meshes to add. Their IDs are updated to the IDs they were added with.
+			\param Commit Whether or not to commit the scene after adding the meshes.
+
+			\returns True.
+
+			\details
+			Meshes with the same triangles whose vertices only differ by a translation are found, such as
+			repeated groups of an OBJ. One prototype is created for each set of copies, and every mesh in the
+			set is added as an instance of it. Every other mesh is added as it would be by AddMesh.
+
+			\remarks
+			Vertices must match to within 0.0001 units after the translation to be considered copies.
+			Rotated copies aren't detected; use AddPrototype and AddInstance to place them.
+
+			\throws HF::Exceptions::InvalidOBJ if any mesh has no triangles.
+		*/
+		bool AddInstancedMeshes(std::vector<HF::Geometry::MeshInfo<float>>& Meshes, bool Commit = true);
+
+		/// \brief Get the number of prototypes added with AddPrototype.
+		int NumPrototypes() const;
+
+		/*!
+			\brief Move the vertices of a mesh without changing its triangles.
+
+			\param mesh_id ID of the mesh to update.
+			\param vertices New X, Y, and Z coordinates of every vertex of the mesh, one after another.
+			\param Commit Whether or not to commit the scene after updating the mesh.
+
+			\returns False if there's no mesh with the ID `mesh_id`, true otherwise.
+
+			\details
+			The vertex buffer of the mesh is overwritten in place, so no buffers are reallocated. Committing
+			the scene still rebuilds its entire BVH with the default build options. If the ray tracer was
+			built with BuildOptions::dynamic set, the scene keeps a BVH for each mesh, so only the edited
+			mesh's BVH is refit before the top-level BVH over every mesh is rebuilt.
+
+			`vertices` are where the vertices should be in the scene, even if the mesh is an instance.
+			They're moved into the space of its prototype with the inverse of its transform. If other
+			meshes are instances of the same prototype, this mesh is given a copy of the prototype first
+			so the others don't move. Otherwise the prototype is edited in place, and instances of it
+			added with AddInstance afterwards have the new vertices.
+
+			\remarks
+			Subsets share meshes with the ray tracer they were created from, but aren't committed again.
+
+			\throws std::invalid_argument if `vertices` doesn't have 3 coordinates for every vertex of
+					the mesh, or the mesh is an instance whose transform can't be inverted.
+		*/
+		bool UpdateMesh(int mesh_id, const std::vector<float>& vertices, bool Commit = true);
+
+		/*!
+			\brief Remove a mesh from the scene.
+
+			\param mesh_id ID of the mesh to remove.
+			\param Commit Whether or not to commit the scene after removing the mesh.
+
+			\returns False if there's no mesh with the ID `mesh_id`, true otherwise.
+
+			\details The mesh's ID and triangle attributes are removed along with it.
+
+			\remarks
+			Copies of this raytracer share its scene, so the mesh is removed from them as well.
+		*/
+		bool RemoveMesh(int mesh_id, bool Commit = true);
+
+		/*!
+			\brief Change where a mesh is placed in the scene.
+
+			\param mesh_id ID of the mesh to move.
+			\param transform Transformation from the original space of the mesh to the scene, as a 3x4
+							 column major matrix. See AddInstance for the layout.
+			\param Commit Whether or not to commit the scene after moving the mesh.
+
+			\returns False if there's no mesh with the ID `mesh_id`, true otherwise.
+
+			\details
+			Instances have their transform replaced. Any other mesh is moved into a prototype of its own
+			the first time it's transformed, and an instance of it takes its place with the same ID. After
+			that, changing its transform only rebuilds the top level of the BVH, and none of the mesh's
+			triangles.
+		*/
+		bool SetMeshTransform(int mesh_id, const std::array<float, 12>& transform, bool Commit = true);
+
+		/*!
+			\brief Create a raytracer containing only some of the meshes in this raytracer.
+
+			\param mesh_ids IDs of the meshes to include. IDs that don't belong to any mesh are ignored.
+			\param exclude If true, include every mesh except those in `mesh_ids` instead.
+
+			\returns A raytracer with its own scene that shares the device and geometry of this raytracer.
+					 Meshes keep the IDs they have in this raytracer.
+
+			\details
+			Rays cast in the new scene only traverse the BVH of the selected meshes, which is much
+			faster when they make up a small part of the scene. No geometry is copied.
+
+			\remarks
+			The new scene is committed once on creation. Meshes added, edited or removed in this
+			raytracer afterwards won't be reflected in it; use SceneVersion to tell when it needs to be
+			created again.
+		*/
+		EmbreeRayTracer Subset(const std::vector<int>& mesh_ids, bool exclude = false) const;
+
+		/*!
+			\brief Change the settings used to build the BVH, and rebuild it.
+
+			\param options Settings to build the BVH with.
+
+			\remarks
+			Copies of this raytracer share its scene, so the settings change for them as well.
+			Subsets created afterwards use the new settings. Prototypes are rebuilt as well.
+		*/
+		void SetBuildOptions(const BuildOptions& options);
+
+		/// \brief Get the settings used to build the BVH.
+		const BuildOptions& GetBuildOptions() const;
+
 		/// <summary>
 		/// Cast a ray and overwrite the origin with the hitpoint if it intersects any geometry.
 		/// </summary>
@@ -654,7 +1196,7 @@ namespace HF::RayTracer {
 		/// regardless of distance.
 		/// </param>
 		/// <param name="mesh_id">
-		/// (UNUSED) The id of the only mesh for this ray to collide with. -1 for all
+		/// The id of the only mesh for this ray to collide with. -1 for all
 		/// </param>
 		/// <returns>
 		/// True if the ray intersected some geometry and the origin is updated with the hit
@@ -729,9 +1271,9 @@ namespace HF::RayTracer {
 		/// Any intersections beyond this distance are ignored. Set to -1 count any hit
 		/// regardless of distance.
 		/// </param>
-		/// <param name="mesh_id"> (UNUSED)
-		/// The id of the only mesh for this ray to collide with. Any geometry wihtout this ID
-		/// is ignored
+		/// <param name="mesh_id">
+		/// The id of the only mesh for this ray to collide with. Any geometry without this ID
+		/// is ignored. Set to -1 to count every mesh.
 		/// </param>
 		/// \warning The ray direction must be a unit vector.
 		/// <returns> true if the ray hit, false otherwise </returns>
@@ -800,7 +1342,7 @@ namespace HF::RayTracer {
 		/// Maximum distance the ray can travel. Any intersections beyond this distance will be
 		/// ignored. If set to 1, all intersections will be counted regardless of distance.
 		/// </param>
-		/// <param name="mesh_id"> (UNUSED) Only intersect with the mesh of this ID </param>
+		/// <param name="mesh_id"> Only intersect with the mesh of this ID. Set to -1 for all meshes. </param>
 		/// <returns>
 		/// A vector of <see cref="Vector3D" /> for the hitpoint of each ray cast. If a ray
 		/// didn't hit, its point will be invalid, checkable using <see
@@ -972,6 +1514,37 @@ namespace HF::RayTracer {
 			, bool use_parallel = true
 		);
 
+		/*! \brief Cast every ray in a batch, and store the distance and mesh ID of each hit in the batch.
+
+			\param batch Rays to cast. Its `distance` and `meshid` arrays are updated with the result of each ray.
+			\param use_parallel If true, cast the rays on multiple threads.
+
+			\details
+			The batch is split into chunks that are each passed to Embree's stream intersection function,
+			which reads the components of every ray from the arrays of the batch directly. Rays that don't hit
+			anything within their `tnear` and `tfar` have a distance and mesh ID of -1.
+
+			\remarks
+			This is the fastest way to cast large numbers of rays, since no HitStruct or array of points is
+			created for each ray. If `use_precise` is set to true then the distance to every hit is calculated
+			with the same precise algorithm as Intersect.
+
+			\see RayBatch for creating a batch of rays.
+			\see OccludedBatch for checking occlusion instead.
+		*/
+		void IntersectBatch(RayBatch& batch, bool use_parallel = true);
+
+		/*! \brief Check whether every ray in a batch hits anything, and store the results in the batch.
+
+			\param batch Rays to cast. Its `occluded` array is updated with the result of each ray.
+			\param use_parallel If true, cast the rays on multiple threads.
+
+			\details Rays are cast in chunks using Embree's stream occlusion function.
+
+			\see IntersectBatch for details on how the batch is cast.
+		*/
+		void OccludedBatch(RayBatch& batch, bool use_parallel = true);
+
 
 		/*! \brief Cast a ray from origin in direction. 
 		
@@ -1001,7 +1574,7 @@ namespace HF::RayTracer {
 		HitStruct<return_type> Intersect(
 			const N& node,
 			const V& direction,
-			float max_distance = -1.0f, int mesh_id = -0.1f)
+			float max_distance = -1.0f, int mesh_id = -1)
 		{
 			return Intersect<return_type>(node[0], node[1], node[2], direction[0], direction[1], direction[2], max_distance, mesh_id);
 		}
@@ -1043,32 +1616,7 @@ namespace HF::RayTracer {
 				numeric2 dx, numeric2 dy, numeric2 dz,
 				float distance = -1.0f, int mesh_id = -1)
 		{
-			// create output value
-			HitStruct<return_type> out_struct;
-
-			// Cast the ray
-			auto result = Intersect_IMPL(
-				x,y,z,
-				dx,dy,dz, distance, mesh_id
-			);
-
-			// If an intersection occured, update the struct. 
-			if (DidIntersect(result.hit.geomID))
-			{
-				// Use a precise ray intersection if required
-				if (!(this->use_precise))
-					out_struct.distance = result.ray.tfar;
-				else
-					out_struct.distance = CalculatePreciseDistance(
-						result.hit.geomID,
-						result.hit.primID,
-						Vector3D(x,y,z),
-						Vector3D(dx,dy,dz)
-					);
-				out_struct.meshid = result.hit.geomID;
-			}
-
-			return out_struct;
+			return CastRay<HitStruct<return_type>>(x, y, z, dx, dy, dz, distance, mesh_id);
 		}
 
 
@@ -1157,6 +1705,253 @@ namespace HF::RayTracer {
 			return results;
 		}
 
+		/*! \brief Cast multiple rays using Embree's 16-wide ray packets.
+
+			\tparam return_type Numeric type for the returned distance value i.e. double, long double, float, etc.
+			\tparam N A container of objects holding x,y,z coordinates for the origin points of every ray
+			\tparam V A container of objects holding x,y,z coordinates for the direction of every ray
+
+			\param origins Origin points to cast rays from.
+			\param directions Directions to cast rays in.
+
+			\returns An ordered array of results from casting a ray for every origin in origins in the direction
+			in directions with a matching index. Rays that do not result in an intersection will have hitstructs
+			with meshids of -1.
+
+			\remarks
+			Rays are traced in groups of 16 on the calling thread. This is intended for small sets of
+			coherent rays, such as the rays cast beneath every child of a node in the graph generator, where
+			the overhead of a parallel loop would outweigh its benefit. The results are identical to calling
+			Intersect for every ray, including the use of a more precise algorithm if `use_precise` is set.
+
+			\pre The length of origins must match the length of directions.
+
+			\see Intersect for casting a single ray.
+		*/
+		template <typename return_type = double, typename N, typename V>
+		std::vector<HitStruct<return_type>> PacketIntersections(const N& origins, const V& directions)
+		{
+			return CastPackets<HitStruct<return_type>>(origins, directions);
+		}
+
+		/*! \brief Cast a ray from origin in direction, and describe the surface of the triangle it hits.
+
+			\tparam return_type Numeric type used for the output distance value.
+			\tparam N X,Y,Z coordinates representing a point in space
+			\tparam V X,Y,Z Coordinates representing direction vector
+
+			\param origin Origin point of the ray.
+			\param direction Direction to cast the ray in.
+			\param max_distance Maximum distance a ray can travel before intersections are ignored. Set to -1
+								for infinite distance.
+			\param mesh_id Ignore intersections with any mesh other than the mesh with this ID. set to -1 to
+							consider intersections with any geometry
+
+			\returns The same distance and mesh ID as Intersect, along with the triangle that was hit, the
+					 barycentric coordinates of the hit point, the normal of the triangle, and its attribute.
+
+			\remarks
+			Every member of the result comes from the single intersection Embree already computes for
+			Intersect, so slopes and surface types can be checked without casting any extra rays.
+
+			\see SurfaceIntersections for casting many rays at once.
+			\see SetTriangleAttributes for assigning attributes to triangles.
+		*/
+		template <typename return_type = double, class N, class V>
+		SurfaceHit<return_type> IntersectSurface(
+			const N& origin,
+			const V& direction,
+			float max_distance = -1.0f,
+			int mesh_id = -1)
+		{
+			return CastRay<SurfaceHit<return_type>>(
+				origin[0], origin[1], origin[2],
+				direction[0], direction[1], direction[2],
+				max_distance, mesh_id
+			);
+		}
+
+		/*! \brief Cast multiple rays using Embree's 16-wide ray packets, and describe the surface each of them hits.
+
+			\tparam return_type Numeric type for the returned distance value i.e. double, long double, float, etc.
+			\tparam N A container of objects holding x,y,z coordinates for the origin points of every ray
+			\tparam V A container of objects holding x,y,z coordinates for the direction of every ray
+
+			\param origins Origin points to cast rays from.
+			\param directions Directions to cast rays in.
+
+			\returns The result of calling IntersectSurface for every ray, in the same order as `origins`.
+
+			\pre The length of origins must match the length of directions.
+
+			\see PacketIntersections for details on how the rays are cast.
+		*/
+		template <typename return_type = double, typename N, typename V>
+		std::vector<SurfaceHit<return_type>> SurfaceIntersections(const N& origins, const V& directions)
+		{
+			return CastPackets<SurfaceHit<return_type>>(origins, directions);
+		}
+
+		/*! \brief Get every surface a ray crosses, sorted by distance, in a single traversal.
+
+			\tparam return_type Numeric type for the returned distance values i.e. double, long double, float, etc.
+			\tparam N X,Y,Z coordinates representing a point in space
+			\tparam V X,Y,Z Coordinates representing direction vector
+
+			\param origin Origin point of the ray.
+			\param direction Direction to cast the ray in.
+			\param max_hits Maximum number of hits to return. Only the closest `max_hits` hits are kept.
+			\param max_distance Maximum distance a ray can travel before intersections are ignored. Set to -1
+								for infinite distance.
+			\param mesh_id Ignore intersections with any mesh other than the mesh with this ID. Set to -1 to
+							consider intersections with any geometry.
+
+			\returns Up to `max_hits` hits sorted from nearest to farthest, each with the distance, mesh ID
+					 and ID of the triangle that was hit. The result is empty if the ray didn't hit anything.
+
+			\details
+			An intersection filter records every hit Embree finds and then rejects it, so traversal continues
+			past it until the whole segment has been searched. This replaces casting a new ray from just past
+			every hit with Intersect, such as when counting the walls between two points or finding every
+			floor under a point.
+
+			\remarks
+			A ray that crosses an edge or vertex shared by several triangles hits each of them, so these are
+			reported as separate hits at the same distance. A triangle is never reported twice.
+
+			\pre `max_hits` must be greater than zero.
+		*/
+		template <typename return_type = double, class N, class V>
+		std::vector<PrimitiveHit<return_type>> IntersectAll(
+			const N& origin,
+			const V& direction,
+			int max_hits,
+			float max_distance = -1.0f,
+			int mesh_id = -1)
+		{
+			const auto hits = IntersectAll_IMPL(
+				origin[0], origin[1], origin[2],
+				direction[0], direction[1], direction[2],
+				max_hits, max_distance, mesh_id
+			);
+
+			std::vector<PrimitiveHit<return_type>> results;
+			results.reserve(hits.size());
+			for (const auto& hit : hits)
+				results.emplace_back(static_cast<return_type>(hit.distance), hit.meshid, hit.primid);
+			return results;
+		}
+
+		/*! \brief Find the closest point on any surface to a point.
+
+			\tparam return_type Numeric type for the returned distance value i.e. double, long double, float, etc.
+			\tparam N X,Y,Z coordinates representing a point in space
+
+			\param point Point to find the closest surface to.
+			\param max_distance Only consider surfaces within this distance of `point`. Set to -1 for infinite distance.
+			\param mesh_id Ignore every mesh other than the mesh with this ID. Set to -1 to consider every mesh.
+			\param min_height Ignore the parts of surfaces that are lower than this distance above `point`. Set to
+							  -infinity to consider entire surfaces.
+
+			\returns The distance to the closest point, the ID of the mesh and triangle it's on, and the point itself.
+					 If no surface was within `max_distance`, the result's DidHit() returns false.
+
+			\details
+			Uses rtcPointQuery, which visits only the triangles whose bounds overlap a sphere around `point`
+			and shrinks the sphere as closer triangles are found. A single query gives the exact distance to
+			the nearest surface in every direction, including thin geometry that a set of rays could pass
+			between. `min_height` lets surfaces under a point, like the floor it's above, be left out.
+
+			\see ClosestPoints for finding the closest points to many points at once.
+		*/
+		template <typename return_type = double, class N>
+		ClosestPointHit<return_type> ClosestPoint(
+			const N& point,
+			float max_distance = -1.0f,
+			int mesh_id = -1,
+			float min_height = -INFINITY)
+		{
+			const auto closest = ClosestPoint_IMPL(point[0], point[1], point[2], max_distance, mesh_id, min_height);
+
+			ClosestPointHit<return_type> result;
+			result.distance = static_cast<return_type>(closest.distance);
+			result.meshid = closest.meshid;
+			result.primid = closest.primid;
+			result.point = closest.point;
+			return result;
+		}
+
+		/*! \brief Find the closest point on any surface to each of a set of points.
+
+			\tparam return_type Numeric type for the returned distance values i.e. double, long double, float, etc.
+			\tparam N A container of objects holding x,y,z coordinates for every query point
+
+			\param points Points to find the closest surfaces to.
+			\param max_distance Only consider surfaces within this distance of each point. Set to -1 for infinite distance.
+			\param mesh_id Ignore every mesh other than the mesh with this ID. Set to -1 to consider every mesh.
+			\param min_height Ignore the parts of surfaces that are lower than this distance above each point.
+			\param use_parallel Run the queries on every core.
+
+			\returns The result of calling ClosestPoint for every point, in the same order as `points`.
+		*/
+		template <typename return_type = double, class N>
+		std::vector<ClosestPointHit<return_type>> ClosestPoints(
+			const N& points,
+			float max_distance = -1.0f,
+			int mesh_id = -1,
+			float min_height = -INFINITY,
+			bool use_parallel = true)
+		{
+			const int n = static_cast<int>(points.size());
+			std::vector<ClosestPointHit<return_type>> results(n);
+
+			#pragma omp parallel for schedule(dynamic, 256) if (use_parallel)
+			for (int i = 0; i < n; i++)
+				results[i] = ClosestPoint<return_type>(points[i], max_distance, mesh_id, min_height);
+
+			return results;
+		}
+
+		/*! \brief Assign an attribute, such as a material or whether it's walkable, to every triangle of a mesh.
+
+			\param mesh_id ID of the mesh the attributes belong to.
+			\param attributes Attribute of every triangle of the mesh, in the order of its index buffer.
+							  Pass an empty array to remove the attributes of the mesh.
+
+			\returns False if there's no mesh with the ID `mesh_id`, true otherwise.
+
+			\details Attributes are returned by IntersectSurface and SurfaceIntersections in the
+			`attribute` member of the result. Copies of this raytracer share the attributes
+			assigned before they were made.
+
+			\pre `attributes` must have an element for every triangle of the mesh. Triangles past
+			the end of `attributes` have the attribute 0.
+		*/
+		bool SetTriangleAttributes(int mesh_id, const std::vector<int>& attributes);
+
+		/*! \brief Get the attribute of a triangle.
+
+			\param mesh_id ID of the mesh containing the triangle.
+			\param prim_id ID of the triangle in the mesh.
+
+			\returns The attribute assigned to the triangle by SetTriangleAttributes, or 0 if it has none.
+		*/
+		int TriangleAttribute(int mesh_id, int prim_id) const;
+
+		/*! \brief Get a number that changes every time the meshes in the scene change.
+
+			\returns A number that's incremented whenever a mesh is added, edited, moved or removed, or its
+					 triangle attributes are set.
+
+			\details
+			Copies of this raytracer share its version, since they share its scene. Subsets have a
+			version of their own, so comparing the version of a raytracer to the one it had when a
+			subset was created tells whether the subset is out of date.
+
+			\see Subset
+		*/
+		unsigned int SceneVersion() const;
+
 		/*!
 			\brief Determine if there is an intersection with any geometry 
 			
@@ -1243,6 +2038,69 @@ namespace HF::RayTracer {
 			);
 		}
 
+		/*!
+			\brief Determine if there is an intersection with any geometry for multiple rays using Embree's 
+			16-wide ray packets.
+
+			\tparam N A container of objects holding x,y,z coordinates for the origin points of every ray
+			\tparam V A container of objects holding x,y,z coordinates for the direction of every ray
+			\tparam D A container of distances
+
+			\param origins Origin points to cast rays from.
+			\param directions Directions to cast rays in.
+			\param distances Maximum distance of each ray. Intersections beyond this distance are ignored.
+							 Set an element to -1 for infinite distance.
+
+			\returns An ordered array containing `true` for every ray that intersected geometry within
+					 its maximum distance and `false` for every ray that did not.
+
+			\remarks
+			Rays are traced in groups of 16 on the calling thread. The results are identical to calling
+			Occluded for every ray.
+
+			\pre origins, directions, and distances must all be the same length.
+
+			\see Occluded for casting a single occlusion ray.
+			\see Occlusions for casting a large number of occlusion rays in parallel.
+		*/
+		template <typename N, typename V, typename D>
+		std::vector<char> PacketOcclusions(const N& origins, const V& directions, const D& distances)
+		{
+			const int n = static_cast<int>(origins.size());
+			std::vector<char> results(n, false);
+
+			alignas(64) int valid[16];
+			RTCRay16 packet;
+
+			for (int start = 0; start < n; start += 16) {
+				const int count = (std::min)(16, n - start);
+
+				// Fill every lane of the packet, masking off lanes past the end of the input
+				for (int lane = 0; lane < 16; lane++) {
+					if (lane < count) {
+						const auto& origin = origins[start + lane];
+						const auto& direction = directions[start + lane];
+						SetPacketLane(
+							packet, lane,
+							origin[0], origin[1], origin[2],
+							direction[0], direction[1], direction[2],
+							0.0000001f, static_cast<float>(distances[start + lane])
+						);
+						valid[lane] = -1;
+					}
+					else
+						valid[lane] = 0;
+				}
+
+				Occluded16_IMPL(valid, packet);
+
+				// Occluded rays have their tfar set to -infinity
+				for (int lane = 0; lane < count; lane++)
+					results[start + lane] = (packet.tfar[lane] == -INFINITY);
+			}
+			return results;
+		}
+
 		/// <summary> Increment reference counters to prevent destruction when a copy is made. <summary>
 		/// <param name="ERT2">Reference to EmbreeRayTracer, the right-hand side of the = statement</param>
 
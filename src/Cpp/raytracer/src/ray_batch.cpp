@@ -0,0 +1,62 @@
+///
+/// \file		ray_batch.cpp
+/// \brief		Contains implementation for the <see cref="HF::RayTracer::RayBatch">RayBatch</see> struct
+///
+///	\author		TBA
+///	\date		26 Jun 2020
+
+#include <ray_batch.h>
+
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+
+namespace HF::RayTracer {
+
+	/// Start of every ray. Matches the rays cast by EmbreeRayTracer::Intersect.
+	constexpr float default_tnear = 0.00000001f;
+
+	RayBatch::RayBatch(int size) {
+		Resize(size);
+	}
+
+	RayBatch::RayBatch(const float* origins, int num_origins, const float* directions, int num_directions, float max_distance)
+	{
+		if (num_origins <= 0 || num_directions <= 0)
+			throw std::invalid_argument("A batch needs at least one origin and one direction!");
+		if (num_origins != num_directions && num_origins != 1 && num_directions != 1)
+			throw std::invalid_argument("The number of origins must match the number of directions, or one of them must be 1!");
+
+		const int size = (std::max)(num_origins, num_directions);
+		Resize(size);
+
+		for (int i = 0; i < size; i++) {
+			const float* origin = origins + 3 * (num_origins == 1 ? 0 : i);
+			const float* direction = directions + 3 * (num_directions == 1 ? 0 : i);
+			SetRay(i, origin[0], origin[1], origin[2], direction[0], direction[1], direction[2], max_distance);
+		}
+	}
+
+	void RayBatch::Resize(int size) {
+		for (auto* component : { &org_x, &org_y, &org_z, &dir_x, &dir_y, &dir_z })
+			component->resize(size, 0.0f);
+		tnear.resize(size, default_tnear);
+		tfar.resize(size, INFINITY);
+		mask.resize(size, 0xFFFFFFFF);
+
+		distance.resize(size, -1.0f);
+		meshid.resize(size, -1);
+		occluded.resize(size, false);
+	}
+
+	int RayBatch::size() const {
+		return static_cast<int>(org_x.size());
+	}
+
+	void RayBatch::SetRay(int i, float x, float y, float z, float dx, float dy, float dz, float max_distance) {
+		org_x[i] = x; org_y[i] = y; org_z[i] = z;
+		dir_x[i] = dx; dir_y[i] = dy; dir_z[i] = dz;
+		tnear[i] = default_tnear;
+		tfar[i] = max_distance > 0 ? max_distance : INFINITY;
+	}
+}
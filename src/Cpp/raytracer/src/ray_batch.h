@@ -0,0 +1,80 @@
+///
+/// \file		ray_batch.h
+/// \brief		Contains definitions for the <see cref="HF::RayTracer::RayBatch">RayBatch</see> struct
+///
+///	\author		TBA
+///	\date		26 Jun 2020
+
+#pragma once
+
+#include <vector>
+
+namespace HF::RayTracer {
+
+	/*!
+		\brief A batch of rays stored with a separate array for every component, along with their results.
+
+		\details
+		Each array holds one element for every ray, so the arrays can be handed to Embree's stream
+		functions directly without copying every ray into a struct. Every array is resized together
+		by Resize.
+
+		\see EmbreeRayTracer::IntersectBatch and EmbreeRayTracer::OccludedBatch for casting the rays
+		of a batch.
+	*/
+	struct RayBatch {
+		std::vector<float> org_x;			///< X component of the origin of every ray.
+		std::vector<float> org_y;			///< Y component of the origin of every ray.
+		std::vector<float> org_z;			///< Z component of the origin of every ray.
+		std::vector<float> dir_x;			///< X component of the direction of every ray.
+		std::vector<float> dir_y;			///< Y component of the direction of every ray.
+		std::vector<float> dir_z;			///< Z component of the direction of every ray.
+		std::vector<float> tnear;			///< Distance along every ray that intersections start being counted at.
+		std::vector<float> tfar;			///< Distance along every ray that intersections stop being counted at.
+		std::vector<unsigned int> mask;		///< Mask of every ray. Only geometry sharing a bit with it can be hit.
+
+		std::vector<float> distance;		///< Set by IntersectBatch to the distance to every hit, or -1 for misses.
+		std::vector<int> meshid;			///< Set by IntersectBatch to the ID of every hit mesh, or -1 for misses.
+		std::vector<char> occluded;			///< Set by OccludedBatch to whether every ray hit anything.
+
+		/// \brief Create a batch of `size` rays, all at the origin with no direction.
+		RayBatch(int size = 0);
+
+		/*!
+			\brief Create a batch of rays from arrays of origins and directions.
+
+			\param origins X, Y, and Z components of every origin, one after another.
+			\param num_origins Number of origins in `origins`.
+			\param directions X, Y, and Z components of every direction, one after another.
+			\param num_directions Number of directions in `directions`.
+			\param max_distance Greatest distance each ray may travel. Set to -1 for infinite distance.
+
+			\details
+			If either array has a single element, it's used for every element of the other array.
+
+			\throws std::invalid_argument if either array is empty, or if both arrays have more than one
+			element and their sizes don't match.
+		*/
+		RayBatch(const float* origins, int num_origins, const float* directions, int num_directions, float max_distance = -1);
+
+		/// \brief Resize every array to hold `size` rays. New rays are set as in the constructor.
+		void Resize(int size);
+
+		/// \brief Get the number of rays in this batch.
+		int size() const;
+
+		/*!
+			\brief Set a ray in the batch.
+
+			\param i Index of the ray to set.
+			\param x X component of the ray's origin.
+			\param y Y component of the ray's origin.
+			\param z Z component of the ray's origin.
+			\param dx X component of the ray's direction.
+			\param dy Y component of the ray's direction.
+			\param dz Z component of the ray's direction.
+			\param max_distance Greatest distance the ray may travel. Set to -1 for infinite distance.
+		*/
+		void SetRay(int i, float x, float y, float z, float dx, float dy, float dz, float max_distance = -1);
+	};
+}
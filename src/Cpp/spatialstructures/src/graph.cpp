@@ -120,6 +120,8 @@ namespace HF::SpatialStructures {
 
 	void Graph::ClearCostArrays(const std::string& cost_name)
 	{
+		InvalidatePathHierarchies();
+
 		// Delete them all if this is the default name
 		if (this->IsDefaultName(cost_name))
 			edge_cost_maps.clear();
@@ -251,12 +253,11 @@ namespace HF::SpatialStructures {
 	int Graph::getID(const Node& node) const
 	{
 		// First check if we have this node
-		if (hasKey(node))
-
-			// If so, return its id
-			return idmap.at(node);
+		const auto it = idmap.find(node_lattice.Key(node));
 
-		// If not, return -1
+		// If so, return its id. If not, return -1
+		if (it != idmap.end())
+			return it->second;
 		else
 			return -1;
 	}
@@ -705,6 +706,7 @@ namespace HF::SpatialStructures {
 	}
 
 	void Graph::InsertOrUpdateEdge(int parent_id, int child_id, float score, const string& cost_type) {
+		InvalidatePathHierarchies();
 
 		// If this is the default graph, we don't need to worry aobut 
 		if (IsDefaultName(cost_type)) {
@@ -984,13 +986,16 @@ namespace HF::SpatialStructures {
 
 	inline int Graph::getOrAssignID(const Node& input_node)
 	{
+		const auto key = node_lattice.Key(input_node);
+
 		// If it's already in the hashmap, then just return the existing ID
-		if (hasKey(input_node))
-			return getID(input_node);
+		const auto it = idmap.find(key);
+		if (it != idmap.end())
+			return it->second;
 
 		else {
 			// Set the id in the hashmap, and add the node to nodes
-			idmap[input_node] = next_id;
+			idmap[key] = next_id;
 			ordered_nodes.push_back(input_node);
 			
 			ordered_nodes.back().id = next_id;
@@ -1069,6 +1074,68 @@ namespace HF::SpatialStructures {
 		needs_compression = false;
 	}
 
+	Graph::Graph(
+		const vector<Node>& nodes,
+		vector<int> outer_indices,
+		vector<int> inner_indices,
+		vector<float> data,
+		const std::string& default_cost
+	) {
+		this->default_cost = default_cost;
+
+		const int num_nodes = nodes.size();
+		const int num_edges = inner_indices.size();
+		assert(outer_indices.size() == num_nodes + 1);
+		assert(data.size() == num_edges && outer_indices.back() == num_edges);
+
+		// Give every node the ID of its index
+		ordered_nodes = nodes;
+		idmap.reserve(num_nodes);
+		for (int i = 0; i < num_nodes; i++) {
+			ordered_nodes[i].id = i;
+			idmap.emplace(node_lattice.Key(ordered_nodes[i]), i);
+		}
+		next_id = num_nodes;
+
+		// The edge matrix expects the children in each row to be sorted
+		vector<int> order;
+		vector<int> sorted_children;
+		vector<float> sorted_data;
+		for (int row = 0; row < num_nodes; row++) {
+			const int begin = outer_indices[row];
+			const int end = outer_indices[row + 1];
+			if (std::is_sorted(inner_indices.begin() + begin, inner_indices.begin() + end)) continue;
+
+			order.resize(end - begin);
+			std::iota(order.begin(), order.end(), begin);
+			std::sort(order.begin(), order.end(), [&inner_indices](int a, int b) { return inner_indices[a] < inner_indices[b]; });
+
+			sorted_children.resize(order.size());
+			sorted_data.resize(order.size());
+			for (int i = 0; i < order.size(); i++) {
+				sorted_children[i] = inner_indices[order[i]];
+				sorted_data[i] = data[order[i]];
+			}
+			std::copy(sorted_children.begin(), sorted_children.end(), inner_indices.begin() + begin);
+			std::copy(sorted_data.begin(), sorted_data.end(), data.begin() + begin);
+		}
+
+		// Copy each array into the edge matrix, freeing it as soon as it's copied
+		edge_matrix.resize(num_nodes, num_nodes);
+		edge_matrix.resizeNonZeros(num_edges);
+
+		std::copy(outer_indices.begin(), outer_indices.end(), edge_matrix.outerIndexPtr());
+		vector<int>().swap(outer_indices);
+
+		std::copy(inner_indices.begin(), inner_indices.end(), edge_matrix.innerIndexPtr());
+		vector<int>().swap(inner_indices);
+
+		std::copy(data.begin(), data.end(), edge_matrix.valuePtr());
+		vector<float>().swap(data);
+
+		needs_compression = false;
+	}
+
 	Graph::Graph(const std::string & default_cost_name)
 	{
 		// Assign default cost type, and create an edge matrix.
@@ -1082,7 +1149,7 @@ namespace HF::SpatialStructures {
 		return HasEdge(p, c, undirected);
 	}
 
-	bool Graph::hasKey(const Node& n) const { return (idmap.count(n) > 0); }
+	bool Graph::hasKey(const Node& n) const { return (idmap.count(node_lattice.Key(n)) > 0); }
 
 	std::vector<std::array<float, 3>> Graph::NodesAsFloat3() const
 	{
@@ -1122,6 +1189,7 @@ namespace HF::SpatialStructures {
 
 			// Mark this graph as not requiring compression
 			needs_compression = false;
+			InvalidatePathHierarchies();
 		}
 	}
 
@@ -1139,6 +1207,8 @@ namespace HF::SpatialStructures {
 		// Clear all cost arrays.
 		for (auto& cost_map : edge_cost_maps)
 			cost_map.second.Clear();
+
+		InvalidatePathHierarchies();
 	}
 	
 	void Graph::AddEdges(const vector<EdgeSet>& edges, const string& cost_name)
@@ -1147,6 +1217,20 @@ namespace HF::SpatialStructures {
 			AddEdges(set, cost_name);
 	}
 
+	void Graph::AddCostArray(const string& cost_name, const vector<float>& costs)
+	{
+		if (this->needs_compression)
+			throw std::logic_error("Tried to add a cost array while uncompressed!");
+		if (costs.size() != edge_matrix.nonZeros())
+			throw std::out_of_range("Cost array doesn't match the number of edges in the graph");
+
+		auto& cost_set = GetOrCreateCostType(cost_name);
+		if (!costs.empty())
+			std::copy(costs.begin(), costs.end(), cost_set.GetPtr());
+
+		InvalidatePathHierarchies();
+	}
+
 
 	void Graph::AddEdges(const vector<vector<IntEdge>> & edges, const std::string & cost_type) {
 		// Each outer vector represents a parent;
@@ -1556,4 +1640,25 @@ namespace HF::SpatialStructures {
 		return true;
 	}
 
+	void Graph::InvalidatePathHierarchies()
+	{
+		// Called for every edge that's added, so avoid touching the map when it's already empty
+		if (!path_hierarchies.empty())
+			path_hierarchies.clear();
+	}
+
+	void Graph::SetPathHierarchy(std::shared_ptr<const HF::Pathfinding::PathHierarchy> hierarchy, const string& cost_type)
+	{
+		const string key = IsDefaultName(cost_type) ? "" : cost_type;
+		if (hierarchy)
+			path_hierarchies[key] = std::move(hierarchy);
+		else
+			path_hierarchies.erase(key);
+	}
+
+	std::shared_ptr<const HF::Pathfinding::PathHierarchy> Graph::GetPathHierarchy(const string& cost_type) const
+	{
+		const auto it = path_hierarchies.find(IsDefaultName(cost_type) ? "" : cost_type);
+		return (it != path_hierarchies.end()) ? it->second : nullptr;
+	}
 }
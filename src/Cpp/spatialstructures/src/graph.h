@@ -9,6 +9,8 @@
 
 #include <robin_hood.h>
 #include <vector>
+#include <memory>
+#include <string>
 #include <Edge.h>
 #include <Node.h>
 #include <Eigen>
@@ -17,6 +19,10 @@
 namespace Eigen {
 }
 
+namespace HF::Pathfinding {
+	class PathHierarchy;
+}
+
 namespace HF::SpatialStructures {
 	using EdgeMatrix = Eigen::SparseMatrix<float, 1>; ///< The type of matrix the graph uses internally
 	using TempMatrix = Eigen::Map<const EdgeMatrix>;  ///< A mapped matrix of EdgeMatrix. Only owns pointers to memory. 
@@ -491,7 +497,8 @@ namespace HF::SpatialStructures {
 		std::vector<Node> ordered_nodes;				///< A list of nodes contained by the graph.
 
 		//robin_hood::unordered_map<int, int> id_to_ordered_node; ///< Maps ids to indexes in ordered_nodes.
-		robin_hood::unordered_map<Node, int> idmap;		///< Maps a list of X,Y,Z positions to positions in ordered_nodes
+		robin_hood::unordered_map<LatticeKey, int> idmap;	///< Maps the lattice keys of X,Y,Z positions to positions in ordered_nodes
+		NodeLattice node_lattice;						///< Lattice used to quantize nodes into keys for idmap
 
 		std::vector<Eigen::Triplet<float>> triplets;	///< Edges to be converted to a CSR when Graph::Compress() is called.
 		bool needs_compression = true;					///< If true, the CSR is inaccurate and requires compression.
@@ -522,6 +529,13 @@ namespace HF::SpatialStructures {
 		*/
 		bool nodes_out_of_order = false;
 
+		/// Path hierarchies built for this graph by cost type, with the default cost stored under "".
+		/// Discarded whenever an edge or cost changes. \see SetPathHierarchy
+		std::unordered_map<std::string, std::shared_ptr<const HF::Pathfinding::PathHierarchy>> path_hierarchies;
+
+		/*! \brief Discard every path hierarchy, since the edges they were built from have changed. */
+		void InvalidatePathHierarchies();
+
 		/*!
 			\brief
 			Get the unique ID for this x, y, z position and assign it an new one if it doesn't already exist.
@@ -884,6 +898,55 @@ namespace HF::SpatialStructures {
 			const std::string& default_cost = "Distance"
 		);
 
+		/*!
+			\brief Construct a compressed graph directly from the arrays of a CSR.
+
+			\param nodes Nodes of the graph. The node at `nodes[i]` will be given the ID `i`.
+			\param outer_indices Index of the first edge of each row in `inner_indices` and `data`,
+								 followed by the total number of edges.
+			\param inner_indices ID of the child of each edge, grouped by parent.
+			\param data Cost of each edge in `inner_indices`.
+			\param default_cost Default cost of the graph. This is the name of the first used cost.
+
+			\pre 1) `outer_indices.size() == nodes.size() + 1`, `outer_indices` is non-decreasing and
+			`outer_indices.back() == inner_indices.size()`.
+			\pre 2) `inner_indices.size() == data.size()` and every ID in `inner_indices` is less than `nodes.size()`.
+			\pre 3) No row contains the same child more than once.
+
+			\details
+			The edges of each row may be in any order and will be sorted by child ID. The arrays are
+			copied straight into the edge matrix, so unlike adding edges one at a time no triplets are
+			created and the graph doesn't need to be compressed. Pass the arrays with std::move to
+			avoid copying them first. 
+
+			\remarks
+			Intended for callers that already know every node and edge, such as the GraphGenerator,
+			which has found every parent's complete list of edges by the time the graph is created.
+
+			\code
+				// be sure to #include "graph.h"
+				std::vector<HF::SpatialStructures::Node> nodes = {
+					HF::SpatialStructures::Node(1.0f, 1.0f, 2.0f),
+					HF::SpatialStructures::Node(2.0f, 3.0f, 4.0f),
+					HF::SpatialStructures::Node(11.0f, 22.0f, 140.0f)
+				};
+
+				// Node 0 has edges to 1 and 2, node 1 has an edge to 2, and node 2 has an edge to 1
+				std::vector<int> outer_indices = { 0, 2, 3, 4 };
+				std::vector<int> inner_indices = { 1, 2, 2, 1 };
+				std::vector<float> data = { 1.0f, 2.5f, 54.0f, 39.0f };
+
+				HF::SpatialStructures::Graph graph(nodes, std::move(outer_indices), std::move(inner_indices), std::move(data));
+			\endcode
+		*/
+		Graph(
+			const std::vector<Node>& nodes,
+			std::vector<int> outer_indices,
+			std::vector<int> inner_indices,
+			std::vector<float> data,
+			const std::string& default_cost = "Distance"
+		);
+
 		/*! \brief Construct an empty graph.
 
 			\remarks This can be used to create a new graph to later be filled with edges/nodes
@@ -2140,6 +2203,23 @@ namespace HF::SpatialStructures {
 		/*! \brief Add an array of edges to the graph.*/
 		void AddEdges(const std::vector<EdgeSet>& edges, const std::string& cost_name = "");
 
+		/*!
+			\brief Add a cost type from the cost of every edge, in the same order as the edges of the CSR.
+
+			\param cost_name Name of the cost type. If it already exists, its costs will be replaced.
+			\param costs Cost of every edge in the graph, ordered by parent ID, then by child ID.
+
+			\pre The graph must already be compressed.
+
+			\throws std::logic_error The graph isn't compressed, or `cost_name` is the default cost type.
+			\throws std::out_of_range `costs` doesn't hold exactly one cost for every edge in the graph.
+
+			\remarks
+			Intended for callers that already know the cost of every edge, such as the GraphGenerator.
+			Unlike AddEdges, the position of each edge in the CSR doesn't need to be looked up.
+		*/
+		void AddCostArray(const std::string& cost_name, const std::vector<float>& costs);
+
 		/*!
 			\brief Get the edges of a specfic cost type
 			\param cost_name The name of the cost to get edges for
@@ -2221,6 +2301,33 @@ namespace HF::SpatialStructures {
 			const std::string & node_attribute,
 			const std::string & cost_to_store_as,
 			Direction consider = Direction::INCOMING);
+
+		/*!
+			\brief Store a path hierarchy built from this graph, so every pathfinding call on this graph can use it.
+
+			\param hierarchy Hierarchy to store. Pass nullptr to remove the hierarchy for `cost_type`.
+			\param cost_type Cost type `hierarchy` was built with. If blank, the graph's default cost type is used.
+
+			\details
+			The hierarchy is discarded as soon as any edge or cost of the graph changes, since it would no
+			longer match the graph.
+
+			\see HF::Pathfinding::EnablePathHierarchy for building and storing a hierarchy.
+		*/
+		void SetPathHierarchy(
+			std::shared_ptr<const HF::Pathfinding::PathHierarchy> hierarchy,
+			const std::string& cost_type = ""
+		);
+
+		/*!
+			\brief Get the path hierarchy stored for a cost type.
+
+			\param cost_type Cost type to get the hierarchy of. If blank, the graph's default cost type is used.
+
+			\returns The hierarchy stored by SetPathHierarchy, or nullptr if there is none or the graph has
+			changed since it was stored.
+		*/
+		std::shared_ptr<const HF::Pathfinding::PathHierarchy> GetPathHierarchy(const std::string& cost_type = "") const;
 		
 	};
 }
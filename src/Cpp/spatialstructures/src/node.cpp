@@ -37,6 +37,15 @@ namespace HF {
 			z = position[2];
 		}
 
+		NodeLattice::NodeLattice() : NodeLattice({ 0, 0, 0 }, { ROUNDING_PRECISION, ROUNDING_PRECISION, ROUNDING_PRECISION }) {}
+
+		NodeLattice::NodeLattice(const std::array<double, 3>& origin, const std::array<double, 3>& steps) {
+			this->origin = origin;
+			// Fall back to DHART_API's precision for any axis without a valid step
+			for (int i = 0; i < 3; i++)
+				inv_steps[i] = 1.0 / ((steps[i] > 0) ? steps[i] : ROUNDING_PRECISION);
+		}
+
 		float Node::distanceTo(const Node& n2) const {
 			return
 				sqrtf(pow((x - n2.x), 2) +
@@ -11,6 +11,8 @@
 #define HF_NODE
 
 #include <array>
+#include <cmath>
+#include <cstdint>
 #include <ostream>
 
 namespace HF
@@ -404,6 +406,136 @@ namespace HF
 			*/
 			bool operator>(const Node& n2) const;
 		};
+
+		/*!
+			\brief The integer coordinates of a node on a NodeLattice.
+
+			\details
+			Unlike nodes, two keys are only equal if all of their coordinates are exactly equal, and
+			they're hashed from those same integer coordinates. This makes them a cheap and consistent
+			key for hashmaps of nodes.
+
+			\see NodeLattice::Key for converting a node to a LatticeKey.
+		*/
+		struct LatticeKey {
+			int64_t x, y, z; ///< Number of lattice steps along the x, y, and z axes.
+
+			/// \brief Check if every coordinate of this key is equal to those in `k2`.
+			inline bool operator==(const LatticeKey& k2) const { return x == k2.x && y == k2.y && z == k2.z; }
+
+			/// \brief Check if any coordinate of this key differs from those in `k2`.
+			inline bool operator!=(const LatticeKey& k2) const { return !operator==(k2); }
+
+			/// \brief Order keys by their x, then y, then z coordinates.
+			inline bool operator<(const LatticeKey& k2) const {
+				if (x != k2.x) return x < k2.x;
+				if (y != k2.y) return y < k2.y;
+				return z < k2.z;
+			}
+
+			/*!
+				\brief Get the index of this key along a Z-order curve over the x and y axes.
+
+				\returns A code formed by interleaving the bits of x and y. Keys that are close together
+						 on the x and y axes usually have close codes. The z coordinate is ignored.
+
+				\remarks
+				Only the lowest 32 bits of each coordinate are used, which covers keys within 2^31 steps
+				of the lattice's origin in either direction.
+			*/
+			inline uint64_t MortonCode() const {
+				auto spread = [](uint64_t v) {
+					v &= 0xFFFFFFFFull;
+					v = (v | (v << 16)) & 0x0000FFFF0000FFFFull;
+					v = (v | (v << 8)) & 0x00FF00FF00FF00FFull;
+					v = (v | (v << 4)) & 0x0F0F0F0F0F0F0F0Full;
+					v = (v | (v << 2)) & 0x3333333333333333ull;
+					v = (v | (v << 1)) & 0x5555555555555555ull;
+					return v;
+				};
+
+				// Offset both coordinates so negative keys come before positive ones
+				return spread(static_cast<uint64_t>(x) + 0x80000000ull)
+					| (spread(static_cast<uint64_t>(y) + 0x80000000ull) << 1);
+			}
+		};
+
+		/*!
+			\brief The key of an unordered pair of nodes on a NodeLattice.
+
+			\details
+			The endpoints are always stored in the same order, so the key of an edge from
+			`a` to `b` is equal to the key of the edge from `b` to `a`.
+		*/
+		struct LatticeEdgeKey {
+			LatticeKey a; ///< The lesser of the two endpoints.
+			LatticeKey b; ///< The greater of the two endpoints.
+
+			/// \brief Create an uninitialized key.
+			LatticeEdgeKey() = default;
+
+			/// \brief Create the key of the pair of nodes at `k1` and `k2`, in either order.
+			inline LatticeEdgeKey(const LatticeKey& k1, const LatticeKey& k2)
+				: a(k2 < k1 ? k2 : k1), b(k2 < k1 ? k1 : k2) {}
+
+			/// \brief Check if both endpoints of this key are equal to those in `k2`.
+			inline bool operator==(const LatticeEdgeKey& k2) const { return a == k2.a && b == k2.b; }
+
+			/// \brief Check if either endpoint of this key differs from those in `k2`.
+			inline bool operator!=(const LatticeEdgeKey& k2) const { return !operator==(k2); }
+		};
+
+		/*!
+			\brief A regular 3D grid used to quantize nodes into LatticeKeys.
+
+			\details
+			Every node is snapped to the nearest point of the lattice, so nodes that differ by
+			less than half a step in each axis will share a key. 
+
+			\par Example
+			\code
+				// be sure to #include "node.h"
+
+				// Create a lattice starting at the origin with steps of 0.5 on the x and y axis
+				// and steps of 0.01 on the z axis
+				HF::SpatialStructures::NodeLattice lattice({ 0, 0, 0 }, { 0.5, 0.5, 0.01 });
+
+				// Both of these nodes will have the key (2, -4, 100)
+				auto key_0 = lattice.Key(HF::SpatialStructures::Node(1.0f, -2.0f, 1.0f));
+				auto key_1 = lattice.Key(HF::SpatialStructures::Node(1.00001f, -2.0f, 1.0f));
+			\endcode
+		*/
+		struct NodeLattice {
+			std::array<double, 3> origin;		///< Position of the lattice point with the key (0, 0, 0)
+			std::array<double, 3> inv_steps;	///< The inverse of the distance between lattice points on each axis
+
+			/*!
+				\brief Create a lattice at the origin with ROUNDING_PRECISION as the step on every axis.
+				
+				\remarks Used by Graph to identify nodes with the precision of DHART_API.
+			*/
+			NodeLattice();
+
+			/*!
+				\brief Create a lattice with the given origin and steps.
+
+				\param origin Position of the lattice point with the key (0, 0, 0).
+				\param steps Distance between lattice points on the x, y, and z axes.
+			*/
+			NodeLattice(const std::array<double, 3>& origin, const std::array<double, 3>& steps);
+
+			/// \brief Get the key of the lattice point nearest to x, y, z.
+			inline LatticeKey Key(double x, double y, double z) const {
+				return LatticeKey{
+					std::llround((x - origin[0]) * inv_steps[0]),
+					std::llround((y - origin[1]) * inv_steps[1]),
+					std::llround((z - origin[2]) * inv_steps[2])
+				};
+			}
+
+			/// \brief Get the key of the lattice point nearest to `n`.
+			inline LatticeKey Key(const Node& n) const { return Key(n.x, n.y, n.z); }
+		};
 	};
 }
 
@@ -429,6 +561,30 @@ namespace std {
 		}
 	};
 
+	/// \brief Hash a lattice key by mixing each of its integer coordinates. 
+	template <>
+	struct hash<HF::SpatialStructures::LatticeKey>
+	{
+		inline std::size_t operator()(const HF::SpatialStructures::LatticeKey& k) const noexcept
+		{
+			uint64_t h = static_cast<uint64_t>(k.x) * 0x9E3779B97F4A7C15ull;
+			h ^= static_cast<uint64_t>(k.y) * 0xC2B2AE3D27D4EB4Full;
+			h ^= static_cast<uint64_t>(k.z) * 0x165667B19E3779F9ull;
+			return static_cast<std::size_t>(h ^ (h >> 29));
+		}
+	};
+
+	/// \brief Hash a lattice edge key by mixing the hashes of both of its endpoints.
+	template <>
+	struct hash<HF::SpatialStructures::LatticeEdgeKey>
+	{
+		inline std::size_t operator()(const HF::SpatialStructures::LatticeEdgeKey& k) const noexcept
+		{
+			const uint64_t h = std::hash<HF::SpatialStructures::LatticeKey>()(k.a) * 0xFF51AFD7ED558CCDull;
+			return static_cast<std::size_t>(h ^ std::hash<HF::SpatialStructures::LatticeKey>()(k.b));
+		}
+	};
+
 	/// \brief Create a string containing the x,y,z position of this node
 	inline ostream& operator<<(ostream& os, const HF::SpatialStructures::Node n) {
 		os << "(" << n.x << ", " << n.y << ", " << n.z << ")";
@@ -2,6 +2,7 @@
 #include <array>
 #include <graph_generator.h>
 #include <unique_queue.h>
+#include <concurrent_node_map.h>
 #include <embree_raytracer.h>
 #include <objloader.h>
 #include <meshinfo.h>
@@ -319,6 +320,59 @@ namespace HF {
 		q.push(n1);
 		ASSERT_FALSE(q.empty());
 	}
+
+	TEST(_ConcurrentNodeMap, InsertOnce) {
+		HF::GraphGenerator::ConcurrentNodeMap map;
+		SpatialStructures::LatticeKey n1{ 1,2,3 };
+
+		// The second insert should return the value from the first
+		auto first = map.Insert(n1, 5);
+		auto second = map.Insert(n1, 7);
+		EXPECT_EQ(first, second);
+		EXPECT_EQ(5, second->load());
+		EXPECT_EQ(1, map.size());
+	}
+
+	TEST(_ConcurrentNodeMap, Find) {
+		HF::GraphGenerator::ConcurrentNodeMap map;
+		SpatialStructures::LatticeKey n1{ 1,2,3 };
+		SpatialStructures::LatticeKey n2{ 3,2,1 };
+
+		map.Insert(n1, 5);
+		ASSERT_NE(nullptr, map.Find(n1));
+		EXPECT_EQ(5, map.Find(n1)->load());
+		EXPECT_EQ(nullptr, map.Find(n2));
+	}
+
+	TEST(_ConcurrentNodeMap, ReserveKeepsValues) {
+		HF::GraphGenerator::ConcurrentNodeMap map(4);
+
+		// Insert more nodes than the map was originally sized for
+		const int num_nodes = 5000;
+		for (int i = 0; i < num_nodes; i++) {
+			map.Reserve(1);
+			map.Insert(SpatialStructures::LatticeKey{ i, -i, 2 * i }, i);
+		}
+
+		ASSERT_EQ(num_nodes, map.size());
+		for (int i = 0; i < num_nodes; i++)
+			EXPECT_EQ(i, map.Find(SpatialStructures::LatticeKey{ i, -i, 2 * i })->load());
+	}
+
+	TEST(_ConcurrentNodeMap, ParallelInsert) {
+		const int num_nodes = 1000;
+		HF::GraphGenerator::ConcurrentNodeMap map;
+		map.Reserve(num_nodes);
+
+		// Insert every node several times from multiple threads
+		#pragma omp parallel for
+		for (int i = 0; i < num_nodes * 4; i++)
+			map.Insert(SpatialStructures::LatticeKey{ i % num_nodes, 0, 0 }, i % num_nodes);
+
+		ASSERT_EQ(num_nodes, map.size());
+		for (int i = 0; i < num_nodes; i++)
+			EXPECT_EQ(i, map.Find(SpatialStructures::LatticeKey{ i, 0, 0 })->load());
+	}
 }
 
 namespace CInterfaceTests {
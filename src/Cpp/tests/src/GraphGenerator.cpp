@@ -2,10 +2,22 @@
 #include <array>
 #include <graph_generator.h>
 #include <unique_queue.h>
+#include <crawl_cache.h>
+#include <graph_sink.h>
+#include <tiled_graph.h>
+#include <graph_update.h>
+#include <adaptive_graph.h>
+#include <floor_scenes.h>
+#include <cstdio>
+#include <cmath>
+#include <string>
+#include <fstream>
+#include <algorithm>
 #include <embree_raytracer.h>
 #include <objloader.h>
 #include <meshinfo.h>
 #include <graph.h>
+#include <cost_algorithms.h>
 #include <edge.h>
 #include <node.h>
 #include <Constants.h>
@@ -14,6 +26,8 @@
 #include <unique_queue.h>
 
 #include <MultiRT.h>
+#include <ray_data.h>
+#include <HFExceptions.h>
 
 using HF::SpatialStructures::Graph;
 using HF::GraphGenerator::GraphGenerator;
@@ -342,6 +356,590 @@ TEST(_GraphGenerator, CrawlGeom) {
 	ComparePoints(expected_parallel, g.Nodes());
 }
 
+TEST(_GraphGenerator, ParallelMatchesSerial) {
+	EmbreeRayTracer ray_tracer = CreateGGExmapleRT();
+
+	// Generate the same graph with a single core then with multiple cores
+	GraphGenerator serial_gg(ray_tracer);
+	GraphGenerator parallel_gg(ray_tracer);
+	std::array<float, 3> start_point{ 0,0,1 };
+	std::array<float, 3> spacing{ 0.5,0.5,1 };
+	Graph serial = serial_gg.BuildNetwork(start_point, spacing, -1, 1, 45, 1, 45, 2, 1, 0);
+	Graph parallel = parallel_gg.BuildNetwork(start_point, spacing, -1, 1, 45, 1, 45, 2, 1, -1);
+	serial.Compress();
+
+	// Ensure both graphs have the same nodes in the same order
+	const auto serial_nodes = serial.Nodes();
+	const auto parallel_nodes = parallel.Nodes();
+	ASSERT_GT(serial_nodes.size(), 100);
+	ComparePoints(serial_nodes, parallel_nodes);
+
+	// Ensure every node has the same edges
+	const auto serial_edges = serial.GetEdges();
+	const auto parallel_edges = parallel.GetEdges();
+	ASSERT_EQ(serial_edges.size(), parallel_edges.size());
+	for (int i = 0; i < serial_edges.size(); i++) {
+		ASSERT_EQ(serial_edges[i].children.size(), parallel_edges[i].children.size());
+		for (int j = 0; j < serial_edges[i].children.size(); j++) {
+			EXPECT_EQ(serial_edges[i].children[j].child, parallel_edges[i].children[j].child);
+			EXPECT_EQ(serial_edges[i].children[j].weight, parallel_edges[i].children[j].weight);
+		}
+	}
+}
+
+/*! \brief Rebuild the nodes and sorted rows of a graph from chunks written by the generator. */
+void MergeChunks(
+	const std::vector<HF::GraphGenerator::GraphChunk>& chunks,
+	std::vector<Node>& out_nodes,
+	std::vector<std::vector<std::pair<int, float>>>& out_rows)
+{
+	for (const auto& chunk : chunks) {
+		ASSERT_EQ(out_nodes.size(), chunk.first_id);
+		out_nodes.insert(out_nodes.end(), chunk.nodes.begin(), chunk.nodes.end());
+		out_rows.resize(out_nodes.size());
+
+		for (int r = 0; r < chunk.parent_ids.size(); r++)
+			for (int k = chunk.row_starts[r]; k < chunk.row_starts[r + 1]; k++) {
+				// Edges can only refer to nodes in this chunk or earlier ones
+				ASSERT_LT(chunk.children[k], out_nodes.size());
+				out_rows[chunk.parent_ids[r]].emplace_back(chunk.children[k], chunk.scores[k]);
+			}
+	}
+	for (auto& row : out_rows)
+		std::sort(row.begin(), row.end());
+}
+
+TEST(_GraphGenerator, StreamingMatchesGraph) {
+	EmbreeRayTracer ray_tracer = CreateGGExmapleRT();
+	std::array<float, 3> start_point{ 0,0,1 };
+	std::array<float, 3> spacing{ 0.5,0.5,1 };
+
+	for (int cores : { 0, -1 }) {
+		GraphGenerator gg(ray_tracer);
+		Graph g = gg.BuildNetwork(start_point, spacing, -1, 1, 45, 1, 45, 2, 1, cores);
+		g.Compress();
+
+		// Generate the same graph, but write it to a sink in small chunks
+		std::vector<HF::GraphGenerator::GraphChunk> chunks;
+		HF::GraphGenerator::CallbackGraphSink sink([&chunks](const HF::GraphGenerator::GraphChunk& chunk) { chunks.push_back(chunk); });
+		GraphGenerator streaming_gg(ray_tracer);
+		streaming_gg.sink = &sink;
+		streaming_gg.chunk_size = 100;
+		Graph empty = streaming_gg.BuildNetwork(start_point, spacing, -1, 1, 45, 1, 45, 2, 1, cores);
+
+		EXPECT_EQ(0, empty.size());
+		ASSERT_GT(chunks.size(), 2);
+
+		std::vector<Node> nodes;
+		std::vector<std::vector<std::pair<int, float>>> rows;
+		MergeChunks(chunks, nodes, rows);
+
+		// Ensure the chunks contain exactly the same nodes and edges as the graph
+		ComparePoints(g.Nodes(), nodes);
+		const auto edges = g.GetEdges();
+		ASSERT_EQ(edges.size(), rows.size());
+		for (int i = 0; i < edges.size(); i++) {
+			ASSERT_EQ(edges[i].children.size(), rows[i].size());
+			for (int j = 0; j < rows[i].size(); j++) {
+				EXPECT_EQ(edges[i].children[j].child, rows[i][j].first);
+				EXPECT_EQ(edges[i].children[j].weight, rows[i][j].second);
+			}
+		}
+	}
+}
+
+TEST(_GraphGenerator, StreamingMemoryIsBounded) {
+	// Create a large, flat floor
+	const std::vector<float> floor_vertices{
+		-50.0f, 50.0f, 0.0f,
+		-50.0f, -50.0f, 0.0f,
+		50.0f, 50.0f, 0.0f,
+		50.0f, -50.0f, 0.0f,
+	};
+	const std::vector<int> indices{ 3, 1, 0, 2, 3, 0 };
+	EmbreeRayTracer ray_tracer(std::vector<HF::Geometry::MeshInfo<float>>{
+		HF::Geometry::MeshInfo<float>(floor_vertices, indices, 0, "Floor")
+	});
+
+	for (int cores : { 0, -1 }) {
+		// Stream the graph to a sink, only counting its nodes
+		size_t num_nodes = 0;
+		HF::GraphGenerator::CallbackGraphSink sink([&num_nodes](const HF::GraphGenerator::GraphChunk& chunk) { num_nodes += chunk.nodes.size(); });
+		GraphGenerator gg(ray_tracer);
+		gg.sink = &sink;
+		gg.chunk_size = 1000;
+		gg.BuildNetwork(std::array<float, 3>{ 0, 0, 1 }, std::array<float, 3>{ 0.5, 0.5, 1 }, -1, 1, 45, 1, 45, 1, 1, cores);
+		ASSERT_GT(num_nodes, 30000);
+
+		// The queue and cache should only ever hold a few rings of nodes around the start point
+		EXPECT_GT(gg.stats.peak_queue, 0);
+		EXPECT_LT(gg.stats.peak_queue, num_nodes / 4);
+		EXPECT_LT(gg.stats.peak_floors, num_nodes / 4);
+		EXPECT_LT(gg.stats.peak_connections, num_nodes / 4);
+	}
+}
+
+TEST(_GraphGenerator, FusedEdgeCosts) {
+	using HF::GraphGenerator::EdgeCost;
+	using HF::GraphGenerator::EdgeCostName;
+
+	auto mesh = HF::Geometry::LoadMeshObjects("energy_blob_zup.obj", HF::Geometry::ONLY_FILE, false);
+	EmbreeRayTracer ray_tracer(mesh);
+	std::array<float, 3> start_point{ 0,0,20 };
+	std::array<float, 3> spacing{ 1,1,1 };
+
+	for (int cores : { 0, -1 }) {
+		// Generate a graph over uneven terrain, calculating every extra cost as edges are found
+		GraphGenerator gg(ray_tracer);
+		gg.edge_costs = { EdgeCost::CROSS_SLOPE, EdgeCost::ENERGY_EXPENDITURE, EdgeCost::STEP_TYPE };
+		Graph g = gg.BuildNetwork(start_point, spacing, 5000, 0.5, 20, 0.5, 20, 2, 4, cores);
+		ASSERT_GT(g.size(), 1000);
+
+		// Ensure the costs match those calculated after generation
+		const auto cross_slopes = HF::SpatialStructures::CostAlgorithms::CalculateCrossSlope(g);
+		const auto energy = HF::SpatialStructures::CostAlgorithms::CalculateEnergyExpenditure(g);
+		const std::string cross_slope_name = EdgeCostName(EdgeCost::CROSS_SLOPE);
+		const std::string energy_name = EdgeCostName(EdgeCost::ENERGY_EXPENDITURE);
+		const std::string step_name = EdgeCostName(EdgeCost::STEP_TYPE);
+		for (int parent = 0; parent < g.size(); parent++) {
+			ASSERT_EQ(cross_slopes[parent].size(), energy[parent].children.size());
+			for (int k = 0; k < cross_slopes[parent].size(); k++) {
+				const int child = cross_slopes[parent][k].child;
+				EXPECT_NEAR(cross_slopes[parent][k].weight, g.GetCost(parent, child, cross_slope_name), 0.001);
+				EXPECT_NEAR(energy[parent].children[k].weight, g.GetCost(parent, child, energy_name), 0.001);
+
+				const float step = g.GetCost(parent, child, step_name);
+				EXPECT_GE(step, HF::SpatialStructures::STEP::NONE);
+				EXPECT_LE(step, HF::SpatialStructures::STEP::OVER);
+			}
+		}
+	}
+}
+
+TEST(_GraphGenerator, FileGraphSink) {
+	EmbreeRayTracer ray_tracer = CreateGGExmapleRT();
+	const std::string path = "graph_sink_test.bin";
+	std::remove(path.c_str());
+
+	// Write the graph to both a file and a callback
+	std::vector<HF::GraphGenerator::GraphChunk> written;
+	{
+		HF::GraphGenerator::FileGraphSink file_sink(path);
+		HF::GraphGenerator::CallbackGraphSink sink([&](const HF::GraphGenerator::GraphChunk& chunk) {
+			written.push_back(chunk);
+			file_sink.Write(chunk);
+		});
+
+		GraphGenerator gg(ray_tracer);
+		gg.sink = &sink;
+		gg.chunk_size = 100;
+		gg.edge_costs = { HF::GraphGenerator::EdgeCost::STEP_TYPE };
+		gg.BuildNetwork(std::array<float, 3>{ 0, 0, 1 }, std::array<float, 3>{ 0.5, 0.5, 1 }, -1, 1, 45, 1, 45, 2, 1, 0);
+	}
+
+	// Read the chunks back and ensure they match what was written
+	std::vector<HF::GraphGenerator::GraphChunk> read;
+	HF::GraphGenerator::ReadGraphChunks(path, [&read](const HF::GraphGenerator::GraphChunk& chunk) { read.push_back(chunk); });
+	std::remove(path.c_str());
+
+	ASSERT_EQ(written.size(), read.size());
+	for (int i = 0; i < written.size(); i++) {
+		EXPECT_EQ(written[i].first_id, read[i].first_id);
+		ComparePoints(written[i].nodes, read[i].nodes);
+		EXPECT_EQ(written[i].parent_ids, read[i].parent_ids);
+		EXPECT_EQ(written[i].row_starts, read[i].row_starts);
+		EXPECT_EQ(written[i].children, read[i].children);
+		EXPECT_EQ(written[i].scores, read[i].scores);
+		EXPECT_EQ(written[i].costs, read[i].costs);
+		ASSERT_EQ(1, read[i].costs.size());
+		EXPECT_EQ(read[i].children.size(), read[i].costs[0].size());
+	}
+}
+
+TEST(_GraphGenerator, Clearance) {
+	// Create a floor with a wall across it at x = 5
+	const std::vector<float> floor_vertices{
+		-10.0f, 10.0f, 0.0f,
+		-10.0f, -10.0f, 0.0f,
+		10.0f, 10.0f, 0.0f,
+		10.0f, -10.0f, 0.0f,
+	};
+	const std::vector<float> wall_vertices{
+		5.0f, 10.0f, -1.0f,
+		5.0f, -10.0f, -1.0f,
+		5.0f, 10.0f, 3.0f,
+		5.0f, -10.0f, 3.0f,
+	};
+	const std::vector<int> indices{ 3, 1, 0, 2, 3, 0 };
+	EmbreeRayTracer ray_tracer(std::vector<HF::Geometry::MeshInfo<float>>{
+		HF::Geometry::MeshInfo<float>(floor_vertices, indices, 0, "Floor"),
+		HF::Geometry::MeshInfo<float>(wall_vertices, indices, 1, "Wall")
+	});
+
+	for (int cores : { 0, -1 }) {
+		GraphGenerator gg(ray_tracer);
+		gg.clearance_radius = 3;
+		Graph g = gg.BuildNetwork(std::array<float, 3>{ 0, 0, 1 }, std::array<float, 3>{ 1, 1, 1 }, -1, 0.5, 30, 0.5, 30, 1, 1, cores);
+		ASSERT_GT(g.size(), 100);
+
+		// The floor is ignored, so clearance is the distance to the wall up to the radius
+		const auto nodes = g.Nodes();
+		const auto clearances = g.GetNodeAttributesFloat(GraphGenerator::clearance_attribute);
+		ASSERT_EQ(nodes.size(), clearances.size());
+		for (int i = 0; i < nodes.size(); i++)
+			EXPECT_NEAR(std::min(3.0f, std::abs(nodes[i].x - 5.0f)), clearances[i], 0.001f);
+	}
+
+	// Every chunk written to a sink holds the clearance of its nodes
+	std::vector<HF::GraphGenerator::GraphChunk> chunks;
+	HF::GraphGenerator::CallbackGraphSink sink([&chunks](const HF::GraphGenerator::GraphChunk& chunk) { chunks.push_back(chunk); });
+	GraphGenerator gg(ray_tracer);
+	gg.clearance_radius = 3;
+	gg.sink = &sink;
+	gg.chunk_size = 50;
+	gg.BuildNetwork(std::array<float, 3>{ 0, 0, 1 }, std::array<float, 3>{ 1, 1, 1 }, -1, 0.5, 30, 0.5, 30, 1, 1, 0);
+	ASSERT_GT(chunks.size(), 1);
+	for (const auto& chunk : chunks)
+		EXPECT_EQ(chunk.nodes.size(), chunk.clearances.size());
+}
+
+/*! \brief Get every edge of a graph identified by the positions of its nodes rounded to the nearest millimeter. */
+std::vector<std::array<long long, 7>> EdgesByPosition(Graph& g)
+{
+	const auto nodes = g.Nodes();
+	auto mm = [](float f) { return std::llround(f * 1000.0); };
+
+	std::vector<std::array<long long, 7>> out;
+	for (const auto& edge_set : g.GetEdges()) {
+		const auto& parent = nodes[edge_set.parent];
+		for (const auto& edge : edge_set.children) {
+			const auto& child = nodes[edge.child];
+			out.push_back({ mm(parent.x), mm(parent.y), mm(parent.z), mm(child.x), mm(child.y), mm(child.z), mm(edge.weight) });
+		}
+	}
+	std::sort(out.begin(), out.end());
+	return out;
+}
+
+TEST(_GraphGenerator, OBS_FloorScenes) {
+	EmbreeRayTracer ray_tracer = CreateObstacleExampleRT();
+
+	// Setup Graph Parameters. Start beside the obstacle, since nodes can't be placed on it.
+	std::array<float, 3> start_point{ 15,0,0.25 };
+	std::array<float, 3> spacing{ 0.5,0.5,1 };
+	int max_nodes = -1;
+	int up_step = 1; int down_step = 1;
+	int up_slope = 45; int down_slope = 45;
+	int max_step_connections = 1;
+	int min_connections = 1;
+
+	// Tag the plane as walkable and the obstacle as an obstacle. Constructing the graph generator from
+	// an EmbreeRayTracer casts floor rays in a scene containing only the plane.
+	HF::GraphGenerator::GraphGenerator GG = GraphGenerator::GraphGenerator(ray_tracer, std::vector<int>{ 2 }, std::vector<int>{ 0, 1 });
+	ASSERT_TRUE(GG.params.floor_scenes);
+
+	// A graph generator using a MultiRT casts every ray against the entire scene instead
+	HF::RayTracer::MultiRT multi_rt(&ray_tracer);
+	ASSERT_FALSE(GraphGenerator::GraphGenerator(multi_rt, std::vector<int>{ 2 }, std::vector<int>{ 0, 1 }).params.floor_scenes);
+
+	Graph graph = GG.BuildNetwork(
+		start_point, spacing, max_nodes,
+		up_step, down_step, up_slope, down_slope,
+		max_step_connections, min_connections
+	);
+
+	// No node should be over the obstacle, but the graph should still reach the other side of it
+	bool reached_far_side = false;
+	for (const auto& node : graph.Nodes()) {
+		EXPECT_FALSE(std::abs(node.x) < 10.5 && std::abs(node.y) < 9.5) << node.x << ", " << node.y;
+		reached_far_side |= node.x < -11;
+	}
+	EXPECT_TRUE(reached_far_side);
+}
+
+TEST(_GraphGenerator, OBS_FloorScenesFollowEdits) {
+	// Create a walkable floor with an obstacle hovering over its middle
+	const std::vector<float> floor_vertices{
+		-10.0f, 10.0f, 0.0f,
+		-10.0f, -10.0f, 0.0f,
+		10.0f, 10.0f, 0.0f,
+		10.0f, -10.0f, 0.0f,
+	};
+	const std::vector<float> obstacle_vertices{
+		-2.0f, 2.0f, 0.5f,
+		-2.0f, -2.0f, 0.5f,
+		2.0f, 2.0f, 0.5f,
+		2.0f, -2.0f, 0.5f,
+	};
+	const std::vector<int> indices{ 3, 1, 0, 2, 3, 0 };
+	std::vector<HF::Geometry::MeshInfo<float>> meshes{
+		HF::Geometry::MeshInfo<float>(floor_vertices, indices, 0, "Floor"),
+		HF::Geometry::MeshInfo<float>(obstacle_vertices, indices, 1, "Obstacle")
+	};
+	EmbreeRayTracer ray_tracer(meshes);
+	const int floor_id = meshes[0].meshid;
+	const int obstacle_id = meshes[1].meshid;
+
+	GraphGenerator gg(ray_tracer, std::vector<int>{ obstacle_id }, std::vector<int>{ floor_id });
+	ASSERT_TRUE(gg.params.floor_scenes);
+
+	auto count_under_obstacle = [&gg]() {
+		Graph g = gg.BuildNetwork(std::array<float, 3>{ 5, 5, 1 }, std::array<float, 3>{ 0.5, 0.5, 1 }, -1, 1, 45, 1, 45, 1, 1, 0);
+		int count = 0;
+		for (const auto& node : g.Nodes())
+			if (std::abs(node.x) < 1.5 && std::abs(node.y) < 1.5)
+				count++;
+		return count;
+	};
+	EXPECT_EQ(0, count_under_obstacle());
+
+	// Once the obstacle is removed, the floor scenes are split again and the floor beneath it is reached
+	ASSERT_TRUE(ray_tracer.RemoveMesh(obstacle_id));
+	EXPECT_TRUE(gg.params.floor_scenes->IsStale());
+	EXPECT_GT(count_under_obstacle(), 0);
+	EXPECT_FALSE(gg.params.floor_scenes->IsStale());
+}
+
+TEST(_GraphGenerator, TiledMatchesSingleCrawl) {
+	EmbreeRayTracer ray_tracer = CreateGGExmapleRT();
+
+	HF::GraphGenerator::GeneratorSettings settings;
+	settings.start_point = { 0, 0, 1 };
+	settings.spacing = { 0.5, 0.5, 1 };
+	settings.up_step = 1; settings.up_slope = 45;
+	settings.down_step = 1; settings.down_slope = 45;
+	settings.max_step_connections = 2;
+	settings.cores = 0;
+
+	HF::GraphGenerator::GenerationBounds domain{ -10, -10, 10, 10 };
+
+	// Generate the domain in a single crawl
+	GraphGenerator single_gg(ray_tracer);
+	single_gg.bounds = domain;
+	Graph single = single_gg.BuildNetwork(
+		settings.start_point, settings.spacing, -1, 1, 45, 1, 45, 2, 1, 0
+	);
+	single.Compress();
+
+	// Generate it again as tiles, using a separate generator for each to simulate separate processes.
+	// Only use a single seed per tile and no overlap so the borders need to be rechecked.
+	const auto tiles = HF::GraphGenerator::PlanTiles(settings, domain, 12, 0, 12);
+	ASSERT_EQ(16, tiles.size());
+
+	std::vector<std::string> paths;
+	for (const auto& tile : tiles) {
+		paths.push_back("tiled_graph_test_" + std::to_string(tile.index) + ".bin");
+		GraphGenerator tile_gg(ray_tracer);
+		HF::GraphGenerator::GenerateTile(tile_gg, settings, tile, paths.back());
+	}
+
+	// Merge the tiles with another generator
+	GraphGenerator merge_gg(ray_tracer);
+	Graph merged = HF::GraphGenerator::MergeTiles(merge_gg, settings, tiles, paths);
+
+	ASSERT_GT(single.size(), 1000);
+	ASSERT_EQ(single.size(), merged.size());
+	EXPECT_EQ(EdgesByPosition(single), EdgesByPosition(merged));
+
+	// Regenerating a tile shouldn't change the result
+	GraphGenerator rerun_gg(ray_tracer);
+	HF::GraphGenerator::GenerateTile(rerun_gg, settings, tiles[5], paths[5]);
+	Graph remerged = HF::GraphGenerator::MergeTiles(merge_gg, settings, tiles, paths);
+	EXPECT_EQ(merged.Nodes(), remerged.Nodes());
+	EXPECT_EQ(EdgesByPosition(merged), EdgesByPosition(remerged));
+
+	// If a tile found nothing, its nodes should be recovered when the borders of its neighbours are rechecked
+	std::ofstream(paths[5], std::ios::binary | std::ios::trunc);
+	Graph recovered = HF::GraphGenerator::MergeTiles(merge_gg, settings, tiles, paths);
+	EXPECT_EQ(EdgesByPosition(single), EdgesByPosition(recovered));
+
+	for (const auto& path : paths)
+		std::remove(path.c_str());
+}
+
+TEST(_GraphGenerator, TilesRestoreGenerator) {
+	// Clearances can't be found with NanoRT, so crawling a tile with one set will throw
+	const std::vector<float> floor_vertices{
+		-10.0f, 10.0f, 0.0f,
+		-10.0f, -10.0f, 0.0f,
+		10.0f, 10.0f, 0.0f,
+		10.0f, -10.0f, 0.0f,
+	};
+	HF::RayTracer::NanoRTRayTracer ray_tracer(HF::Geometry::MeshInfo<float>(floor_vertices, { 3, 1, 0, 2, 3, 0 }, 0, "Floor"));
+	GraphGenerator gg(ray_tracer);
+	gg.clearance_radius = 1;
+
+	HF::GraphGenerator::GeneratorSettings settings;
+	settings.start_point = { 0, 0, 1 };
+	settings.spacing = { 0.5, 0.5, 1 };
+	settings.cores = 0;
+	const auto tiles = HF::GraphGenerator::PlanTiles(settings, HF::GraphGenerator::GenerationBounds{ -5, -5, 5, 5 }, 20, 0, 4);
+	ASSERT_EQ(1, tiles.size());
+
+	// The generator's own sink and bounds should be put back, even though the crawl failed
+	HF::GraphGenerator::CallbackGraphSink sink([](const HF::GraphGenerator::GraphChunk&) {});
+	gg.sink = &sink;
+	gg.bounds = HF::GraphGenerator::GenerationBounds{ -1, -2, 3, 4 };
+
+	const std::string path = "tile_restore_test.bin";
+	EXPECT_THROW(HF::GraphGenerator::GenerateTile(gg, settings, tiles[0], path), HF::Exceptions::NotImplemented);
+	EXPECT_EQ(&sink, gg.sink);
+	EXPECT_EQ(-1, gg.bounds.min_x);
+	EXPECT_EQ(-2, gg.bounds.min_y);
+	EXPECT_EQ(3, gg.bounds.max_x);
+	EXPECT_EQ(4, gg.bounds.max_y);
+
+	std::remove((path + ".part").c_str());
+}
+
+TEST(_GraphGenerator, RegenerateRegion) {
+	EmbreeRayTracer ray_tracer = CreateGGExmapleRT();
+
+	HF::GraphGenerator::GeneratorSettings settings;
+	settings.start_point = { 0, 0, 1 };
+	settings.spacing = { 0.5, 0.5, 1 };
+	settings.up_step = 1; settings.up_slope = 45;
+	settings.down_step = 1; settings.down_slope = 45;
+	settings.max_step_connections = 2;
+	settings.cores = 0;
+	const HF::GraphGenerator::GenerationBounds bounds{ -5, -5, 5, 5 };
+
+	auto build = [&]() {
+		GraphGenerator gg(ray_tracer);
+		gg.bounds = bounds;
+		Graph g = gg.BuildNetwork(settings.start_point, settings.spacing, -1, 1, 45, 1, 45, 2, 1, 0);
+		g.Compress();
+		return g;
+	};
+	Graph before = build();
+
+	// Add a wall between two columns of nodes
+	std::vector<std::array<float, 3>> wall = {
+		{ 1.25f, -2, -1 }, { 1.25f, 2, -1 }, { 1.25f, 2, 3 },
+		{ 1.25f, -2, -1 }, { 1.25f, 2, 3 }, { 1.25f, -2, 3 },
+	};
+	ray_tracer.AddMesh(wall, 1, true);
+	Graph full = build();
+
+	// Update the graph from before the wall was added
+	GraphGenerator gg(ray_tracer);
+	gg.bounds = bounds;
+	HF::GraphGenerator::DirtyRegion region{ { 1.25, -2, -1 }, { 1.25, 2, 3 } };
+	Graph updated = HF::GraphGenerator::RegenerateRegion(gg, settings, before, region);
+
+	// The wall should have removed edges, and the update should match generating the graph again
+	EXPECT_NE(EdgesByPosition(before), EdgesByPosition(full));
+	ASSERT_EQ(full.size(), updated.size());
+	EXPECT_EQ(EdgesByPosition(full), EdgesByPosition(updated));
+
+	// Nodes that weren't over the wall should keep their IDs
+	ComparePoints(before.Nodes(), updated.Nodes());
+}
+
+TEST(_GraphGenerator, MultiSeedRegionOfInterest) {
+	EmbreeRayTracer ray_tracer = CreateGGExmapleRT();
+	const std::array<float, 3> spacing{ 0.5, 0.5, 1 };
+
+	// Limit the graph to a diamond around the origin
+	HF::GraphGenerator::GenerationBounds region;
+	region.polygon = { { -4, 0 }, { 0, -4 }, { 4, 0 }, { 0, 4 } };
+
+	GraphGenerator single_gg(ray_tracer);
+	single_gg.bounds = region;
+	Graph single = single_gg.BuildNetwork(std::array<float, 3>{ 0, 0, 1 }, spacing, -1, 1, 45, 1, 45, 2, 1, 0);
+	single.Compress();
+
+	// Crawl from several seeds at once. One isn't on the lattice of the first, and one is outside the region.
+	const std::vector<std::array<float, 3>> seeds = { { -2, 0, 1 }, { 2.1f, 0.2f, 1 }, { 10, 10, 1 } };
+	for (int cores : { 0, -1 }) {
+		GraphGenerator gg(ray_tracer);
+		gg.bounds = region;
+		Graph multi = gg.BuildNetwork(seeds, spacing, -1, 1, 45, 1, 45, 2, 1, cores);
+		multi.Compress();
+
+		// Every node with edges should be inside the region
+		const auto nodes = multi.Nodes();
+		for (const auto& edge_set : multi.GetEdges())
+			if (!edge_set.children.empty())
+				EXPECT_TRUE(region.Contains(nodes[edge_set.parent]));
+
+		// Since the region is connected, it should match crawling from a single seed
+		ASSERT_GT(multi.size(), 50);
+		EXPECT_EQ(single.size(), multi.size());
+		EXPECT_EQ(EdgesByPosition(single), EdgesByPosition(multi));
+	}
+}
+
+TEST(_GraphGenerator, AdaptiveResolution) {
+	EmbreeRayTracer ray_tracer = CreateGGExmapleRT();
+
+	// Add a wall to the plane so nodes near it need the full spacing
+	std::vector<std::array<float, 3>> wall = {
+		{ 1.25f, -2, -1 }, { 1.25f, 2, -1 }, { 1.25f, 2, 3 },
+		{ 1.25f, -2, -1 }, { 1.25f, 2, 3 }, { 1.25f, -2, 3 },
+	};
+	ray_tracer.AddMesh(wall, 1, true);
+
+	HF::GraphGenerator::GeneratorSettings settings;
+	settings.start_point = { 0, 0, 1 };
+	settings.spacing = { 0.5, 0.5, 1 };
+	settings.up_step = 1; settings.up_slope = 45;
+	settings.down_step = 1; settings.down_slope = 45;
+	settings.max_step_connections = 1;
+	const HF::GraphGenerator::GenerationBounds bounds{ -8, -8, 8, 8 };
+
+	for (int cores : { 0, -1 }) {
+		settings.cores = cores;
+
+		GraphGenerator fine_gg(ray_tracer);
+		fine_gg.bounds = bounds;
+		Graph fine = fine_gg.BuildNetwork(settings.start_point, settings.spacing, -1, 1, 45, 1, 45, 1, 1, cores);
+		fine.Compress();
+
+		// Without any coarser levels, the graph should be the same
+		GraphGenerator gg(ray_tracer);
+		gg.bounds = bounds;
+		Graph single_level = HF::GraphGenerator::GenerateAdaptiveGraph(gg, settings, 0);
+		ASSERT_GT(fine.size(), 1000);
+		EXPECT_EQ(EdgesByPosition(fine), EdgesByPosition(single_level));
+
+		// Open areas should be covered by far fewer nodes
+		Graph adaptive = HF::GraphGenerator::GenerateAdaptiveGraph(gg, settings, 2);
+		EXPECT_LT(adaptive.size() * 3, fine.size());
+
+		// Nodes next to the wall should still have the full spacing
+		const auto nodes = adaptive.Nodes();
+		int near_wall = 0;
+		for (const auto& node : nodes)
+			if (std::abs(node.x - 1.0f) < 0.01f && std::abs(node.y) < 1.9f)
+				near_wall++;
+		EXPECT_GE(near_wall, 7);
+
+		// Every node should be reachable from every other, without crossing the wall
+		const auto edges = adaptive.GetEdges();
+		std::vector<char> reached(nodes.size(), false);
+		std::vector<int> to_visit{ 0 };
+		reached[0] = true;
+		while (!to_visit.empty()) {
+			const int parent = to_visit.back();
+			to_visit.pop_back();
+			for (const auto& edge : edges[parent].children) {
+				const auto& a = nodes[parent];
+				const auto& b = nodes[edge.child];
+				const bool crosses_wall = (a.x < 1.25f) != (b.x < 1.25f)
+					&& std::abs(a.y + (b.y - a.y) * (1.25f - a.x) / (b.x - a.x)) < 2;
+				EXPECT_FALSE(crosses_wall);
+
+				if (!reached[edge.child]) {
+					reached[edge.child] = true;
+					to_visit.push_back(edge.child);
+				}
+			}
+		}
+		EXPECT_EQ(std::count(reached.begin(), reached.end(), true), nodes.size());
+	}
+}
+
 TEST(_GraphGenerator, ValidateStartPoint) {
 	EmbreeRayTracer ray_tracer = CreateGGExmapleRT();
 
@@ -568,6 +1166,40 @@ TEST(_GraphGenerator, CheckChildren) {
 		EXPECT_NEAR(0, DistanceTo(actual_child, expected_child), 0.00001);
 	}
 }
+
+TEST(_GraphGenerator, CheckChildrenCache) {
+	EmbreeRayTracer ray_tracer = CreateGGExmapleRT();
+	HF::RayTracer::MultiRT rt(&ray_tracer);
+
+	HF::GraphGenerator::GraphParams params;
+	params.up_step = 2; params.down_step = 2;
+	params.up_slope = 45; params.down_slope = 45;
+	params.precision.node_z = 0.01f;
+	params.precision.ground_offset = 0.01f;
+
+	HF::GraphGenerator::CrawlCache cache(HF::SpatialStructures::NodeLattice({ 0, 0, 1 }, { 1, 1, 0.01 }));
+
+	// Two parents that share two of their children
+	HF::GraphGenerator::real3 parent_a{ 0,0,1 };
+	HF::GraphGenerator::real3 parent_b{ 1,1,1 };
+	std::vector<HF::GraphGenerator::real3> children_a{ {0,2,1}, {1,0,1}, {0,1,1}, {2,0,1} };
+	std::vector<HF::GraphGenerator::real3> children_b{ {0,1,1}, {1,0,1}, {2,1,1}, {1,2,1} };
+
+	// The first parent casts a ray for each of its children
+	cache.Reserve(children_a.size());
+	auto cached_a = HF::GraphGenerator::CheckChildren(parent_a, children_a, rt, params, &cache);
+	EXPECT_EQ(children_a.size(), cache.NumFloors());
+
+	// The second parent only casts rays for the children it doesn't share
+	cache.Reserve(children_b.size());
+	auto cached_b = HF::GraphGenerator::CheckChildren(parent_b, children_b, rt, params, &cache);
+	EXPECT_EQ(children_a.size() + 2, cache.NumFloors());
+
+	// Results are the same as casting every ray
+	EXPECT_EQ(HF::GraphGenerator::CheckChildren(parent_a, children_a, rt, params), cached_a);
+	EXPECT_EQ(HF::GraphGenerator::CheckChildren(parent_b, children_b, rt, params), cached_b);
+}
+
 TEST(_GraphGenerator, CheckConnection) {
 	EmbreeRayTracer ray_tracer = CreateGGExmapleRT();
 
@@ -611,6 +1243,68 @@ TEST(_GraphGenerator, CheckConnection) {
 	ASSERT_EQ(expected_output, out_str.str());
 }
 
+TEST(_GraphGenerator, CheckConnections) {
+	EmbreeRayTracer ray_tracer = CreateGGExmapleRT();
+	HF::RayTracer::MultiRT rt(&ray_tracer);
+
+	// Create a parent node
+	HF::GraphGenerator::real3 parent{ 0,0,1 };
+
+	// Create a vector of possible children
+	std::vector<HF::GraphGenerator::real3> possible_children{
+		HF::GraphGenerator::real3{0,2,0}, HF::GraphGenerator::real3{1,0,0},
+		HF::GraphGenerator::real3{0,1,0}, HF::GraphGenerator::real3{2,0,0},
+		HF::GraphGenerator::real3{0,1,1}, HF::GraphGenerator::real3{2,2,1.5}
+	};
+
+	// Create graph parameters
+	HF::GraphGenerator::GraphParams params;
+	params.up_step = 2; params.down_step = 2;
+	params.up_slope = 45; params.down_slope = 45;
+	params.precision.node_z = 0.01f;
+	params.precision.ground_offset = 0.01f;
+
+	// Check every connection at once
+	auto connections = HF::GraphGenerator::CheckConnections(parent, possible_children, rt, params);
+
+	// Ensure the result matches checking every connection individually
+	ASSERT_EQ(possible_children.size(), connections.size());
+	for (int i = 0; i < possible_children.size(); i++)
+		EXPECT_EQ(HF::GraphGenerator::CheckConnection(parent, possible_children[i], rt, params), connections[i]);
+}
+
+
+TEST(_GraphGenerator, CheckConnectionsCache) {
+	EmbreeRayTracer ray_tracer = CreateGGExmapleRT();
+	HF::RayTracer::MultiRT rt(&ray_tracer);
+
+	HF::GraphGenerator::GraphParams params;
+	params.up_step = 2; params.down_step = 2;
+	params.up_slope = 45; params.down_slope = 45;
+	params.precision.node_z = 0.01f;
+	params.precision.ground_offset = 0.01f;
+
+	HF::GraphGenerator::CrawlCache cache(HF::SpatialStructures::NodeLattice({ 0, 0, 0 }, { 1, 1, 0.01 }));
+
+	// Check the connections from a parent to its children
+	HF::GraphGenerator::real3 parent{ 0,0,1 };
+	std::vector<HF::GraphGenerator::real3> children{ {0,2,0}, {1,0,0}, {0,1,0}, {2,0,0} };
+
+	cache.Reserve(children.size());
+	auto forward = HF::GraphGenerator::CheckConnections(parent, children, rt, params, &cache);
+	EXPECT_EQ(children.size(), cache.NumConnections());
+
+	// Check the connection back to the parent from every child in the next level. None
+	// of these should need to be cast again.
+	cache.NextLevel();
+	for (const auto& child : children) {
+		const std::vector<HF::GraphGenerator::real3> back{ parent };
+		cache.Reserve(back.size());
+		auto cached = HF::GraphGenerator::CheckConnections(child, back, rt, params, &cache);
+		EXPECT_EQ(HF::GraphGenerator::CheckConnections(child, back, rt, params), cached);
+	}
+	EXPECT_EQ(0, cache.NumConnections());
+}
 
 TEST(_GraphGenerator, CheckSlope) {
 	
@@ -13,6 +13,7 @@
 #include <node.h>
 #include <edge.h>
 #include <path.h>
+#include <path_hierarchy.h>
 #include <HFExceptions.h>
 
 #include "pathfinder_C.h"
@@ -539,6 +540,82 @@ TEST(_pathFinding, FindPaths) {
 	}
 }
 
+TEST(_pathFinding, PathHierarchy) {
+	// Create a 40x40 grid with a wall at x = 20 that can only be crossed near the top
+	const int size = 40;
+	Graph g;
+	for (int x = 0; x < size; x++)
+		for (int y = 0; y < size; y++) {
+			for (const auto [dx, dy] : { std::pair{1, 0}, std::pair{-1, 0}, std::pair{0, 1}, std::pair{0, -1}, std::pair{1, 1}, std::pair{-1, -1} }) {
+				const int nx = x + dx, ny = y + dy;
+				if (nx < 0 || ny < 0 || nx >= size || ny >= size) continue;
+				if ((nx == 20) != (x == 20) && y < 35) continue;
+				g.addEdge(Node(x, y, 0), Node(nx, ny, 0), std::sqrt(static_cast<float>(dx * dx + dy * dy)));
+			}
+		}
+	g.Compress();
+	auto id = [&g](int x, int y) { return g.getID(Node(x, y, 0)); };
+
+	// Boost graphs take the hierarchy of the graph when they're created
+	auto dijkstra = CreateBoostGraph(g);
+	EnablePathHierarchy(g, 8.0f);
+	auto hierarchical = CreateBoostGraph(g);
+	ASSERT_NE(nullptr, hierarchical->hierarchy);
+	EXPECT_EQ(nullptr, dijkstra->hierarchy);
+
+	vector<int> starts, ends;
+	for (int i = 0; i < 50; i++) {
+		starts.push_back((i * 7919) % (size * size));
+		ends.push_back((i * 104729 + 13) % (size * size));
+	}
+	starts.push_back(id(1, 1)); ends.push_back(id(3, 2));
+	auto shortest = FindPaths(dijkstra.get(), starts, ends);
+	auto planned = FindPaths(hierarchical.get(), starts, ends);
+
+	auto total_cost = [](const Path& p) {
+		float cost = 0;
+		for (const auto& member : p.members) cost += member.cost;
+		return cost;
+	};
+	for (int i = 0; i < starts.size(); i++) {
+		if (starts[i] == ends[i]) continue;
+		const Path& p = planned[i];
+		ASSERT_GE(p.size(), 2);
+		EXPECT_EQ(p.members.front().node, starts[i]);
+		EXPECT_EQ(p.members.back().node, ends[i]);
+		EXPECT_EQ(p.members.back().cost, 0);
+
+		// Every step of the path must follow an edge of the graph
+		for (int k = 0; k + 1 < p.size(); k++) {
+			ASSERT_TRUE(g.HasEdge(p.members[k].node, p.members[k + 1].node));
+			EXPECT_FLOAT_EQ(p.members[k].cost, g.GetCost(p.members[k].node, p.members[k + 1].node));
+		}
+
+		// Paths through portals may be slightly longer than the shortest path
+		const float optimal = total_cost(shortest[i]);
+		EXPECT_GE(total_cost(p), optimal - 0.001f);
+		EXPECT_LE(total_cost(p), optimal * 1.1f + 0.001f);
+	}
+
+	// Paths that stay inside the clusters of their start and end points are the shortest paths
+	EXPECT_NEAR(total_cost(planned.back()), total_cost(shortest.back()), 0.001f);
+
+	// FindPath uses the hierarchy as well, and the hierarchy can be removed again
+	const Path across = FindPath(hierarchical.get(), id(0, 0), id(39, 0));
+	ASSERT_GE(across.size(), 2);
+	EXPECT_LE(total_cost(across), total_cost(FindPath(dijkstra.get(), id(0, 0), id(39, 0))) * 1.1f);
+	EnablePathHierarchy(g, 0);
+	EXPECT_EQ(nullptr, g.GetPathHierarchy());
+	EXPECT_EQ(nullptr, CreateBoostGraph(g)->hierarchy);
+
+	// Hierarchies are only kept for the cost type they were built for, and are discarded once an edge changes
+	EnablePathHierarchy(g, 8.0f);
+	EXPECT_NE(nullptr, g.GetPathHierarchy("Distance"));
+	EXPECT_THROW(EnablePathHierarchy(g, 8.0f, "NotACost"), HF::Exceptions::NoCost);
+	g.addEdge(id(0, 0), id(1, 0), 5.0f);
+	EXPECT_EQ(nullptr, g.GetPathHierarchy());
+}
+
 TEST(_pathFinding, MakePathArray) {
 	// be sure to #include "path_finder.h", #include "boost_graph.h", and #include "graph.h"
 
@@ -1089,6 +1166,62 @@ namespace CInterfaceTests {
 		//! [snippet_pathfinder_C_CreatePaths]
 	}
 
+	TEST(C_Pathfinder, BuildPathHierarchy) {
+		using HF::SpatialStructures::Graph;
+		using HF::SpatialStructures::Node;
+		using HF::SpatialStructures::Path;
+		using HF::SpatialStructures::PathMember;
+
+		// Create a 30x30 grid
+		const int size = 30;
+		Graph g;
+		for (int x = 0; x < size; x++)
+			for (int y = 0; y < size; y++) {
+				if (x + 1 < size) g.addEdge(Node(x, y, 0), Node(x + 1, y, 0), 1.0f);
+				if (x > 0) g.addEdge(Node(x, y, 0), Node(x - 1, y, 0), 1.0f);
+				if (y + 1 < size) g.addEdge(Node(x, y, 0), Node(x, y + 1, 0), 1.0f);
+				if (y > 0) g.addEdge(Node(x, y, 0), Node(x, y - 1, 0), 1.0f);
+			}
+		g.Compress();
+		const int start = g.getID(Node(0, 0, 0));
+		const int end = g.getID(Node(size - 1, size - 1, 0));
+
+		// Invalid sizes and costs are rejected without storing a hierarchy
+		EXPECT_EQ(HF::Exceptions::HF_STATUS::OUT_OF_RANGE, BuildPathHierarchy(&g, -1.0f, ""));
+		EXPECT_EQ(HF::Exceptions::HF_STATUS::NO_COST, BuildPathHierarchy(&g, 8.0f, "NotACost"));
+		EXPECT_EQ(nullptr, g.GetPathHierarchy());
+
+		// Once built, the hierarchy is stored in the graph
+		ASSERT_EQ(HF::Exceptions::HF_STATUS::OK, BuildPathHierarchy(&g, 8.0f, ""));
+		const auto hierarchy = g.GetPathHierarchy();
+		ASSERT_NE(nullptr, hierarchy);
+		const Path expected = hierarchy->FindPath(start, end);
+		ASSERT_GE(expected.size(), 2);
+
+		// CreatePath and CreatePaths should both plan their paths on it
+		int out_size = 0;
+		Path* out_path = nullptr;
+		PathMember* out_data = nullptr;
+		ASSERT_EQ(HF::Exceptions::HF_STATUS::OK, CreatePath(&g, start, end, "", &out_size, &out_path, &out_data));
+		EXPECT_EQ(expected, *out_path);
+		DestroyPath(out_path);
+
+		std::array<int, 2> starts{ start, end };
+		std::array<int, 2> ends{ end, start };
+		std::array<Path*, 2> out_paths;
+		std::array<PathMember*, 2> out_members;
+		std::array<int, 2> out_sizes;
+		ASSERT_EQ(HF::Exceptions::HF_STATUS::OK, CreatePaths(&g, starts.data(), ends.data(), "", out_paths.data(), out_members.data(), out_sizes.data(), 2));
+		EXPECT_EQ(expected, *out_paths[0]);
+		EXPECT_EQ(hierarchy->FindPath(end, start), *out_paths[1]);
+		for (auto& p : out_paths)
+			DestroyPath(p);
+
+		// Removing the hierarchy searches the whole graph again
+		ASSERT_EQ(HF::Exceptions::HF_STATUS::OK, BuildPathHierarchy(&g, 0, ""));
+		EXPECT_EQ(nullptr, g.GetPathHierarchy());
+	}
+
 	TEST(C_Pathfinder, CreatePathCostType) {
 		//! [snippet_pathfinder_C_CreatePathCostType]
 		// be sure to #include "boost_graph.h", #include "node.h", #include "graph.h", and #include <vector>
@@ -533,6 +533,35 @@ TEST(_Graph, AlternateCSR) {
 	ASSERT_FALSE(std::equal(stand_values.begin(), stand_values.end(), alt_values.begin()));
 }
 
+TEST(_Graph, ConstructFromCSR) {
+	vector<Node> nodes = { Node(1, 1, 2), Node(2, 3, 4), Node(11, 22, 140) };
+
+	// Row 0 is deliberately out of order
+	vector<int> outer_indices = { 0, 2, 3, 4 };
+	vector<int> inner_indices = { 2, 1, 2, 1 };
+	vector<float> data = { 2.5f, 1.0f, 54.0f, 39.0f };
+
+	Graph g(nodes, std::move(outer_indices), std::move(inner_indices), std::move(data));
+
+	// The graph is already compressed, and nodes have the IDs of their indexes
+	auto csr = g.GetCSRPointers();
+	ASSERT_EQ(4, csr.nnz);
+	ASSERT_EQ(1, csr.inner_indices[0]);
+	ASSERT_EQ(2, csr.inner_indices[1]);
+	ASSERT_EQ(2, g.getID(nodes[2]));
+
+	EXPECT_EQ(1.0f, g.GetCost(0, 1));
+	EXPECT_EQ(2.5f, g.GetCost(0, 2));
+	EXPECT_EQ(54.0f, g.GetCost(1, 2));
+	EXPECT_EQ(39.0f, g.GetCost(2, 1));
+	EXPECT_FALSE(g.HasEdge(1, 0));
+
+	// New edges can still be added afterwards
+	g.addEdge(nodes[1], Node(5, 5, 5), 3.0f);
+	EXPECT_TRUE(g.HasEdge(1, 3));
+	EXPECT_EQ(4, g.size());
+}
+
 const string test_attribute = "test_attr";
 const vector<Node> test_param_nodes = {
 		{1,1,1}, {2,2,2}, {3,3,3},{4,4,4}, {5,5,5}
@@ -763,6 +792,55 @@ TEST(_Node, Hashing) {
 }
 */
 
+TEST(_NodeLattice, KeyRoundsToNearestStep) {
+	NodeLattice lattice({ 0, 0, 0.25 }, { 0.5, 0.5, 0.0001 });
+
+	// Float noise from repeated offsets lands on the same key
+	LatticeKey k1 = lattice.Key(1.0f, 1.5f, 0.25f);
+	LatticeKey k2 = lattice.Key(0.1f + 0.2f + 0.7f, 1.49999f, 0.25003f);
+	ASSERT_EQ(k1, k2);
+
+	// A full step in any direction doesn't
+	ASSERT_NE(k1, lattice.Key(1.5f, 1.5f, 0.25f));
+	ASSERT_NE(k1, lattice.Key(1.0f, 1.5f, 0.2502f));
+	ASSERT_EQ(std::hash<LatticeKey>()(k1), std::hash<LatticeKey>()(k2));
+}
+
+TEST(_NodeLattice, EdgeKeyIsUnordered) {
+	LatticeKey k1{ 1, 2, 3 };
+	LatticeKey k2{ 1, 3, -4 };
+
+	ASSERT_EQ(LatticeEdgeKey(k1, k2), LatticeEdgeKey(k2, k1));
+	ASSERT_EQ(std::hash<LatticeEdgeKey>()(LatticeEdgeKey(k1, k2)), std::hash<LatticeEdgeKey>()(LatticeEdgeKey(k2, k1)));
+	ASSERT_NE(LatticeEdgeKey(k1, k2), LatticeEdgeKey(k1, k1));
+}
+
+TEST(_NodeLattice, MortonCodeInterleavesXAndY) {
+	const LatticeKey origin{ 0, 0, 0 }, x1{ 1, 0, 0 }, y1{ 0, 1, 0 }, xy1{ 1, 1, 0 }, x2{ 2, 0, 0 };
+
+	// Bits of x fill the even positions and bits of y fill the odd ones
+	ASSERT_EQ(x1.MortonCode() - origin.MortonCode(), 1);
+	ASSERT_EQ(y1.MortonCode() - origin.MortonCode(), 2);
+	ASSERT_EQ(xy1.MortonCode() - origin.MortonCode(), 3);
+	ASSERT_EQ(x2.MortonCode() - origin.MortonCode(), 4);
+
+	// The z coordinate is ignored, and negative keys come before positive ones
+	const LatticeKey low{ 3, 5, -7 }, high{ 3, 5, 9 }, negative{ -1, -1, 0 };
+	ASSERT_EQ(low.MortonCode(), high.MortonCode());
+	ASSERT_LT(negative.MortonCode(), origin.MortonCode());
+}
+
+TEST(_Graph, LookupToleratesFloatNoise) {
+	Graph g;
+	Node N1(1.0f, 2.0f, 3.0f);
+	Node N2(4.0f, 5.0f, 6.0f);
+	g.addEdge(N1, N2, 1);
+	g.Compress();
+
+	ASSERT_TRUE(g.hasKey(Node(1.00002f, 2.0f, 2.99998f)));
+	ASSERT_EQ(g.getID(Node(3.99998f, 5.0f, 6.0f)), g.getID(N2));
+}
+
 
 namespace NodeTests {
     TEST(_Node, Distance) {
@@ -4,6 +4,7 @@
 #include <objloader.h>
 #include <meshinfo.h>
 #include <embree_raytracer.h>
+#include <ray_batch.h>
 #include <robin_hood.h>
 #include <cmath>
 #include <iostream>
@@ -441,6 +442,619 @@ TEST(_EmbreeRayTracer, Occlusions) {
 }
 
 
+TEST(_EmbreeRayTracer, PacketIntersections) {
+	// Create Plane
+	const std::vector<float> plane_vertices{
+		-10.0f, 10.0f, 0.0f,
+		-10.0f, -10.0f, 0.0f,
+		10.0f, 10.0f, 0.0f,
+		10.0f, -10.0f, 0.0f,
+	};
+	const std::vector<int> plane_indices{ 3, 1, 0, 2, 3, 0 };
+
+	// Create RayTracer
+	EmbreeRayTracer ert(vector<MeshInfo<float>>{MeshInfo<float>(plane_vertices, plane_indices, 0, " ")});
+
+	// Create more rays than fit in a single packet. Every other ray starts under the plane
+	// and should miss.
+	std::vector<std::array<double, 3>> directions(20, std::array<double, 3>{0, 0, -1});
+	std::vector<std::array<double, 3>> origins(20);
+	for (int i = 0; i < 20; i++)
+		origins[i] = std::array<double, 3>{ i * 0.5 - 5.0, 1.0, (i % 2 == 0) ? 1.0 + i : -1.0 };
+
+	// Cast every ray
+	auto results = ert.PacketIntersections<double>(origins, directions);
+
+	// Ensure the results match casting every ray individually
+	ASSERT_EQ(origins.size(), results.size());
+	for (int i = 0; i < 20; i++) {
+		auto expected = ert.Intersect<double>(origins[i], directions[i]);
+		ASSERT_EQ(expected.DidHit(), results[i].DidHit());
+		ASSERT_EQ(i % 2 == 0, results[i].DidHit());
+
+		if (expected.DidHit()) {
+			EXPECT_EQ(expected.meshid, results[i].meshid);
+			EXPECT_EQ(expected.distance, results[i].distance);
+		}
+	}
+}
+
+TEST(_EmbreeRayTracer, SurfaceIntersections) {
+	// Create a ramp that rises along the x axis at 45 degrees
+	const std::vector<float> ramp_vertices{
+		-10.0f, 10.0f, -10.0f,
+		-10.0f, -10.0f, -10.0f,
+		10.0f, 10.0f, 10.0f,
+		10.0f, -10.0f, 10.0f,
+	};
+	const std::vector<int> ramp_indices{ 3, 1, 0, 2, 3, 0 };
+
+	// Create RayTracer, and mark the second triangle of the ramp
+	EmbreeRayTracer ert(vector<MeshInfo<float>>{MeshInfo<float>(ramp_vertices, ramp_indices, 0, " ")});
+	const std::vector<int> attributes{ 0, 7 };
+	EXPECT_TRUE(ert.SetTriangleAttributes(0, attributes));
+	EXPECT_FALSE(ert.SetTriangleAttributes(5, attributes));
+
+	// Cast rays down onto both triangles, and one ray that misses
+	std::vector<std::array<double, 3>> origins{ {-3, -3, 20}, {3, 3, 20}, {-1, -2, 20}, {50, 0, 20} };
+	std::vector<std::array<double, 3>> directions(origins.size(), std::array<double, 3>{0, 0, -1});
+	auto results = ert.SurfaceIntersections<double>(origins, directions);
+	ASSERT_EQ(origins.size(), results.size());
+
+	for (int i = 0; i < origins.size(); i++) {
+		const auto expected = ert.IntersectSurface<double>(origins[i], directions[i]);
+		const auto& result = results[i];
+		ASSERT_EQ(expected.DidHit(), result.DidHit());
+		EXPECT_EQ(expected.distance, result.distance);
+		EXPECT_EQ(expected.primid, result.primid);
+		if (!result.DidHit()) {
+			EXPECT_EQ(-1, result.primid);
+			continue;
+		}
+
+		// The normal follows the winding of the hit triangle, and is tilted 45 degrees from the z axis
+		const int* tri = &ramp_indices[3 * result.primid];
+		auto vertex = [&ramp_vertices](int index, int axis) { return ramp_vertices[3 * index + axis]; };
+		std::array<double, 3> e1, e2;
+		for (int axis = 0; axis < 3; axis++) {
+			e1[axis] = vertex(tri[1], axis) - vertex(tri[0], axis);
+			e2[axis] = vertex(tri[2], axis) - vertex(tri[0], axis);
+		}
+		const std::array<double, 3> cross{ e1[1] * e2[2] - e1[2] * e2[1], e1[2] * e2[0] - e1[0] * e2[2], e1[0] * e2[1] - e1[1] * e2[0] };
+		const double length = std::sqrt(cross[0] * cross[0] + cross[1] * cross[1] + cross[2] * cross[2]);
+		for (int axis = 0; axis < 3; axis++)
+			EXPECT_NEAR(cross[axis] / length, result.normal[axis], 0.0001);
+		EXPECT_NEAR(std::sqrt(0.5), std::abs(result.normal[2]), 0.0001);
+
+		// The barycentric coordinates give the point where the ray hit
+		for (int axis = 0; axis < 3; axis++) {
+			const double hit = origins[i][axis] + directions[i][axis] * result.distance;
+			const double interpolated = (1 - result.u - result.v) * vertex(tri[0], axis)
+				+ result.u * vertex(tri[1], axis) + result.v * vertex(tri[2], axis);
+			EXPECT_NEAR(hit, interpolated, 0.001);
+		}
+
+		EXPECT_EQ(attributes[result.primid], result.attribute);
+	}
+	EXPECT_EQ(0, results[0].attribute);
+	EXPECT_EQ(7, results[1].attribute);
+
+	// Copies share the attributes, and removing them resets every attribute to 0
+	EmbreeRayTracer copy(ert);
+	EXPECT_EQ(7, copy.TriangleAttribute(0, 1));
+	EXPECT_TRUE(ert.SetTriangleAttributes(0, {}));
+	EXPECT_EQ(0, ert.IntersectSurface<double>(origins[1], directions[1]).attribute);
+}
+
+TEST(_EmbreeRayTracer, RayBatches) {
+	// Create Plane
+	const std::vector<float> plane_vertices{
+		-10.0f, 10.0f, 0.0f,
+		-10.0f, -10.0f, 0.0f,
+		10.0f, 10.0f, 0.0f,
+		10.0f, -10.0f, 0.0f,
+	};
+	const std::vector<int> plane_indices{ 3, 1, 0, 2, 3, 0 };
+	EmbreeRayTracer ert(vector<MeshInfo<float>>{MeshInfo<float>(plane_vertices, plane_indices, 0, " ")});
+
+	// Create more rays than fit in a single chunk. Every other ray starts under the plane and
+	// misses, and every third ray is too short to reach the plane.
+	const int n = 2500;
+	RayBatch batch(n);
+	for (int i = 0; i < n; i++) {
+		const float x = -9.0f + 18.0f * i / n;
+		batch.SetRay(i, x, 1.0f, (i % 2 == 0) ? 1.0f + (i % 7) : -1.0f, 0, 0, -1, (i % 3 == 0) ? 0.5f : -1);
+	}
+	ert.IntersectBatch(batch);
+	ert.OccludedBatch(batch);
+
+	// Ensure the results match casting every ray individually
+	for (int i = 0; i < n; i++) {
+		const std::array<float, 3> origin{ batch.org_x[i], batch.org_y[i], batch.org_z[i] };
+		const std::array<float, 3> direction{ 0, 0, -1 };
+		const bool expected = (i % 2 == 0) && (i % 3 != 0);
+
+		ASSERT_EQ(expected, batch.meshid[i] >= 0);
+		ASSERT_EQ(expected, static_cast<bool>(batch.occluded[i]));
+		ASSERT_EQ(expected, ert.Occluded(origin, direction, batch.tfar[i]));
+		if (expected)
+			EXPECT_EQ(ert.Intersect<float>(origin, direction).distance, batch.distance[i]);
+		else
+			EXPECT_EQ(-1, batch.distance[i]);
+	}
+
+	// A single origin or direction is used for every ray
+	const std::vector<float> origins{ 0, 0, 1 };
+	const std::vector<float> directions{ 0, 0, -1, 0, 0, 1, std::sqrt(0.5f), 0, -std::sqrt(0.5f) };
+	RayBatch one_origin(origins.data(), 1, directions.data(), 3);
+	ert.IntersectBatch(one_origin, false);
+	ASSERT_EQ(3, one_origin.size());
+	EXPECT_NEAR(1.0f, one_origin.distance[0], 0.0001f);
+	EXPECT_EQ(-1, one_origin.meshid[1]);
+	EXPECT_NEAR(std::sqrt(2.0f), one_origin.distance[2], 0.0001f);
+
+	EXPECT_THROW(RayBatch(directions.data(), 3, directions.data(), 2), std::invalid_argument);
+	EXPECT_THROW(RayBatch(origins.data(), 1, directions.data(), 0), std::invalid_argument);
+}
+
+TEST(_EmbreeRayTracer, MaxDistanceAndMeshID) {
+	// Create two planes, one 1 unit under the origin and one 5 units under it
+	auto plane = [](float height) {
+		return std::vector<float>{
+			-10.0f, 10.0f, height,
+			-10.0f, -10.0f, height,
+			10.0f, 10.0f, height,
+			10.0f, -10.0f, height,
+		};
+	};
+	const std::vector<int> plane_indices{ 3, 1, 0, 2, 3, 0 };
+	EmbreeRayTracer ert(vector<MeshInfo<float>>{
+		MeshInfo<float>(plane(-1.0f), plane_indices, 5, "Near"),
+		MeshInfo<float>(plane(-5.0f), plane_indices, 9, "Far")
+	});
+
+	const std::array<float, 3> origin{ 0, 0, 0 };
+	const std::array<float, 3> down{ 0, 0, -1 };
+
+	// Without a mesh ID, the nearest plane is hit unless it's beyond the max distance
+	auto hit = ert.Intersect<float>(origin, down);
+	EXPECT_NEAR(1.0f, hit.distance, 0.0001f);
+	EXPECT_FALSE(ert.Intersect<float>(origin, down, 0.5f).DidHit());
+
+	// With a mesh ID, rays pass through every other mesh
+	hit = ert.Intersect<float>(origin, down, -1.0f, 9);
+	EXPECT_EQ(9, hit.meshid);
+	EXPECT_NEAR(5.0f, hit.distance, 0.0001f);
+	EXPECT_FALSE(ert.Intersect<float>(origin, down, 3.0f, 9).DidHit());
+	EXPECT_FALSE(ert.Intersect<float>(origin, down, -1.0f, 100).DidHit());
+
+	// Occlusion rays follow the same rules
+	EXPECT_TRUE(ert.Occluded(origin, down));
+	EXPECT_FALSE(ert.Occluded(origin, down, 0.5f));
+	EXPECT_TRUE(ert.Occluded(origin, down, -1.0f, 9));
+	EXPECT_FALSE(ert.Occluded(origin, down, 3.0f, 9));
+	EXPECT_FALSE(ert.Occluded(origin, down, -1.0f, 100));
+}
+
+TEST(_EmbreeRayTracer, SharedDeviceAndBuildOptions) {
+	// Every request for the device returns the same device until its options change
+	RTCDevice first = AcquireDevice();
+	RTCDevice second = AcquireDevice();
+	EXPECT_EQ(first, second);
+
+	const DeviceOptions default_options = GetDeviceOptions();
+	DeviceOptions options;
+	options.num_threads = 2;
+	options.set_affinity = true;
+	EXPECT_EQ("threads=2,set_affinity=1", options.ConfigString());
+	EXPECT_EQ("", DeviceOptions().ConfigString());
+	EXPECT_THROW(SetDeviceOptions(DeviceOptions{ -1, false }), std::out_of_range);
+
+	// Devices that were already acquired stay alive after the shared device is replaced
+	SetDeviceOptions(options);
+	RTCDevice configured = AcquireDevice();
+	EXPECT_NE(first, configured);
+	rtcReleaseDevice(configured);
+	rtcReleaseDevice(second);
+	rtcReleaseDevice(first);
+	SetDeviceOptions(default_options);
+
+	// Create Plane
+	const std::vector<float> plane_vertices{
+		-10.0f, 10.0f, 0.0f,
+		-10.0f, -10.0f, 0.0f,
+		10.0f, 10.0f, 0.0f,
+		10.0f, -10.0f, 0.0f,
+	};
+	const std::vector<int> plane_indices{ 3, 1, 0, 2, 3, 0 };
+	const std::array<float, 3> origin{ 1, 2, 3 };
+	const std::array<float, 3> down{ 0, 0, -1 };
+
+	// Every build profile produces the same results
+	for (auto quality : { BuildQuality::LOW, BuildQuality::MEDIUM, BuildQuality::HIGH }) {
+		BuildOptions build_options;
+		build_options.quality = quality;
+		build_options.compact = quality == BuildQuality::LOW;
+		build_options.dynamic = quality == BuildQuality::MEDIUM;
+
+		MeshInfo<float> plane(plane_vertices, plane_indices, 0, " ");
+		EmbreeRayTracer ert(plane, false, build_options);
+		EXPECT_EQ(quality, ert.GetBuildOptions().quality);
+		EXPECT_NEAR(3.0f, ert.Intersect<float>(origin, down).distance, 0.0001f);
+
+		// Copies and subsets keep the options of their source
+		EXPECT_EQ(build_options.compact, ert.Subset({ 0 }).GetBuildOptions().compact);
+
+		// Rebuilding with different options keeps the same geometry
+		ert.SetBuildOptions(BuildOptions());
+		EXPECT_EQ(BuildQuality::HIGH, ert.GetBuildOptions().quality);
+		EXPECT_NEAR(3.0f, ert.Intersect<float>(origin, down).distance, 0.0001f);
+	}
+}
+
+TEST(_EmbreeRayTracer, Instancing) {
+	// Create a plane to use as a prototype
+	const std::vector<float> plane_vertices{
+		-10.0f, 10.0f, 0.0f,
+		-10.0f, -10.0f, 0.0f,
+		10.0f, 10.0f, 0.0f,
+		10.0f, -10.0f, 0.0f,
+	};
+	const std::vector<int> plane_indices{ 3, 1, 0, 2, 3, 0 };
+	MeshInfo<float> plane(plane_vertices, plane_indices, 0, " ");
+
+	// Create a raytracer with a single mesh far from the instances. This constructor always
+	// uses precise intersections.
+	auto far_vertices = plane_vertices;
+	for (int i = 2; i < far_vertices.size(); i += 3) far_vertices[i] = -1000.0f;
+	EmbreeRayTracer ert(vector<MeshInfo<float>>{MeshInfo<float>(far_vertices, plane_indices, 0, " ")});
+
+	// Place the plane 2 units down, and stood up 3 units along the y axis at x = 50
+	const int prototype = ert.AddPrototype(plane);
+	EXPECT_EQ(1, ert.NumPrototypes());
+	const int moved = ert.AddInstance(prototype, { 1, 0, 0, 0, 1, 0, 0, 0, 1, 0, 0, -2 }, 20);
+	const int rotated = ert.AddInstance(prototype, { 1, 0, 0, 0, 0, 1, 0, -1, 0, 50, 3, 0 }, 21);
+	EXPECT_NE(moved, rotated);
+	EXPECT_THROW(ert.AddInstance(5, { 1, 0, 0, 0, 1, 0, 0, 0, 1, 0, 0, 0 }), std::out_of_range);
+
+	// Hits on instances report the ID of the instance
+	const std::array<float, 3> down{ 0, 0, -1 };
+	auto hit = ert.IntersectSurface<float>(std::array<float, 3>{ 1, 1, 0 }, down);
+	EXPECT_EQ(moved, hit.meshid);
+	EXPECT_NEAR(2.0f, hit.distance, 0.0001f);
+	EXPECT_EQ(hit.meshid, ert.Intersect<float>(std::array<float, 3>{ 1, 1, 0 }, down, -1.0f, moved).meshid);
+	EXPECT_FALSE(ert.Intersect<float>(std::array<float, 3>{ 1, 1, 0 }, down, -1.0f, rotated).DidHit());
+
+	// Normals are rotated with their instance
+	EmbreeRayTracer prototype_ert(plane);
+	const auto prototype_hit = prototype_ert.IntersectSurface<float>(std::array<float, 3>{ 1, 1, 5 }, down);
+	const std::array<float, 3> north{ 0, 1, 0 };
+	auto rotated_hit = ert.IntersectSurface<float>(std::array<float, 3>{ 51, 0, 1 }, north);
+	EXPECT_EQ(rotated, rotated_hit.meshid);
+	EXPECT_NEAR(3.0f, rotated_hit.distance, 0.0001f);
+	EXPECT_NEAR(-prototype_hit.normal[2], rotated_hit.normal[1], 0.0001f);
+	EXPECT_NEAR(0.0f, rotated_hit.normal[2], 0.0001f);
+
+	// Every way of casting rays agrees
+	std::vector<std::array<float, 3>> origins{ { 1, 1, 0 }, { 51, 0, 1 } };
+	std::vector<std::array<float, 3>> directions{ down, north };
+	auto packet_hits = ert.PacketIntersections<float>(origins, directions);
+	RayBatch batch(origins[0].data(), 1, down.data(), 1);
+	ert.IntersectBatch(batch);
+	EXPECT_EQ(moved, packet_hits[0].meshid);
+	EXPECT_EQ(rotated, packet_hits[1].meshid);
+	EXPECT_EQ(moved, batch.meshid[0]);
+	EXPECT_NEAR(2.0f, batch.distance[0], 0.0001f);
+
+	// Meshes that are moved copies of each other share a prototype, and give the same results as
+	// adding every mesh separately
+	auto shifted = [&plane_vertices](float dx, float dz) {
+		auto vertices = plane_vertices;
+		for (int i = 0; i < vertices.size(); i += 3) {
+			vertices[i] += dx;
+			vertices[i + 2] += dz;
+		}
+		return vertices;
+	};
+	const std::vector<int> triangle_indices{ 0, 1, 2 };
+	std::vector<MeshInfo<float>> meshes{
+		MeshInfo<float>(shifted(0, -1), plane_indices, 30, " "),
+		MeshInfo<float>(shifted(100, -3), plane_indices, 31, " "),
+		MeshInfo<float>(std::vector<float>{ 200, 0, -1, 210, 0, -1, 200, 10, -1 }, triangle_indices, 32, " "),
+		MeshInfo<float>(shifted(300, -7), plane_indices, 33, " "),
+	};
+	auto separate_meshes = meshes;
+
+	EmbreeRayTracer instanced;
+	instanced.AddInstancedMeshes(meshes);
+	EmbreeRayTracer separate;
+	separate.AddMesh(separate_meshes);
+	EXPECT_EQ(1, instanced.NumPrototypes());
+
+	for (int i = 0; i < meshes.size(); i++) {
+		EXPECT_EQ(separate_meshes[i].meshid, meshes[i].meshid);
+		const std::array<float, 3> origin{ 100.0f * i + 1.0f, 1.0f, 0.0f };
+		const auto expected = separate.Intersect<float>(origin, down);
+		const auto result = instanced.Intersect<float>(origin, down);
+		ASSERT_TRUE(result.DidHit());
+		EXPECT_EQ(expected.meshid, result.meshid);
+		EXPECT_NEAR(expected.distance, result.distance, 0.0001f);
+	}
+}
+
+TEST(_EmbreeRayTracer, DynamicUpdates) {
+	// Create two planes, one 1 unit under the origin and one 5 units under it
+	auto plane = [](float height) {
+		return std::vector<float>{
+			-10.0f, 10.0f, height,
+			-10.0f, -10.0f, height,
+			10.0f, 10.0f, height,
+			10.0f, -10.0f, height,
+		};
+	};
+	const std::vector<int> plane_indices{ 3, 1, 0, 2, 3, 0 };
+	std::vector<MeshInfo<float>> meshes{
+		MeshInfo<float>(plane(-1.0f), plane_indices, 5, "Near"),
+		MeshInfo<float>(plane(-5.0f), plane_indices, 9, "Far")
+	};
+
+	BuildOptions options;
+	options.dynamic = true;
+	EmbreeRayTracer ert(meshes, false, options);
+	const int near_id = meshes[0].meshid;
+	const int far_id = meshes[1].meshid;
+
+	const std::array<float, 3> origin{ 0, 0, 0 };
+	const std::array<float, 3> down{ 0, 0, -1 };
+	EXPECT_NEAR(1.0f, ert.Intersect<float>(origin, down).distance, 0.0001f);
+
+	// Move the near plane further down than the far plane
+	EXPECT_TRUE(ert.UpdateMesh(near_id, plane(-7.0f)));
+	auto hit = ert.Intersect<float>(origin, down);
+	EXPECT_EQ(far_id, hit.meshid);
+	EXPECT_NEAR(5.0f, hit.distance, 0.0001f);
+	EXPECT_THROW(ert.UpdateMesh(near_id, { 0, 0, 0 }), std::invalid_argument);
+	EXPECT_FALSE(ert.UpdateMesh(100, plane(0.0f)));
+
+	// Lift the far plane with a transform. It keeps its ID.
+	const std::array<float, 12> lift{ 1, 0, 0, 0, 1, 0, 0, 0, 1, 0, 0, 3 };
+	EXPECT_TRUE(ert.SetMeshTransform(far_id, lift));
+	hit = ert.Intersect<float>(origin, down);
+	EXPECT_EQ(far_id, hit.meshid);
+	EXPECT_NEAR(2.0f, hit.distance, 0.0001f);
+
+	// Transforming it again replaces the transform. Edited vertices are placed where they're given,
+	// regardless of the transform.
+	const std::array<float, 12> lower{ 1, 0, 0, 0, 1, 0, 0, 0, 1, 0, 0, -1 };
+	EXPECT_TRUE(ert.SetMeshTransform(far_id, lower));
+	EXPECT_NEAR(6.0f, ert.Intersect<float>(origin, down).distance, 0.0001f);
+	EXPECT_TRUE(ert.UpdateMesh(far_id, plane(-2.0f)));
+	hit = ert.Intersect<float>(origin, down);
+	EXPECT_EQ(far_id, hit.meshid);
+	EXPECT_NEAR(2.0f, hit.distance, 0.0001f);
+
+	// Removing the far plane leaves only the near plane
+	EXPECT_TRUE(ert.RemoveMesh(far_id));
+	EXPECT_FALSE(ert.RemoveMesh(far_id));
+	EXPECT_FALSE(ert.SetMeshTransform(far_id, lift));
+	hit = ert.Intersect<float>(origin, down);
+	EXPECT_EQ(near_id, hit.meshid);
+	EXPECT_NEAR(7.0f, hit.distance, 0.0001f);
+
+	// Place two copies of a plane side by side, 10 units under the origin and at x = 100
+	const int prototype = ert.AddPrototype(MeshInfo<float>(plane(0.0f), plane_indices, 0, "Copy"));
+	const int first_copy = ert.AddInstance(prototype, { 1, 0, 0, 0, 1, 0, 0, 0, 1, 0, 0, -10 });
+	const int second_copy = ert.AddInstance(prototype, { 1, 0, 0, 0, 1, 0, 0, 0, 1, 100, 0, -10 });
+	const std::array<float, 3> beside{ 100, 0, 0 };
+	EXPECT_NEAR(10.0f, ert.Intersect<float>(beside, down).distance, 0.0001f);
+
+	// Raising the second copy gives it a prototype of its own, so the first copy stays where it is
+	std::vector<float> raised = plane(-4.0f);
+	for (int i = 0; i < raised.size(); i += 3) raised[i] += 100;
+	EXPECT_TRUE(ert.UpdateMesh(second_copy, raised));
+	hit = ert.Intersect<float>(beside, down);
+	EXPECT_EQ(second_copy, hit.meshid);
+	EXPECT_NEAR(4.0f, hit.distance, 0.0001f);
+	hit = ert.Intersect<float>(std::array<float, 3>{ 0, 0, -8 }, down);
+	EXPECT_EQ(first_copy, hit.meshid);
+	EXPECT_NEAR(2.0f, hit.distance, 0.0001f);
+}
+
+TEST(_EmbreeRayTracer, CopiesShareEdits) {
+	auto plane = [](float height) {
+		return std::vector<float>{
+			-10.0f, 10.0f, height,
+			-10.0f, -10.0f, height,
+			10.0f, 10.0f, height,
+			10.0f, -10.0f, height,
+		};
+	};
+	const std::vector<int> plane_indices{ 3, 1, 0, 2, 3, 0 };
+	std::vector<MeshInfo<float>> meshes{
+		MeshInfo<float>(plane(-1.0f), plane_indices, 0, "Near"),
+		MeshInfo<float>(plane(-5.0f), plane_indices, 1, "Far")
+	};
+	EmbreeRayTracer ert(meshes);
+	const int near_id = meshes[0].meshid;
+	const int far_id = meshes[1].meshid;
+
+	EmbreeRayTracer copy(ert);
+	const EmbreeRayTracer subset = ert.Subset({ far_id });
+	const unsigned int version = ert.SceneVersion();
+	EXPECT_EQ(version, copy.SceneVersion());
+
+	// Meshes removed through the original are gone from the copy too
+	EXPECT_TRUE(ert.RemoveMesh(near_id));
+	EXPECT_FALSE(copy.RemoveMesh(near_id));
+	EXPECT_FALSE(copy.UpdateMesh(near_id, plane(0.0f)));
+	EXPECT_NE(version, copy.SceneVersion());
+	EXPECT_EQ(copy.SceneVersion(), ert.SceneVersion());
+
+	// Edits made through the copy are seen by the original
+	EXPECT_TRUE(copy.UpdateMesh(far_id, plane(-3.0f)));
+	EXPECT_NEAR(3.0f, ert.Intersect<float>(std::array<float, 3>{ 0, 0, 0 }, std::array<float, 3>{ 0, 0, -1 }).distance, 0.0001f);
+
+	// Subsets keep a version of their own
+	EXPECT_NE(ert.SceneVersion(), subset.SceneVersion());
+}
+
+TEST(_EmbreeRayTracer, SharedBuffersOutliveMeshes) {
+	const std::array<float, 3> origin{ 1, 2, 3 };
+	const std::array<float, 3> down{ 0, 0, -1 };
+
+	// Create a raytracer from a mesh that's destroyed right after
+	std::unique_ptr<EmbreeRayTracer> ert;
+	{
+		const std::vector<float> plane_vertices{
+			-10.0f, 10.0f, 0.0f,
+			-10.0f, -10.0f, 0.0f,
+			10.0f, 10.0f, 0.0f,
+			10.0f, -10.0f, 0.0f,
+		};
+		const std::vector<int> plane_indices{ 3, 1, 0, 2, 3, 0 };
+		MeshInfo<float> plane(plane_vertices, plane_indices, 0, " ");
+		ert = std::make_unique<EmbreeRayTracer>(plane);
+	}
+	EXPECT_NEAR(3.0f, ert->Intersect<float>(origin, down).distance, 0.0001f);
+
+	// Copies keep the buffers alive after the original is destroyed
+	EmbreeRayTracer copy(*ert);
+	ert.reset();
+	EXPECT_NEAR(3.0f, copy.Intersect<float>(origin, down).distance, 0.0001f);
+	EXPECT_EQ(-1, copy.IntersectSurface<float>(std::array<float, 3>{ 50, 0, 3 }, down).primid);
+}
+
+TEST(_EmbreeRayTracer, IntersectAll) {
+	// Create three stacked planes, 1, 3 and 5 units under the origin
+	auto plane = [](float height) {
+		return std::vector<float>{
+			-10.0f, 10.0f, height,
+			-10.0f, -10.0f, height,
+			10.0f, 10.0f, height,
+			10.0f, -10.0f, height,
+		};
+	};
+	const std::vector<int> plane_indices{ 3, 1, 0, 2, 3, 0 };
+	EmbreeRayTracer ert(vector<MeshInfo<float>>{
+		MeshInfo<float>(plane(-5.0f), plane_indices, 0, "Bottom"),
+		MeshInfo<float>(plane(-1.0f), plane_indices, 1, "Top"),
+		MeshInfo<float>(plane(-3.0f), plane_indices, 2, "Middle")
+	});
+
+	const std::array<float, 3> origin{ 1, 2, 0 };
+	const std::array<float, 3> down{ 0, 0, -1 };
+
+	// Every plane is hit once, from nearest to farthest
+	auto hits = ert.IntersectAll<float>(origin, down, 10);
+	ASSERT_EQ(3, hits.size());
+	const std::array<int, 3> expected_meshes{ 1, 2, 0 };
+	const std::array<float, 3> expected_distances{ 1.0f, 3.0f, 5.0f };
+	for (int i = 0; i < 3; i++) {
+		EXPECT_EQ(expected_meshes[i], hits[i].meshid);
+		EXPECT_NEAR(expected_distances[i], hits[i].distance, 0.0001f);
+
+		// The first hit matches a normal surface intersection with the same mesh
+		const auto surface = ert.IntersectSurface<float>(origin, down, -1.0f, hits[i].meshid);
+		EXPECT_EQ(surface.primid, hits[i].primid);
+	}
+
+	// Only the closest hits within max_hits and max_distance are kept
+	hits = ert.IntersectAll<float>(origin, down, 2);
+	ASSERT_EQ(2, hits.size());
+	EXPECT_EQ(1, hits[0].meshid);
+	EXPECT_EQ(2, hits[1].meshid);
+	hits = ert.IntersectAll<float>(origin, down, 10, 4.0f);
+	ASSERT_EQ(2, hits.size());
+
+	// A mesh ID skips every other mesh, and rays that miss return nothing
+	hits = ert.IntersectAll<float>(origin, down, 10, -1.0f, 0);
+	ASSERT_EQ(1, hits.size());
+	EXPECT_NEAR(5.0f, hits[0].distance, 0.0001f);
+	EXPECT_TRUE(ert.IntersectAll<float>(origin, std::array<float, 3>{ 0, 0, 1 }, 10).empty());
+	EXPECT_TRUE(ert.IntersectAll<float>(origin, down, 0).empty());
+}
+
+TEST(_EmbreeRayTracer, ClosestPoint) {
+	// Create a floor, and stand an instance of it up along the y axis at x = 5 as a wall
+	const std::vector<float> plane_vertices{
+		-10.0f, 10.0f, 0.0f,
+		-10.0f, -10.0f, 0.0f,
+		10.0f, 10.0f, 0.0f,
+		10.0f, -10.0f, 0.0f,
+	};
+	const std::vector<int> plane_indices{ 3, 1, 0, 2, 3, 0 };
+	EmbreeRayTracer ert(vector<MeshInfo<float>>{MeshInfo<float>(plane_vertices, plane_indices, 0, "Floor")});
+	const int prototype = ert.AddPrototype(MeshInfo<float>(plane_vertices, plane_indices, 0, "Wall"));
+	const int wall = ert.AddInstance(prototype, { 0, 0, 1, 0, 1, 0, -1, 0, 0, 5, 0, 0 }, 7);
+
+	// The floor is the closest surface, right under the point
+	const std::array<float, 3> point{ 1, 2, 1 };
+	auto closest = ert.ClosestPoint<float>(point);
+	ASSERT_TRUE(closest.DidHit());
+	EXPECT_EQ(0, closest.meshid);
+	EXPECT_NEAR(1.0f, closest.distance, 0.0001f);
+	EXPECT_EQ(ert.IntersectSurface<float>(point, std::array<float, 3>{ 0, 0, -1 }).primid, closest.primid);
+	const std::array<float, 3> floor_point{ 1, 2, 0 };
+	for (int axis = 0; axis < 3; axis++)
+		EXPECT_NEAR(floor_point[axis], closest.point[axis], 0.0001f);
+
+	// Leaving out surfaces under the point, or every mesh but the wall, finds the wall instead
+	const std::array<float, 3> wall_point{ 5, 2, 1 };
+	for (const auto& result : { ert.ClosestPoint<float>(point, -1.0f, -1, 0.0f), ert.ClosestPoint<float>(point, -1.0f, wall) }) {
+		EXPECT_EQ(wall, result.meshid);
+		EXPECT_NEAR(4.0f, result.distance, 0.0001f);
+		for (int axis = 0; axis < 3; axis++)
+			EXPECT_NEAR(wall_point[axis], result.point[axis], 0.0001f);
+	}
+
+	// Nothing is found past the max distance
+	EXPECT_FALSE(ert.ClosestPoint<float>(point, 0.5f).DidHit());
+	EXPECT_FALSE(ert.ClosestPoint<float>(point, 3.0f, wall).DidHit());
+
+	// Batches match single queries
+	const std::vector<std::array<float, 3>> points{ { 1, 2, 1 }, { 4, -3, 3 }, { 40, 0, 0 } };
+	const auto results = ert.ClosestPoints<float>(points, 10.0f, -1, 0.0f);
+	ASSERT_EQ(points.size(), results.size());
+	for (int i = 0; i < points.size(); i++) {
+		const auto expected = ert.ClosestPoint<float>(points[i], 10.0f, -1, 0.0f);
+		EXPECT_EQ(expected.meshid, results[i].meshid);
+		EXPECT_EQ(expected.distance, results[i].distance);
+	}
+	EXPECT_NEAR(1.0f, results[1].distance, 0.0001f);
+	EXPECT_FALSE(results[2].DidHit());
+}
+
+TEST(_EmbreeRayTracer, PacketOcclusions) {
+	// Create Plane
+	const std::vector<float> plane_vertices{
+		-10.0f, 10.0f, 0.0f,
+		-10.0f, -10.0f, 0.0f,
+		10.0f, 10.0f, 0.0f,
+		10.0f, -10.0f, 0.0f,
+	};
+	const std::vector<int> plane_indices{ 3, 1, 0, 2, 3, 0 };
+
+	// Create RayTracer
+	EmbreeRayTracer ert(vector<MeshInfo<float>>{MeshInfo<float>(plane_vertices, plane_indices, 0, " ")});
+
+	// Cast rays from a height of 1 towards the plane, limiting every third ray
+	// to a distance that's too short to reach it.
+	std::vector<std::array<double, 3>> directions(20, std::array<double, 3>{0, 0, -1});
+	std::vector<std::array<double, 3>> origins(20);
+	std::vector<double> distances(20);
+	for (int i = 0; i < 20; i++) {
+		origins[i] = std::array<double, 3>{ i * 0.5 - 5.0, 1.0, 1.0 };
+		distances[i] = (i % 3 == 0) ? 0.5 : -1;
+	}
+
+	// Cast every ray
+	auto results = ert.PacketOcclusions(origins, directions, distances);
+
+	ASSERT_EQ(origins.size(), results.size());
+	for (int i = 0; i < 20; i++)
+		EXPECT_EQ(i % 3 != 0, static_cast<bool>(results[i]));
+}
+
 TEST(_EmbreeRayTracer, OcclusionMultiOrigin) {
 	// Create Plane
 
@@ -1105,6 +1719,26 @@ namespace C_Interface{
 		delete[] before_added_results;
 	}
 
+	// Ensure that batches of rays with no origins or no directions are rejected instead of read from
+	TEST(C_EmbreeRayTracer, EmptyRayBatchesAreRejected) {
+		EmbreeRayTracer* rt = ConstructTestRaytracer();
+		std::vector<float> origins = { 1,1,1 };
+		std::vector<float> directions = { 0,0,-1 };
+
+		// A single origin or direction can't be paired with an empty array
+		bool occlusion_result = false;
+		EXPECT_EQ(HF_STATUS::GENERIC_ERROR, CastOcclusionRays(rt, origins.data(), nullptr, 1, 0, -1, &occlusion_result));
+		EXPECT_EQ(HF_STATUS::GENERIC_ERROR, CastOcclusionRays(rt, nullptr, directions.data(), 0, 1, -1, &occlusion_result));
+
+		std::vector<RayResult>* results = nullptr;
+		RayResult* results_data = nullptr;
+		EXPECT_EQ(HF_STATUS::GENERIC_ERROR, CastRaysDistance(rt, origins.data(), 1, nullptr, 0, &results, &results_data));
+		EXPECT_EQ(HF_STATUS::GENERIC_ERROR, CastRaysDistance(rt, nullptr, 0, directions.data(), 1, &results, &results_data));
+		EXPECT_EQ(nullptr, results);
+
+		DestroyRayTracer(rt);
+	}
+
 	TEST(C_EmbreeRayTracer, ConstructionWithMultipleMeshes) {
 
 		// Load meshes
@@ -1129,6 +1763,68 @@ namespace C_Interface{
 		DestroyRayTracer(ERT);
 	}
 
+	TEST(C_EmbreeRayTracer, ConstructionWithInstancedMeshes) {
+
+		// Load meshes
+		HF::Geometry::MeshInfo<float>** MI;
+		int num_meshes = 0;
+		auto OBJs = LoadOBJ("sponza.obj", GROUP_METHOD::BY_GROUP, 0, 0, 0, &MI, &num_meshes);
+
+		// Create one raytracer with repeated meshes instanced, and one without
+		EmbreeRayTracer* instanced;
+		EmbreeRayTracer* copied;
+		ASSERT_EQ(HF_STATUS::OK, CreateRaytracerInstanced(MI, num_meshes, &instanced, false));
+		ASSERT_EQ(HF_STATUS::OK, CreateRaytracerMultiMesh(MI, num_meshes, &copied, false));
+
+		// Rays should hit the same meshes at the same distances in both
+		const std::array<float, 3> down{ 0, 0, -1 };
+		for (float x = -10; x <= 10; x += 2.5f) {
+			const std::array<float, 3> origin{ x, 0, 1 };
+			const auto instanced_hit = instanced->Intersect<float>(origin, down);
+			const auto copied_hit = copied->Intersect<float>(origin, down);
+			EXPECT_EQ(copied_hit.meshid, instanced_hit.meshid);
+			EXPECT_NEAR(copied_hit.distance, instanced_hit.distance, 0.0001f);
+		}
+
+		for (int i = 0; i < num_meshes; i++)
+			DestroyMeshInfo(MI[i]);
+
+		DestroyRayTracer(instanced);
+		DestroyRayTracer(copied);
+	}
+
+	TEST(C_EmbreeRayTracer, CastMultiHitRay) {
+		// Add a wall along the x axis, standing on the first plane
+		EmbreeRayTracer* rt = ConstructTestRaytracer();
+		auto wall = ConstructExamplePlane();
+		wall->PerformRotation(-90, 0, 0);
+		ASSERT_EQ(HF_STATUS::OK, AddMesh(rt, wall));
+
+		// Cast a ray down and back, through the floor and then the wall below it
+		const std::array<float, 3> origin{ 1, 2, 1 };
+		const std::array<float, 3> direction{ 0, -1, -1 };
+		std::array<float, 4> distances;
+		std::array<int, 4> mesh_ids, prim_ids;
+		int num_hits = -1;
+
+		// Both meshes are hit in one call, nearest first
+		auto status = CastMultiHitRay(rt, origin.data(), direction.data(), 4, -1, -1, distances.data(), mesh_ids.data(), prim_ids.data(), &num_hits);
+		ASSERT_EQ(HF_STATUS::OK, status);
+		ASSERT_EQ(2, num_hits);
+		EXPECT_NEAR(1.0f, distances[0], 0.0001f);
+		EXPECT_NEAR(2.0f, distances[1], 0.0001f);
+		EXPECT_EQ(39, mesh_ids[0]);
+		EXPECT_EQ(wall->GetMeshID(), mesh_ids[1]);
+
+		// max_hits must be positive
+		status = CastMultiHitRay(rt, origin.data(), direction.data(), 0, -1, -1, distances.data(), mesh_ids.data(), prim_ids.data(), &num_hits);
+		EXPECT_EQ(HF_STATUS::GENERIC_ERROR, status);
+		EXPECT_EQ(0, num_hits);
+
+		DestroyMeshInfo(wall);
+		DestroyRayTracer(rt);
+	}
+
 	// This will crash if things are done improperly. 
 	TEST(C_EmbreeRayTracer, AdditionWithMultipleMeshes) {
 
@@ -246,6 +246,36 @@ def c_calculate_distance_and_predecessor(
     return (dist_vector, dist_data, pred_vector, pred_data)
 
 
+def c_build_path_hierarchy(
+    graph_ptr: c_void_p, cluster_size: float, cost_type: str
+    ) -> None:
+    """ Build a path hierarchy for a graph in C++, and store it in the graph
+
+    Args:
+        graph_ptr : Graph to build the hierarchy for
+        cluster_size : Length of the sides of each cluster. 0 removes the hierarchy.
+        cost_type : Type of cost to build the hierarchy for. Default if left blank.
+
+    Raises:
+        KeyError : cost_type wasn't left blank, and didn't already exist in the
+                   graph.
+        OutOfRangeException : cluster_size was negative.
+    """
+
+    res = HFPython.BuildPathHierarchy(
+        graph_ptr, c_float(cluster_size), GetStringPtr(cost_type)
+    )
+
+    if res == HF_STATUS.NO_COST:
+        raise KeyError(f"Cost Type {cost_type} was not the key to cost in the graph")
+    elif res == HF_STATUS.OUT_OF_RANGE:
+        raise OutOfRangeException
+
+    # If this isn't OK, then something changed in C++ and it wasn't reflected
+    # here.
+    assert(res == HF_STATUS.OK)
+
+
 
 def C_DestroyPath(path_ptr: c_void_p) -> None:
     """ Delete a path in C++"""
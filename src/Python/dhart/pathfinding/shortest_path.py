@@ -10,7 +10,7 @@ from dhart.native_collections import FloatArray2D, IntArray2D
 
 __all__ = ["ConvertNodesToIds", "DijkstraShortestPath", 
            "DijkstraFindAllShortestPaths", "calculate_distance_and_predecessor",
-           "AllShortestPathsCSR", "get_path_from_csr"]
+           "AllShortestPathsCSR", "get_path_from_csr", "EnablePathHierarchy"]
 
 
 def ConvertNodesToIds(graph: Graph, nodes: List[Union[Tuple, int]]) -> List[int]:
@@ -431,6 +431,45 @@ def calculate_distance_and_predecessor(graph: Graph, cost_type: str = ""
     return (dist_matrix, pred_matrix)
 
 
+def EnablePathHierarchy(graph: Graph, cluster_size: float, cost_type: str = "") -> None:
+    """ Plan every later path on a graph through a hierarchy of clusters
+
+    Builds an abstract graph over cubic clusters of the graph and stores it in
+    the graph. DijkstraShortestPath and DijkstraFindAllShortestPaths then plan
+    paths on it, which is much faster for long paths on large graphs, but the
+    paths found may cost slightly more than the shortest path. The hierarchy is
+    discarded as soon as any edge or cost of the graph changes.
+
+    Args:
+        graph : Graph to build the hierarchy for. Must be compressed.
+        cluster_size : Length of the sides of the cube each cluster covers. Set
+                       to 0 to remove the hierarchy and search the whole graph again.
+        cost_type : Type of cost to build the hierarchy for. Uses the graph's
+                    default cost type if left blank.
+
+    Raises:
+        KeyError : cost_type wasn't left blank, and didn't already exist in the
+                   graph.
+        OutOfRangeException : cluster_size was negative.
+
+    Examples:
+        >>> from dhart.pathfinding import DijkstraShortestPath, EnablePathHierarchy
+        >>> from dhart.spatialstructures import Graph
+
+        >>> g = Graph()
+        >>> for x in range(20):
+        ...     g.AddEdgeToGraph((x, 0, 0), (x + 1, 0, 0), 1)
+        >>> csr = g.CompressToCSR()
+        >>> # Paths from here on are planned through clusters 5 units wide
+        >>> EnablePathHierarchy(g, 5)
+        >>> path = DijkstraShortestPath(g, 0, 20)
+
+    """
+    pathfinder_native_functions.c_build_path_hierarchy(
+        graph.graph_ptr, cluster_size, cost_type
+    )
+
+
 def AllShortestPathsCSR(
     graph: Graph,
     cost_type: str = "",
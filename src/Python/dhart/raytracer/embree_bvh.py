@@ -17,12 +17,14 @@ class EmbreeBVH(object):
 
     pointer: Union[None, c_void_p] = None  # Pointer to the underlying c-object
 
-    def __init__(self, geometry: MeshInfo, use_precise : bool = False):
+    def __init__(self, geometry: MeshInfo, use_precise : bool = False, use_instancing : bool = False):
         """ Create a new BVH from an existing mesh 
 
         Args:
             geometry: The mesh or meshes to create the BVH from. 
             use_precise : Use a more precise, but slower ray intersection function
+            use_instancing : If geometry is a list, meshes that only differ by a translation,
+                such as repeated groups of an OBJ, share their triangles instead of being copied.
         
         Example:
             Creating a BVH from a plane object
@@ -40,7 +42,7 @@ class EmbreeBVH(object):
         else:
             pointers = geometry._MeshInfo__internal_ptr
         self.pointer = raytracer_native_functions.CreateRayTracer(
-            pointers, use_precise
+            pointers, use_precise, use_instancing
         )
 
     def AddMesh(self, mesh : Union[MeshInfo, List[MeshInfo]]):
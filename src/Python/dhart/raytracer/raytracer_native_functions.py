@@ -9,12 +9,18 @@ from typing import *
 HFPython = getDLLHandle()
 
 
-def CreateRayTracer(mesh_info_ptr: Union[c_void_p, List[c_void_p]], use_precise: bool) -> c_void_p:
+def CreateRayTracer(
+    mesh_info_ptr: Union[c_void_p, List[c_void_p]],
+    use_precise: bool,
+    use_instancing: bool = False,
+) -> c_void_p:
     """ Create a raytracer from a pointer to valid meshinfo previously created by CreateOBJ
 
     Args:
         mesh_info_ptr (Union[c_void_p, List[c_void_p]]): One or more pointers to MeshInfo objects to construct the BVH fromn
         use_precise (bool): Use a slower but more accurate ray intersection method where applicable
+        use_instancing (bool): If mesh_info_ptr is a list, share the geometry of meshes that are
+            moved copies of each other
 
     Raises:
         MissingDependencyException: Embree.dll or tbb.dll could not be loaded.
@@ -37,10 +43,15 @@ def CreateRayTracer(mesh_info_ptr: Union[c_void_p, List[c_void_p]], use_precise:
         for i in range(0, num_ptrs):
             meshinfo_ptrs[i] = mesh_info_ptr[i]
 
-        # Create the raytracer
-        error_code = HFPython.CreateRaytracerMultiMesh(
-            meshinfo_ptrs, num_ptrs, byref(rt_ptr)
-        )
+        # Create the raytracer, adding repeated meshes as instances if requested
+        if use_instancing:
+            error_code = HFPython.CreateRaytracerInstanced(
+                meshinfo_ptrs, num_ptrs, byref(rt_ptr), use_precise
+            )
+        else:
+            error_code = HFPython.CreateRaytracerMultiMesh(
+                meshinfo_ptrs, num_ptrs, byref(rt_ptr)
+            )
 
     if error_code == HF_STATUS.MISSING_DEPEND:
         raise MissingDependencyException